@@ -0,0 +1,105 @@
+/* Copyright 2026 Mat Booth
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "boomerang-convert.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define ITERATIONS 10
+
+static const struct
+{
+  BoomerangPixelFormat format;
+  const char *name;
+  int bytes_per_pixel;
+} formats[] = {
+  { BOOMERANG_PIXEL_FORMAT_RGB8, "rgb8", 3 },     { BOOMERANG_PIXEL_FORMAT_RGBA8, "rgba8", 4 },
+  { BOOMERANG_PIXEL_FORMAT_BGRX8, "bgrx8", 4 },   { BOOMERANG_PIXEL_FORMAT_BGRA8, "bgra8", 4 },
+  { BOOMERANG_PIXEL_FORMAT_RGBA16, "rgba16", 8 },
+};
+
+static const BoomerangConvertKernel kernels[] = {
+  BOOMERANG_CONVERT_KERNEL_SCALAR,
+  BOOMERANG_CONVERT_KERNEL_SSSE3,
+  BOOMERANG_CONVERT_KERNEL_AVX2,
+  BOOMERANG_CONVERT_KERNEL_NEON,
+};
+
+/* returns the fastest of several runs in microseconds, converting on one thread or on all of them */
+static gint64
+time_convert (BoomerangPixelFormat format, const guint8 *src, gsize src_stride, guint8 *dest, int width, int height,
+              gboolean parallel)
+{
+  gint64 best = G_MAXINT64;
+  for (int i = 0; i < ITERATIONS; i++)
+    {
+      gint64 start = g_get_monotonic_time ();
+      if (parallel)
+        boomerang_convert (format, src, src_stride, dest, (gsize)width * 4, width, height);
+      else
+        boomerang_convert_rows (format, src, src_stride, dest, (gsize)width * 4, width, height);
+      best = MIN (best, g_get_monotonic_time () - start);
+    }
+  return best;
+}
+
+int
+main (int argc, char *argv[])
+{
+  int width = argc > 1 ? atoi (argv[1]) : 3840;
+  int height = argc > 2 ? atoi (argv[2]) : 2160;
+  if (width <= 0 || height <= 0)
+    {
+      g_printerr ("Usage: %s [WIDTH HEIGHT]\n", argv[0]);
+      return 1;
+    }
+
+  guint8 *dest = g_malloc ((gsize)width * height * 4);
+  double pixels = (double)width * height;
+
+  g_print ("%dx%d on %u threads, default kernel %s\n", width, height, g_get_num_processors (),
+           boomerang_convert_kernel_name (boomerang_convert_get_kernel ()));
+  g_print ("%-8s %-8s %12s %12s\n", "kernel", "format", "1 thread", "all threads");
+
+  for (guint f = 0; f < G_N_ELEMENTS (formats); f++)
+    {
+      /* rows are padded as a pixbuf would pad them, so that the stride handling is exercised too */
+      gsize stride = ((gsize)width * formats[f].bytes_per_pixel + 3) & ~(gsize)3;
+      guint8 *src = g_malloc (stride * height);
+      for (gsize i = 0; i < stride * height; i++)
+        src[i] = i * 7 + (i >> 11);
+
+      for (guint k = 0; k < G_N_ELEMENTS (kernels); k++)
+        {
+          if (!boomerang_convert_kernel_supported (kernels[k]))
+            continue;
+          boomerang_convert_set_kernel (kernels[k]);
+
+          gint64 single = time_convert (formats[f].format, src, stride, dest, width, height, FALSE);
+          gint64 parallel = time_convert (formats[f].format, src, stride, dest, width, height, TRUE);
+          g_print ("%-8s %-8s %7.2f ms %4.0f %7.2f ms %4.0f Mpx/s\n", boomerang_convert_kernel_name (kernels[k]),
+                   formats[f].name, single / 1000.0, pixels / single, parallel / 1000.0, pixels / parallel);
+        }
+
+      g_free (src);
+    }
+
+  g_free (dest);
+  return 0;
+}
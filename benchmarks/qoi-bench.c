@@ -0,0 +1,128 @@
+/* Copyright 2026 Mat Booth
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "boomerang-qoi.h"
+
+#include <stdlib.h>
+
+#define ITERATIONS 5
+
+/* paints something that compresses the way a desktop does, flat panels and gradients with some noisy text-like
+ * detail scattered over the top */
+static GdkPixbuf *
+create_screenshot (int width, int height)
+{
+  GdkPixbuf *pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, FALSE, 8, width, height);
+  int stride = gdk_pixbuf_get_rowstride (pixbuf);
+  guchar *pixels = gdk_pixbuf_get_pixels (pixbuf);
+  GRand *rand = g_rand_new_with_seed (42);
+
+  for (int y = 0; y < height; y++)
+    {
+      guchar *p = pixels + (gsize)y * stride;
+      for (int x = 0; x < width; x++, p += 3)
+        {
+          int panel = (x / 480 + y / 270) % 3;
+          if (panel == 0)
+            {
+              p[0] = p[1] = p[2] = 0xf6;
+            }
+          else if (panel == 1)
+            {
+              p[0] = x * 255 / width;
+              p[1] = y * 255 / height;
+              p[2] = 0x80;
+            }
+          else
+            {
+              p[0] = 0x24;
+              p[1] = 0x24;
+              p[2] = 0x2c;
+            }
+          if ((y % 24) < 14 && (x % 400) < 300 && g_rand_int_range (rand, 0, 4) == 0)
+            p[0] = p[1] = p[2] = g_rand_int_range (rand, 0, 256);
+        }
+    }
+
+  g_rand_free (rand);
+  return pixbuf;
+}
+
+static GdkPixbuf *
+decode_png (GBytes *bytes)
+{
+  GdkPixbufLoader *loader = gdk_pixbuf_loader_new_with_type ("png", NULL);
+  gdk_pixbuf_loader_write_bytes (loader, bytes, NULL);
+  gdk_pixbuf_loader_close (loader, NULL);
+  GdkPixbuf *pixbuf = g_object_ref (gdk_pixbuf_loader_get_pixbuf (loader));
+  g_object_unref (loader);
+  return pixbuf;
+}
+
+int
+main (int argc, char *argv[])
+{
+  int width = argc > 1 ? atoi (argv[1]) : 3840;
+  int height = argc > 2 ? atoi (argv[2]) : 2160;
+  if (width <= 0 || height <= 0)
+    {
+      g_printerr ("Usage: %s [WIDTH HEIGHT]\n", argv[0]);
+      return 1;
+    }
+
+  GdkPixbuf *pixbuf = create_screenshot (width, height);
+
+  gchar *png_data;
+  gsize png_size;
+  if (!gdk_pixbuf_save_to_buffer (pixbuf, &png_data, &png_size, "png", NULL, NULL))
+    {
+      g_printerr ("Error: Unable to encode PNG\n");
+      return 1;
+    }
+  GBytes *png = g_bytes_new_take (png_data, png_size);
+  GBytes *qoi = boomerang_qoi_encode (pixbuf);
+
+  gint64 png_best = G_MAXINT64;
+  gint64 qoi_best = G_MAXINT64;
+  for (int i = 0; i < ITERATIONS; i++)
+    {
+      gint64 start = g_get_monotonic_time ();
+      GdkPixbuf *decoded = decode_png (png);
+      png_best = MIN (png_best, g_get_monotonic_time () - start);
+      g_object_unref (decoded);
+
+      start = g_get_monotonic_time ();
+      decoded = boomerang_qoi_decode (qoi, NULL);
+      qoi_best = MIN (qoi_best, g_get_monotonic_time () - start);
+      if (!decoded)
+        {
+          g_printerr ("Error: Unable to decode QOI\n");
+          return 1;
+        }
+      g_object_unref (decoded);
+    }
+
+  g_print ("%dx%d on %u threads\n", width, height, g_get_num_processors ());
+  g_print ("png: %8.2f ms %10" G_GSIZE_FORMAT " bytes\n", png_best / 1000.0, g_bytes_get_size (png));
+  g_print ("qoi: %8.2f ms %10" G_GSIZE_FORMAT " bytes\n", qoi_best / 1000.0, g_bytes_get_size (qoi));
+
+  g_bytes_unref (qoi);
+  g_bytes_unref (png);
+  g_object_unref (pixbuf);
+  return 0;
+}
@@ -28,9 +28,17 @@ import * as PanelMenu from 'resource:///org/gnome/shell/ui/panelMenu.js';
 
 import * as Main from 'resource:///org/gnome/shell/ui/main.js';
 
-async function executeBoomerang(screenshot, callback, cancellable = null) {
+async function executeBoomerang(screenshot, monitor, callback, cancellable = null) {
+  const argv = ['boomerang', '-s', screenshot];
+  if (monitor) {
+    // Any point on the monitor identifies it, the centre is the least ambiguous
+    const x = monitor.x + Math.floor(monitor.width / 2);
+    const y = monitor.y + Math.floor(monitor.height / 2);
+    argv.push('--monitor', `${x},${y}`);
+  }
+
   const proc = new Gio.Subprocess({
-    argv: ['boomerang', "-s", screenshot],
+    argv: argv,
     flags: Gio.SubprocessFlags.NONE,
   });
 
@@ -69,9 +77,10 @@ async function executeBoomerang(screenshot, callback, cancellable = null) {
 
 const Indicator = GObject.registerClass(
   class Indicator extends PanelMenu.Button {
-    _init(iconUri) {
+    _init(iconUri, settings) {
       super._init(0.5, _('Boomerang'), true);
 
+      this._settings = settings;
       this._cancellable = null;
 
       const icon = new Gio.FileIcon({
@@ -111,11 +120,20 @@ const Indicator = GObject.registerClass(
         let [tempFile, stream] = Gio.File.new_tmp("boomerang-XXXXXX");
         this._filename = tempFile.get_path();
         const screenshot = new Shell.Screenshot();
-        await screenshot.screenshot(false, stream.get_output_stream());
+
+        // Capturing just the monitor under the pointer saves encoding, decoding and uploading the others
+        let monitor = null;
+        if (this._settings.get_boolean('capture-monitor')) {
+          monitor = global.display.get_monitor_geometry(global.display.get_current_monitor());
+          await screenshot.screenshot_area(monitor.x, monitor.y, monitor.width, monitor.height,
+            stream.get_output_stream());
+        } else {
+          await screenshot.screenshot(false, stream.get_output_stream());
+        }
         stream.close(null);
 
         this._cancellable = new Gio.Cancellable();
-        executeBoomerang(this._filename,
+        executeBoomerang(this._filename, monitor,
           () => {
             this._show_deactive();
             this._cancellable = null;
@@ -144,7 +162,7 @@ export default class BoomerangExtension extends Extension {
     this._settings = this.getSettings();
 
     const iconUri = '%s/icons/hicolor/scalable/boomerang-status-symbolic.svg'.format(this.metadata.dir.get_uri());
-    this._indicator = new Indicator(iconUri);
+    this._indicator = new Indicator(iconUri, this._settings);
     Main.panel.addToStatusArea(this.uuid, this._indicator);
 
     Main.wm.addKeybinding('activate-boomerang-key', this._settings,
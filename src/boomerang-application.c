@@ -21,24 +21,68 @@
 
 #include "boomerang-application.h"
 #include "boomerang-canvas.h"
+#include "boomerang-history.h"
+#include "boomerang-remote.h"
 #include "boomerang-screenshot.h"
+#include "boomerang-session.h"
+#include "boomerang-trace.h"
+
+#include <glib/gstdio.h>
+#include <stdio.h>
 
 struct _BoomerangApplication
 {
   GtkApplication parent_instance;
 
   BoomerangScreenshot *screenshot;
+  BoomerangRemote *remote;
 
   GtkWidget *window;
   GtkWidget *canvas;
 
   char *filename;
 
+  /* screenshots shown one at a time as a slide deck, when files or directories of them are opened */
+  char **slides;
+
+  char *renderer_name;
+  char *monitor_name;
+  char *record_path;
+  char *replay_path;
+
+  /* screenshots are only kept in the history when asked, since they may show anything that was on the screen */
+  gboolean keep_history;
+
+  /* exits once the first frame has been drawn, so that the test suite can measure how long it takes to get there */
+  gboolean quit_after_first_frame;
+
+  /* input recorded from the canvas, or being replayed into it from a temporary copy of the recorded screenshot */
+  BoomerangSession *session;
+  char *replay_screenshot;
+
+  /* the monitor to show, given as a point on it, and the bounds of the whole desktop it is part of */
+  gboolean has_monitor_point;
+  int monitor_point[2];
+  GdkMonitor *monitor;
+  GdkRectangle desktop;
+
+  BoomerangRenderer renderer;
+
+  /* most memory in megabytes that the screenshot textures should take up, or zero for no limit */
+  int memory_budget;
+
+  gboolean capturing;
+  gboolean from_file;
+  gboolean cropped;
+
   int status;
 };
 
 G_DEFINE_FINAL_TYPE (BoomerangApplication, boomerang_application, GTK_TYPE_APPLICATION)
 
+/* time in milliseconds to allow the compositor to stop showing our window before taking a new screenshot */
+#define RECAPTURE_DELAY 150
+
 static void
 application_quit_action (GSimpleAction *action, GVariant *parameter, gpointer data)
 {
@@ -47,25 +91,172 @@ application_quit_action (GSimpleAction *action, GVariant *parameter, gpointer da
   g_application_quit (G_APPLICATION (self));
 }
 
+static void
+application_refresh_action (GSimpleAction *action, GVariant *parameter, gpointer data)
+{
+  BoomerangApplication *self = data;
+  g_assert (BOOMERANG_IS_APPLICATION (self));
+  boomerang_application_capture (self);
+}
+
 static const GActionEntry app_actions[] = {
   { "quit", application_quit_action },
+  { "refresh", application_refresh_action },
 };
 
+static void
+boomerang_application_find_monitor (BoomerangApplication *app)
+{
+  /* monitor geometry is in the same logical desktop coordinates that gnome shell uses */
+  GListModel *monitors = gdk_display_get_monitors (gdk_display_get_default ());
+  app->desktop = (GdkRectangle){ 0 };
+  for (guint i = 0; i < g_list_model_get_n_items (monitors); i++)
+    {
+      g_autoptr (GdkMonitor) monitor = g_list_model_get_item (monitors, i);
+      GdkRectangle geometry;
+      gdk_monitor_get_geometry (monitor, &geometry);
+      if (i == 0)
+        app->desktop = geometry;
+      else
+        gdk_rectangle_union (&app->desktop, &geometry, &app->desktop);
+      if (!app->monitor && gdk_rectangle_contains_point (&geometry, app->monitor_point[0], app->monitor_point[1]))
+        app->monitor = g_object_ref (monitor);
+    }
+
+  if (!app->monitor)
+    g_printerr ("Error: No monitor at %d,%d, showing the whole desktop\n", app->monitor_point[0],
+                app->monitor_point[1]);
+}
+
+static void
+boomerang_application_load_screenshot (BoomerangApplication *app)
+{
+  /* screenshots of the whole desktop are cropped to the monitor we are showing, files are expected to be of just that
+   * monitor already, as they are when they come from the shell extension */
+  GdkRectangle geometry;
+  if (app->monitor && !app->cropped && !app->from_file)
+    {
+      gdk_monitor_get_geometry (app->monitor, &geometry);
+      boomerang_canvas_set_crop (BOOMERANG_CANVAS (app->canvas), &geometry, &app->desktop);
+    }
+  else
+    {
+      boomerang_canvas_set_crop (BOOMERANG_CANVAS (app->canvas), NULL, NULL);
+    }
+
+  /* screenshots loaded from files are already kept wherever they came from */
+  boomerang_canvas_set_history (BOOMERANG_CANVAS (app->canvas), app->keep_history && !app->from_file);
+  if (app->slides)
+    boomerang_canvas_set_slides (BOOMERANG_CANVAS (app->canvas), (const char *const *)app->slides);
+  else
+    boomerang_canvas_set_filename (BOOMERANG_CANVAS (app->canvas), app->filename);
+}
+
+static void
+boomerang_application_replay_cb (GObject *source, GAsyncResult *result, gpointer data)
+{
+  BoomerangApplication *app = BOOMERANG_APPLICATION (data);
+
+  GError *error = NULL;
+  if (boomerang_canvas_replay_finish (BOOMERANG_CANVAS (source), result, &error))
+    {
+      g_autofree char *report_path = g_strconcat (app->replay_path, ".csv", NULL);
+      if (!boomerang_session_save_report (app->session, report_path, &error))
+        {
+          g_printerr ("Error: Unable to save frame timings: %s\n", error->message);
+          g_error_free (error);
+          app->status = 1;
+        }
+    }
+  else
+    {
+      g_printerr ("Error: %s\n", error->message);
+      g_error_free (error);
+      app->status = 1;
+    }
+
+  /* replays are run from scripts and profilers, so there is nothing left to do once the report is written */
+  g_application_quit (G_APPLICATION (app));
+}
+
+static void
+boomerang_application_start_session (BoomerangApplication *app)
+{
+  if (app->replay_path)
+    {
+      boomerang_canvas_replay_async (BOOMERANG_CANVAS (app->canvas), app->session, NULL,
+                                     boomerang_application_replay_cb, app);
+      return;
+    }
+
+  /* the recording keeps its own copy of the screenshot so that it can be replayed on another machine */
+  GError *error = NULL;
+  char *contents;
+  gsize length;
+  if (!g_file_get_contents (app->filename, &contents, &length, &error))
+    {
+      g_printerr ("Error: Unable to record session: %s\n", error->message);
+      g_error_free (error);
+      return;
+    }
+  g_autoptr (GBytes) screenshot = g_bytes_new_take (contents, length);
+  app->session = boomerang_session_new (screenshot);
+  boomerang_canvas_record (BOOMERANG_CANVAS (app->canvas), app->session);
+}
+
+static void
+boomerang_application_after_paint_cb (GdkFrameClock *frame_clock, gpointer data)
+{
+  BoomerangApplication *app = BOOMERANG_APPLICATION (data);
+
+  /* the first frame painted once the canvas is mapped is the first one with the screenshot in it */
+  if (!gtk_widget_get_mapped (app->canvas))
+    return;
+
+  g_signal_handlers_disconnect_by_func (frame_clock, boomerang_application_after_paint_cb, app);
+  g_application_quit (G_APPLICATION (app));
+}
+
+static void
+boomerang_application_canvas_realize_cb (GtkWidget *canvas, gpointer data)
+{
+  g_signal_connect (gtk_widget_get_frame_clock (canvas), "after-paint",
+                    G_CALLBACK (boomerang_application_after_paint_cb), data);
+}
+
 static void
 boomerang_application_create_canvas (BoomerangApplication *app)
 {
-  g_print ("Loading screenshot: %s\n", app->filename);
+  if (app->slides)
+    g_print ("Loading slides: %u screenshots\n", g_strv_length (app->slides));
+  else
+    g_print ("Loading screenshot: %s\n", app->filename);
 
   app->window = gtk_application_window_new (GTK_APPLICATION (app));
   gtk_window_set_title (GTK_WINDOW (app->window), _ ("Boomerang"));
-  gtk_window_fullscreen (GTK_WINDOW (app->window));
+
+  /* replays happen in a window the same size as the one that was recorded, so that pointer positions match */
+  int width, height;
+  if (app->replay_path && boomerang_session_get_size (app->session, &width, &height))
+    gtk_window_set_default_size (GTK_WINDOW (app->window), width, height);
+  else if (app->monitor)
+    gtk_window_fullscreen_on_monitor (GTK_WINDOW (app->window), app->monitor);
+  else
+    gtk_window_fullscreen (GTK_WINDOW (app->window));
 
   app->canvas = g_object_new (BOOMERANG_TYPE_CANVAS, NULL);
+  boomerang_canvas_set_renderer (BOOMERANG_CANVAS (app->canvas), app->renderer);
+  boomerang_canvas_set_memory_budget (BOOMERANG_CANVAS (app->canvas), (gsize)app->memory_budget * 1024 * 1024);
   gtk_widget_set_focusable (app->canvas, TRUE);
   gtk_widget_set_hexpand (app->canvas, TRUE);
   gtk_widget_set_vexpand (app->canvas, TRUE);
+  if (app->quit_after_first_frame)
+    g_signal_connect (app->canvas, "realize", G_CALLBACK (boomerang_application_canvas_realize_cb), app);
   gtk_window_set_child (GTK_WINDOW (app->window), app->canvas);
-  boomerang_canvas_set_filename (BOOMERANG_CANVAS (app->canvas), app->filename);
+  boomerang_application_load_screenshot (app);
+
+  if (app->record_path || app->replay_path)
+    boomerang_application_start_session (app);
 
   gtk_window_present (GTK_WINDOW (app->window));
 }
@@ -75,58 +266,392 @@ boomerang_application_screenshot_cb (GObject *source, GAsyncResult *result, gpoi
 {
   BoomerangApplication *app = BOOMERANG_APPLICATION (data);
 
+  app->capturing = FALSE;
+
   GError *error = NULL;
-  char *screenshot_uri = boomerang_screenshot_finish (BOOMERANG_SCREENSHOT (source), result, &error);
+  char *screenshot_uri = boomerang_screenshot_finish (BOOMERANG_SCREENSHOT (source), result, &app->cropped, &error);
+  char *filename = NULL;
 
   if (screenshot_uri)
     {
-      app->filename = g_filename_from_uri (screenshot_uri, NULL, NULL);
-      if (!app->filename)
+      filename = g_filename_from_uri (screenshot_uri, NULL, NULL);
+      if (!filename)
         {
           g_printerr ("Error: Unable to parse URI %s\n", screenshot_uri);
-          app->status = 1;
         }
       g_free (screenshot_uri);
     }
   else
     {
       g_printerr ("Error: %s\n", error->message);
-      app->status = 1;
+      g_error_free (error);
     }
 
-  if (app->filename)
-    boomerang_application_create_canvas (app);
+  if (app->window)
+    {
+      /* a failure to replace the screenshot is not fatal while we still have the old one to show */
+      if (filename)
+        {
+          g_free (app->filename);
+          app->filename = filename;
+          boomerang_application_load_screenshot (app);
+        }
+      gtk_window_present (GTK_WINDOW (app->window));
+    }
+  else if (filename)
+    {
+      g_free (app->filename);
+      app->filename = filename;
+      boomerang_application_create_canvas (app);
+    }
+  else
+    {
+      app->status = 1;
+    }
 
   /* releasing now that the window is shown, if we didn't present a window due to something going wrong with the
    * screenshotting process, then the application will exit */
   g_application_release (G_APPLICATION (app));
 }
 
+static void
+boomerang_application_take_screenshot (BoomerangApplication *app)
+{
+  /* hold the application until we hear back from the screenshot service to avoid showing the window without
+   * anything to render */
+  g_application_hold (G_APPLICATION (app));
+  app->capturing = TRUE;
+  if (!app->screenshot)
+    {
+      app->screenshot = g_object_new (BOOMERANG_TYPE_SCREENSHOT, NULL);
+      boomerang_screenshot_set_source (app->screenshot, app->filename);
+      app->from_file = app->filename != NULL;
+      if (app->has_monitor_point)
+        {
+          boomerang_application_find_monitor (app);
+          if (app->monitor)
+            {
+              GdkRectangle geometry;
+              gdk_monitor_get_geometry (app->monitor, &geometry);
+              boomerang_screenshot_set_area (app->screenshot, &geometry);
+            }
+        }
+    }
+  boomerang_screenshot_take (app->screenshot, NULL, boomerang_application_screenshot_cb, app);
+}
+
+static gboolean
+boomerang_application_recapture_cb (gpointer data)
+{
+  BoomerangApplication *app = BOOMERANG_APPLICATION (data);
+  boomerang_application_take_screenshot (app);
+  g_application_release (G_APPLICATION (app));
+  return G_SOURCE_REMOVE;
+}
+
 static void
 boomerang_application_activate (GApplication *application)
 {
   BoomerangApplication *app = BOOMERANG_APPLICATION (application);
 
+  gint64 trace_time = boomerang_trace_begin ();
+
   if (app->window)
     {
       gtk_window_present (GTK_WINDOW (app->window));
+      boomerang_trace_end (trace_time, "Activate", "Presenting existing window");
       return;
     }
 
-  /* if a filename was not passed on the command line, take a screenshot using the freedesktop portal service,
-   * otherwise show the window immediately */
-  if (!app->filename)
+  /* if a filename was passed on the command line then the screenshot will come from that file, otherwise it will be
+   * captured using whichever way of taking screenshots works best on this system */
+  if (!app->capturing)
+    boomerang_application_take_screenshot (app);
+
+  boomerang_trace_end (trace_time, "Activate", NULL);
+}
+
+static int
+compare_filenames (gconstpointer a, gconstpointer b)
+{
+  g_autofree char *name_a = g_path_get_basename (*(const char *const *)a);
+  g_autofree char *name_b = g_path_get_basename (*(const char *const *)b);
+  g_autofree char *key_a = g_utf8_collate_key_for_filename (name_a, -1);
+  g_autofree char *key_b = g_utf8_collate_key_for_filename (name_b, -1);
+  return g_strcmp0 (key_a, key_b);
+}
+
+static gboolean
+is_image (GFileInfo *info)
+{
+  /* qoi is too new to be known to most shared mime databases, so it is recognised by its suffix */
+  const char *content_type = g_file_info_get_content_type (info);
+  g_autofree char *mime_type = content_type ? g_content_type_get_mime_type (content_type) : NULL;
+  if (mime_type && g_str_has_prefix (mime_type, "image/"))
+    return TRUE;
+  return g_str_has_suffix (g_file_info_get_name (info), ".qoi");
+}
+
+/* adds the images in a directory to the deck in the order a file manager would list them, ignoring anything else */
+static gboolean
+add_slide_directory (GPtrArray *slides, GFile *directory, GError **error)
+{
+  g_autoptr (GFileEnumerator) children
+      = g_file_enumerate_children (directory,
+                                   G_FILE_ATTRIBUTE_STANDARD_NAME "," G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE
+                                   "," G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN "," G_FILE_ATTRIBUTE_STANDARD_TYPE,
+                                   G_FILE_QUERY_INFO_NONE, NULL, error);
+  if (!children)
+    return FALSE;
+
+  g_autoptr (GPtrArray) images = g_ptr_array_new_with_free_func (g_free);
+  for (;;)
     {
-      /* hold the application until we hear back from the screenshot service to avoid showing the window without
-       * anything to render */
-      g_application_hold (G_APPLICATION (app));
-      app->screenshot = g_object_new (BOOMERANG_TYPE_SCREENSHOT, NULL);
-      boomerang_screenshot_take (app->screenshot, NULL, boomerang_application_screenshot_cb, app);
+      GFileInfo *info;
+      GFile *child;
+      if (!g_file_enumerator_iterate (children, &info, &child, NULL, error))
+        return FALSE;
+      if (!info)
+        break;
+
+      if (g_file_info_get_file_type (info) != G_FILE_TYPE_REGULAR || g_file_info_get_is_hidden (info)
+          || !is_image (info))
+        continue;
+
+      char *path = g_file_get_path (child);
+      if (path)
+        g_ptr_array_add (images, path);
+    }
+  g_ptr_array_sort (images, compare_filenames);
+
+  for (guint i = 0; i < images->len; i++)
+    g_ptr_array_add (slides, g_strdup (g_ptr_array_index (images, i)));
+  return TRUE;
+}
+
+/* returns the screenshots to show as slides, files being shown in the order given and directories expanded into the
+ * images they contain */
+static char **
+expand_slides (GFile **files, int n_files, GError **error)
+{
+  g_autoptr (GPtrArray) slides = g_ptr_array_new_with_free_func (g_free);
+  for (int i = 0; i < n_files; i++)
+    {
+      g_autofree char *path = g_file_get_path (files[i]);
+      if (!path)
+        {
+          g_autofree char *uri = g_file_get_uri (files[i]);
+          g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED, "%s is not a local file", uri);
+          return NULL;
+        }
+
+      if (g_file_query_file_type (files[i], G_FILE_QUERY_INFO_NONE, NULL) != G_FILE_TYPE_DIRECTORY)
+        g_ptr_array_add (slides, g_steal_pointer (&path));
+      else if (!add_slide_directory (slides, files[i], error))
+        return NULL;
+    }
+
+  if (slides->len == 0)
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND, "No images were found");
+      return NULL;
+    }
+
+  g_ptr_array_add (slides, NULL);
+  return (char **)g_ptr_array_free (g_steal_pointer (&slides), FALSE);
+}
+
+static void
+boomerang_application_open (GApplication *application, GFile **files, int n_files, const char *hint)
+{
+  BoomerangApplication *app = BOOMERANG_APPLICATION (application);
+
+  gint64 trace_time = boomerang_trace_begin ();
+
+  if (app->record_path || app->replay_path)
+    {
+      g_printerr ("Error: Slides cannot be recorded or replayed\n");
+      boomerang_trace_end (trace_time, "Open", "Error: Slides cannot be recorded or replayed");
+      app->status = 1;
+      return;
+    }
+  if (app->filename)
+    {
+      g_printerr ("Error: Cannot show slides and a screenshot at the same time\n");
+      boomerang_trace_end (trace_time, "Open", "Error: Cannot show slides and a screenshot at the same time");
+      app->status = 1;
+      return;
+    }
+
+  GError *error = NULL;
+  char **slides = expand_slides (files, n_files, &error);
+  if (!slides)
+    {
+      g_printerr ("Error: Unable to open slides: %s\n", error->message);
+      boomerang_trace_end (trace_time, "Open", "Error: %s", error->message);
+      g_error_free (error);
+      app->status = 1;
+      return;
+    }
+  g_strfreev (app->slides);
+  app->slides = slides;
+
+  /* slides are expected to be of a single monitor already, so they are shown whole on the one given */
+  app->from_file = TRUE;
+  if (app->window)
+    {
+      boomerang_application_load_screenshot (app);
+      gtk_window_present (GTK_WINDOW (app->window));
     }
   else
     {
+      if (app->has_monitor_point && !app->monitor)
+        boomerang_application_find_monitor (app);
       boomerang_application_create_canvas (app);
     }
+
+  boomerang_trace_end (trace_time, "Open", "%u slides", g_strv_length (app->slides));
+}
+
+static gboolean
+boomerang_application_dbus_register (GApplication *application, GDBusConnection *connection,
+                                     const char *object_path, GError **error)
+{
+  BoomerangApplication *app = BOOMERANG_APPLICATION (application);
+
+  if (!G_APPLICATION_CLASS (boomerang_application_parent_class)
+           ->dbus_register (application, connection, object_path, error))
+    return FALSE;
+
+  /* export the remote control interface alongside the standard application interfaces */
+  app->remote = boomerang_remote_new (app);
+  return boomerang_remote_register (app->remote, connection, object_path, error);
+}
+
+static void
+boomerang_application_dbus_unregister (GApplication *application, GDBusConnection *connection,
+                                       const char *object_path)
+{
+  BoomerangApplication *app = BOOMERANG_APPLICATION (application);
+
+  if (app->remote)
+    {
+      boomerang_remote_unregister (app->remote);
+      g_clear_object (&app->remote);
+    }
+
+  G_APPLICATION_CLASS (boomerang_application_parent_class)->dbus_unregister (application, connection, object_path);
+}
+
+static int
+boomerang_application_handle_local_options (GApplication *application, GVariantDict *options)
+{
+  BoomerangApplication *app = BOOMERANG_APPLICATION (application);
+
+  if (app->renderer_name)
+    {
+      if (g_str_equal (app->renderer_name, "gl"))
+        app->renderer = BOOMERANG_RENDERER_GL;
+      else if (g_str_equal (app->renderer_name, "gsk"))
+        app->renderer = BOOMERANG_RENDERER_GSK;
+      else
+        {
+          g_printerr ("Error: Unknown renderer %s, expected gl or gsk\n", app->renderer_name);
+          return 1;
+        }
+    }
+
+  if (app->memory_budget < 0)
+    {
+      g_printerr ("Error: Invalid memory budget %d, expected a number of megabytes\n", app->memory_budget);
+      return 1;
+    }
+
+  if (app->record_path && app->replay_path)
+    {
+      g_printerr ("Error: Cannot record and replay a session at the same time\n");
+      return 1;
+    }
+
+  if (app->replay_path)
+    {
+      if (app->filename)
+        {
+          g_printerr ("Error: A replayed session always uses the screenshot it was recorded with\n");
+          return 1;
+        }
+
+      /* the recorded screenshot is written out so that it is loaded in exactly the same way it was originally */
+      GError *error = NULL;
+      app->session = boomerang_session_load (app->replay_path, &error);
+      GBytes *screenshot = app->session ? boomerang_session_get_screenshot (app->session) : NULL;
+      int fd = screenshot ? g_file_open_tmp ("boomerang-replay-XXXXXX", &app->replay_screenshot, &error) : -1;
+      if (fd < 0 || !g_file_set_contents (app->replay_screenshot, g_bytes_get_data (screenshot, NULL),
+                                          g_bytes_get_size (screenshot), &error))
+        {
+          g_printerr ("Error: Unable to replay session: %s\n", error->message);
+          g_error_free (error);
+          if (fd >= 0)
+            g_close (fd, NULL);
+          return 1;
+        }
+      g_close (fd, NULL);
+      app->filename = g_strdup (app->replay_screenshot);
+    }
+
+  if (app->monitor_name)
+    {
+      char end;
+      if (sscanf (app->monitor_name, "%d,%d%c", &app->monitor_point[0], &app->monitor_point[1], &end) != 2)
+        {
+          g_printerr ("Error: Invalid monitor position %s, expected X,Y\n", app->monitor_name);
+          return 1;
+        }
+      app->has_monitor_point = TRUE;
+    }
+
+  return G_APPLICATION_CLASS (boomerang_application_parent_class)->handle_local_options (application, options);
+}
+
+static void
+boomerang_application_shutdown (GApplication *application)
+{
+  BoomerangApplication *app = BOOMERANG_APPLICATION (application);
+
+  if (app->record_path && app->session)
+    {
+      GError *error = NULL;
+      if (boomerang_session_save (app->session, app->record_path, &error))
+        {
+          g_print ("Session recorded to %s\n", app->record_path);
+        }
+      else
+        {
+          g_printerr ("Error: Unable to save session: %s\n", error->message);
+          g_error_free (error);
+          app->status = 1;
+        }
+    }
+
+  if (app->replay_screenshot)
+    g_unlink (app->replay_screenshot);
+
+  /* the window is destroyed while there is still a display, so that the canvas is unrealized and lets go of what it
+   * uploaded, whichever renderer drew it */
+  if (app->window)
+    {
+      gtk_window_destroy (GTK_WINDOW (app->window));
+      app->window = NULL;
+      app->canvas = NULL;
+    }
+
+  /* the backends delete any temporary copies of the screenshot they made */
+  g_clear_object (&app->screenshot);
+
+  G_APPLICATION_CLASS (boomerang_application_parent_class)->shutdown (application);
+
+  /* the main loop has stopped, so the canvas no longer records to, or replays from, the session */
+  g_clear_pointer (&app->session, boomerang_session_free);
 }
 
 static void
@@ -134,6 +659,11 @@ boomerang_application_class_init (BoomerangApplicationClass *klass)
 {
   GApplicationClass *app_class = G_APPLICATION_CLASS (klass);
   app_class->activate = boomerang_application_activate;
+  app_class->open = boomerang_application_open;
+  app_class->shutdown = boomerang_application_shutdown;
+  app_class->handle_local_options = boomerang_application_handle_local_options;
+  app_class->dbus_register = boomerang_application_dbus_register;
+  app_class->dbus_unregister = boomerang_application_dbus_unregister;
 }
 
 static void
@@ -144,9 +674,27 @@ boomerang_application_init (BoomerangApplication *app)
   g_action_map_add_action_entries (G_ACTION_MAP (app), app_actions, G_N_ELEMENTS (app_actions), app);
   gtk_application_set_accels_for_action (GTK_APPLICATION (app), "app.quit",
                                          (const char *[]){ "<Control>q", "Escape", NULL });
+  gtk_application_set_accels_for_action (GTK_APPLICATION (app), "app.refresh", (const char *[]){ "r", "F5", NULL });
 
   GOptionEntry app_options[] = { { "screenshot", 's', G_OPTION_FLAG_NONE, G_OPTION_ARG_FILENAME, &app->filename,
-                                   _ ("Path to the screenshot file"), _ ("FILENAME") },
+                                   _ ("Path to the screenshot file, or - for standard input"), _ ("FILENAME") },
+                                 { "renderer", 0, G_OPTION_FLAG_NONE, G_OPTION_ARG_STRING, &app->renderer_name,
+                                   _ ("Draw with our own shaders or with GTK render nodes"), _ ("gl|gsk") },
+                                 { "memory-budget", 0, G_OPTION_FLAG_NONE, G_OPTION_ARG_INT, &app->memory_budget,
+                                   _ ("Store the screenshot in smaller formats to keep it within this much memory"),
+                                   _ ("MEGABYTES") },
+                                 { "history", 0, G_OPTION_FLAG_NONE, G_OPTION_ARG_NONE, &app->keep_history,
+                                   _ ("Keep the ten most recent screenshots in the cache directory"), NULL },
+                                 { "monitor", 'm', G_OPTION_FLAG_NONE, G_OPTION_ARG_STRING, &app->monitor_name,
+                                   _ ("Show only the monitor containing this point of the desktop"), _ ("X,Y") },
+                                 { "record", 0, G_OPTION_FLAG_NONE, G_OPTION_ARG_FILENAME, &app->record_path,
+                                   _ ("Record input and the screenshot to a session file"), _ ("FILENAME") },
+                                 { "replay", 0, G_OPTION_FLAG_NONE, G_OPTION_ARG_FILENAME, &app->replay_path,
+                                   _ ("Replay a recorded session and write frame timings next to it"),
+                                   _ ("FILENAME") },
+                                 { "quit-after-first-frame", 0, G_OPTION_FLAG_HIDDEN, G_OPTION_ARG_NONE,
+                                   &app->quit_after_first_frame, _ ("Exit once the screenshot has been shown"),
+                                   NULL },
                                  G_OPTION_ENTRY_NULL };
   g_application_add_main_option_entries (G_APPLICATION (app), app_options);
 }
@@ -157,11 +705,37 @@ boomerang_application_get_status (BoomerangApplication *app)
   return app->status;
 }
 
+GtkWidget *
+boomerang_application_get_canvas (BoomerangApplication *app)
+{
+  return app->canvas;
+}
+
+void
+boomerang_application_capture (BoomerangApplication *app)
+{
+  /* a slide deck only ever shows the screenshots it was opened with */
+  if (app->capturing || app->slides)
+    return;
+
+  if (!app->window)
+    {
+      boomerang_application_take_screenshot (app);
+      return;
+    }
+
+  /* hide our own window so that it does not appear in the new screenshot */
+  gtk_widget_set_visible (app->window, FALSE);
+  g_application_hold (G_APPLICATION (app));
+  app->capturing = TRUE;
+  g_timeout_add (RECAPTURE_DELAY, boomerang_application_recapture_cb, app);
+}
+
 BoomerangApplication *
 boomerang_application_new (void)
 {
   BoomerangApplication *app = g_object_new (BOOMERANG_TYPE_APPLICATION, "application-id", APPLICATION_ID, "flags",
-                                            G_APPLICATION_DEFAULT_FLAGS, NULL);
+                                            G_APPLICATION_DEFAULT_FLAGS | G_APPLICATION_HANDLES_OPEN, NULL);
 
 #if GLIB_CHECK_VERSION(2, 80, 0)
   char version[80];
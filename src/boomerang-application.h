@@ -29,6 +29,10 @@ G_DECLARE_FINAL_TYPE (BoomerangApplication, boomerang_application, BOOMERANG, AP
 
 int boomerang_application_get_status (BoomerangApplication *self);
 
+GtkWidget *boomerang_application_get_canvas (BoomerangApplication *self);
+
+void boomerang_application_capture (BoomerangApplication *self);
+
 BoomerangApplication *boomerang_application_new (void);
 
 G_END_DECLS
@@ -17,52 +17,256 @@
  */
 
 #include "boomerang-canvas.h"
+#include "boomerang-compress.h"
+#include "boomerang-convert.h"
+#include "boomerang-history.h"
+#include "boomerang-qoi.h"
+#include "boomerang-regions.h"
+#include "boomerang-session.h"
+#include "boomerang-trace.h"
 
 #include <epoxy/gl.h>
+#include <stdio.h>
+#include <unistd.h>
 
+/* values are kept in double precision, because at high zoom levels a pan of a single screen pixel is a small fraction
+ * of the total */
 typedef struct _Animatable Animatable;
 struct _Animatable
 {
   guint id;
-  GLfloat value;
-  GLfloat start;
-  GLfloat target;
+  double value;
+  double start;
+  double target;
+  double duration;
   double accum_seconds;
   int64_t last_time;
 };
 
+/* number of levels in the blur pyramid, each half the size of the one before, starting at half the size of the
+ * screenshot, more levels give a wider blur for very little extra cost */
+#define BLUR_LEVELS 4
+
 struct _BoomerangCanvas
 {
   GtkGLArea parent_instance;
 
   char *filename;
 
+  BoomerangRenderer renderer;
+
   int scale_factor;
 
   double drag_offset[2];
-  double drag_total[2];
 
   bool flashlight_zoom;
 
   GLuint program;
   GLuint texture;
+
+  /* copy of the pixels most recently uploaded to the texture, used to find what changed when recapturing and by the
+   * inspector */
+  GdkPixbuf *pixbuf;
+
+  /* with a memory budget, the textures are stored in the best format that fits in it, shown as rgb565 while a block
+   * compressed copy is encoded if it needs to be smaller still, and the pixels are only kept while the inspector is
+   * using them */
+  gsize memory_budget;
+  BoomerangTextureFormat texture_format;
+  BoomerangTextureFormat compress_format;
+  GCancellable *compress_cancellable;
+
+  /* set while the pixels let go of are decoded again in the background for the inspector */
+  GCancellable *pixels_cancellable;
+
   GLuint vao;
   GLuint vbo;
-
-  /* shader uniforms */
+  GLuint spotlight_ubo;
+
+  /* pyramid of successively smaller blurred copies of the screenshot, the first of which is drawn outside the
+   * spotlights, rebuilt by the next render whenever the screenshot changes */
+  GLuint blur_down_program;
+  GLuint blur_up_program;
+  GLuint blur_framebuffer;
+  GLuint blur_textures[BLUR_LEVELS];
+  int blur_size[BLUR_LEVELS][2];
+  gboolean blur_dirty;
+
+  /* screenshot texture used when rendering with gsk instead of our own shaders */
+  GdkTexture *gdk_texture;
+
+  int texture_size[2];
+
+  /* part of the desktop to show when the screenshot is of the whole desktop, in logical desktop coordinates */
+  GdkRectangle crop_area;
+  GdkRectangle crop_desktop;
+  gboolean crop_enabled;
+
+  /* whether the next screenshot loaded is added to the history, from the pixels already decoded for the texture */
+  gboolean history;
+
+  /* index of content regions in the screenshot, built in the background for snapping the zoom to a region */
+  GCancellable *cancellable;
+  BoomerangRegionIndex *regions;
+
+  /* slides of a deck, while one is shown its textures are held in the fields above and the others keep their own
+   * for as long as they stay in the cache */
+  GPtrArray *slides;
+  guint slide;
+  gboolean slide_shown;
+  guint64 slide_clock;
+
+  /* shader uniforms, the projection is combined with the zoom and drag into a single matrix before it is sent */
   GLint debugging;
-  GLfloat projection[16];
+  double projection[16];
   GLfloat resolution[2];
   GLfloat pointer[2];
   GLint flashlight_enabled;
+  GLint blur_enabled;
+  GLint lens_enabled;
+  GLint lens_shape;
+
+  gboolean inspector_enabled;
+
+  /* input is recorded to the session, or replayed from it on a virtual frame clock */
+  BoomerangSession *session;
+  gint64 record_start;
+  GTask *replay_task;
+  guint replay_id;
+  gboolean replay_started;
+  gint64 replay_time;
+  gint64 replay_end;
+  gint64 replay_frame_time;
+  gint64 replay_interval;
+  guint replay_next;
+  guint replay_events;
+
+  /* spotlights, the flashlight follows the pointer unless it was placed over a pixel of the screenshot by the remote
+   * control, and the pinned spotlights follow the screenshot */
+  int flashlight_shape;
+  gboolean flashlight_placed;
+  double flashlight_texel[2];
+  GArray *pins;
 
   /* animation state */
   Animatable flashlight_radius;
   Animatable zoom_level;
+  Animatable pan[2];
+  Animatable lens_zoom;
+  Animatable lens_radius;
 };
 
 G_DEFINE_FINAL_TYPE (BoomerangCanvas, boomerang_canvas, GTK_TYPE_GL_AREA)
 
+#define ZOOM_MIN 1.0
+#define ZOOM_MAX 64.0
+
+/* radius of the flashlight relative to the screen, before it is resized */
+#define FLASHLIGHT_RADIUS 0.3
+
+/* size in logical pixels at which pixels of the screenshot start to be outlined by the pixel grid, which is fully
+ * shown once they are twice this size */
+#define GRID_TEXEL_SIZE 8.0
+
+/* default length of animations in seconds */
+#define ANIMATION_DURATION 0.5
+
+/* length of a frame of the virtual clock used when replaying input */
+#define REPLAY_FRAME_TIME (G_USEC_PER_SEC / 60)
+
+/* magnification of the lens is relative to the zoom level of the main view */
+#define LENS_ZOOM_MIN 1.5
+#define LENS_ZOOM_MAX 16.0
+
+/* shapes the lens may take, must match the values expected by the fragment shader */
+enum
+{
+  LENS_SHAPE_CIRCLE,
+  LENS_SHAPE_ROUNDED_RECT,
+  LENS_SHAPE_COUNT
+};
+
+/* most spotlights that may be lit at once, including the flashlight, must match the limit in the fragment shader */
+#define MAX_SPOTLIGHTS 16
+
+/* shapes spotlights may take, must match the values expected by the fragment shader */
+enum
+{
+  SPOTLIGHT_SHAPE_CIRCLE,
+  SPOTLIGHT_SHAPE_ELLIPSE,
+  SPOTLIGHT_SHAPE_RECT,
+  SPOTLIGHT_SHAPE_ROUNDED_RECT,
+  SPOTLIGHT_SHAPE_COUNT
+};
+
+/* a spotlight pinned to a place on the screenshot, its radius is relative to the screenshot at a zoom level of one */
+typedef struct
+{
+  int shape;
+  double texel[2];
+  double radius;
+} PinnedSpotlight;
+
+/* layout of the spotlights uniform block in the fragment shader, according to the std140 packing rules */
+typedef struct
+{
+  GLfloat geometry[4];
+  GLfloat params[4];
+} SpotlightData;
+
+typedef struct
+{
+  GLint count;
+  GLint padding[3];
+  SpotlightData spotlight[MAX_SPOTLIGHTS];
+} SpotlightBlock;
+
+/* slides preloaded around the one shown, in the order they are wanted, which with the one shown are all that the
+ * cache holds however long the deck is */
+static const int slide_preload[] = { 1, 2, -1 };
+
+#define SLIDE_CACHE_SIZE (1 + G_N_ELEMENTS (slide_preload))
+
+/* a screenshot in a slide deck, with the view it was left at and its textures while it is cached */
+typedef struct
+{
+  char *filename;
+
+  double zoom_level;
+  double pan[2];
+  double flashlight_radius;
+  GLint flashlight_enabled;
+  int flashlight_shape;
+  gboolean flashlight_placed;
+  double flashlight_texel[2];
+  GArray *pins;
+
+  /* set from when decoding starts until the slide is let go of, cancelling any decoding or indexing in progress */
+  GCancellable *cancellable;
+  gboolean loading;
+  guint64 last_used;
+
+  GLuint texture;
+  GdkTexture *gdk_texture;
+  GdkPixbuf *pixbuf;
+  int texture_size[2];
+  BoomerangTextureFormat texture_format;
+  BoomerangRegionIndex *regions;
+} Slide;
+
+/* a slide decoded on a worker thread, and converted and compressed there into the format it is uploaded in */
+typedef struct
+{
+  char *filename;
+  gboolean convert;
+  gsize budget;
+  BoomerangTextureFormat compressed;
+
+  GdkPixbuf *pixbuf;
+  BoomerangTextureFormat format;
+  GBytes *pixels;
+} SlideImage;
+
 /* two triangles that cover the entire viewport, given here as (x,y,u,v) tuples */
 static const GLfloat geometry[] = {
   // clang-format off
@@ -112,9 +316,12 @@ create_shader (GLenum shader_type, const char *shader_path, GError **error)
 static GLuint
 create_program (const char *vertex_path, const char *fragment_path, GError **error)
 {
+  gint64 trace_time = boomerang_trace_begin ();
+
   GLuint vertex = create_shader (GL_VERTEX_SHADER, vertex_path, error);
   if (!vertex)
     {
+      boomerang_trace_end (trace_time, "Create program", "Error: %s", (*error)->message);
       return 0;
     }
 
@@ -122,6 +329,7 @@ create_program (const char *vertex_path, const char *fragment_path, GError **err
   if (!fragment)
     {
       glDeleteShader (vertex);
+      boomerang_trace_end (trace_time, "Create program", "Error: %s", (*error)->message);
       return 0;
     }
 
@@ -145,171 +353,1656 @@ create_program (const char *vertex_path, const char *fragment_path, GError **err
       glDeleteShader (vertex);
       glDeleteShader (fragment);
       glDeleteProgram (program);
+      boomerang_trace_end (trace_time, "Create program", "Error: %s", (*error)->message);
       return 0;
     }
 
   /* we can delete these now because the program will retain a reference to them until the program itself is deleted */
   glDeleteShader (vertex);
   glDeleteShader (fragment);
+
+  boomerang_trace_end (trace_time, "Create program", "%s, %s", vertex_path, fragment_path);
   return program;
 }
 
-static GLuint
-create_texture (const char *texture_path, GError **error)
+static BoomerangPixelFormat
+pixbuf_format (GdkPixbuf *pixbuf)
+{
+  return gdk_pixbuf_get_n_channels (pixbuf) == 4 ? BOOMERANG_PIXEL_FORMAT_RGBA8 : BOOMERANG_PIXEL_FORMAT_RGB8;
+}
+
+/* block compressed formats are only worth using where the driver can sample them without unpacking them into a
+ * bigger format first, so etc2 is used with gles, which requires it, and bc1 with desktop gl */
+static BoomerangTextureFormat
+compressed_format (void)
+{
+  if (!epoxy_is_desktop_gl ())
+    return epoxy_gl_version () >= 30 ? BOOMERANG_TEXTURE_FORMAT_ETC2 : BOOMERANG_TEXTURE_FORMAT_RGB565;
+  return epoxy_has_gl_extension ("GL_EXT_texture_compression_s3tc") ? BOOMERANG_TEXTURE_FORMAT_BC1
+                                                                    : BOOMERANG_TEXTURE_FORMAT_RGB565;
+}
+
+/* the blur pyramid is drawn into, so cannot be block compressed, but is made rgb565 along with the screenshot */
+static BoomerangTextureFormat
+blur_format (BoomerangTextureFormat format)
+{
+  return format == BOOMERANG_TEXTURE_FORMAT_RGBA8 ? BOOMERANG_TEXTURE_FORMAT_RGBA8 : BOOMERANG_TEXTURE_FORMAT_RGB565;
+}
+
+static GLenum
+compressed_internal_format (BoomerangTextureFormat format)
+{
+  return format == BOOMERANG_TEXTURE_FORMAT_ETC2 ? GL_COMPRESSED_RGB8_ETC2 : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+}
+
+static gsize
+texture_memory (BoomerangTextureFormat format, int width, int height)
+{
+  gsize size = boomerang_compress_get_size (format, width, height);
+  for (int i = 0; i < BLUR_LEVELS; i++)
+    size += boomerang_compress_get_size (blur_format (format), MAX (width >> (i + 1), 1), MAX (height >> (i + 1), 1));
+  return size;
+}
+
+static gsize
+canvas_texture_memory (BoomerangCanvas *canvas, BoomerangTextureFormat format)
+{
+  return texture_memory (format, canvas->texture_size[0], canvas->texture_size[1]);
+}
+
+/* rgb565 is preferred to the block compressed formats whenever it fits, since it keeps text much sharper */
+static BoomerangTextureFormat
+choose_format (gsize budget, BoomerangTextureFormat compressed, int width, int height)
+{
+  if (!budget || texture_memory (BOOMERANG_TEXTURE_FORMAT_RGBA8, width, height) <= budget)
+    return BOOMERANG_TEXTURE_FORMAT_RGBA8;
+  if (texture_memory (BOOMERANG_TEXTURE_FORMAT_RGB565, width, height) <= budget)
+    return BOOMERANG_TEXTURE_FORMAT_RGB565;
+  return compressed;
+}
+
+static BoomerangTextureFormat
+canvas_choose_format (BoomerangCanvas *canvas)
+{
+  return choose_format (canvas->memory_budget, compressed_format (), canvas->texture_size[0],
+                        canvas->texture_size[1]);
+}
+
+static gsize
+resident_memory (void)
 {
-  GdkPixbuf *pixbuf = gdk_pixbuf_new_from_file (texture_path, error);
-  if (pixbuf == NULL)
+  g_autofree char *statm = NULL;
+  unsigned long pages;
+  if (!g_file_get_contents ("/proc/self/statm", &statm, NULL, NULL) || sscanf (statm, "%*u %lu", &pages) != 1)
     return 0;
+  return (gsize)pages * sysconf (_SC_PAGESIZE);
+}
 
-  int width = gdk_pixbuf_get_width (pixbuf);
-  int height = gdk_pixbuf_get_height (pixbuf);
-  int channels = gdk_pixbuf_get_n_channels (pixbuf);
-  int format = (channels == 4 ? GL_RGBA : GL_RGB);
+/* logs how much memory the screenshot is taking up, which is shown when G_MESSAGES_DEBUG is set */
+static void
+canvas_report_memory (BoomerangCanvas *canvas)
+{
+  gsize textures = canvas->renderer == BOOMERANG_RENDERER_GSK
+                       ? boomerang_compress_get_size (BOOMERANG_TEXTURE_FORMAT_RGBA8, canvas->texture_size[0],
+                                                      canvas->texture_size[1])
+                       : canvas_texture_memory (canvas, canvas->texture_format);
+  gsize resident = resident_memory ();
+
+  g_autofree char *textures_size = g_format_size (textures);
+  g_autofree char *pixels_size = g_format_size (canvas->pixbuf ? gdk_pixbuf_get_byte_length (canvas->pixbuf) : 0);
+  g_autofree char *resident_size = resident ? g_format_size (resident) : g_strdup ("unknown");
+  g_debug ("Screenshot memory: %s of %s textures, %s of pixels, %s resident", textures_size,
+           boomerang_compress_format_name (canvas->texture_format), pixels_size, resident_size);
+
+  if (!canvas->slides)
+    return;
+
+  /* the slide being shown is counted above, its own fields are empty while it is */
+  guint cached = 0;
+  gsize slides = 0;
+  for (guint i = 0; i < canvas->slides->len; i++)
+    {
+      Slide *slide = g_ptr_array_index (canvas->slides, i);
+      if (!slide->texture && !slide->gdk_texture)
+        continue;
+      cached++;
+      slides += canvas->renderer == BOOMERANG_RENDERER_GSK
+                    ? boomerang_compress_get_size (BOOMERANG_TEXTURE_FORMAT_RGBA8, slide->texture_size[0],
+                                                   slide->texture_size[1])
+                    : texture_memory (slide->texture_format, slide->texture_size[0], slide->texture_size[1]);
+    }
+  g_autofree char *slides_size = g_format_size (slides);
+  g_debug ("Slide cache: %u other slides of %u, %s of textures", cached, canvas->slides->len, slides_size);
+}
+
+static void
+canvas_compress_cb (GObject *source, GAsyncResult *result, gpointer data)
+{
+  GError *error = NULL;
+  g_autoptr (GBytes) blocks = boomerang_compress_finish (result, &error);
+  if (!blocks)
+    {
+      /* the canvas may already be gone if compression was cancelled, otherwise it keeps the rgb565 texture */
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+          g_printerr ("Error: %s\n", error->message);
+          g_clear_object (&BOOMERANG_CANVAS (data)->compress_cancellable);
+        }
+      g_error_free (error);
+      return;
+    }
+
+  BoomerangCanvas *canvas = BOOMERANG_CANVAS (data);
+  g_clear_object (&canvas->compress_cancellable);
+
+  gtk_gl_area_make_current (GTK_GL_AREA (canvas));
+  if (gtk_gl_area_get_error (GTK_GL_AREA (canvas)))
+    return;
+
+  gint64 trace_time = boomerang_trace_begin ();
+
+  /* replaces the rgb565 texture in place, the blurred copies made from it are close enough to keep */
+  glActiveTexture (GL_TEXTURE0);
+  glBindTexture (GL_TEXTURE_2D, canvas->texture);
+  glCompressedTexImage2D (GL_TEXTURE_2D, 0, compressed_internal_format (canvas->compress_format),
+                          canvas->texture_size[0], canvas->texture_size[1], 0, g_bytes_get_size (blocks),
+                          g_bytes_get_data (blocks, NULL));
+  canvas->texture_format = canvas->compress_format;
+
+  boomerang_trace_end (trace_time, "Upload", "%dx%d, %s", canvas->texture_size[0], canvas->texture_size[1],
+                       boomerang_compress_format_name (canvas->texture_format));
+
+  canvas_report_memory (canvas);
+  gtk_gl_area_queue_render (GTK_GL_AREA (canvas));
+}
+
+static void
+canvas_cancel_compress (BoomerangCanvas *canvas)
+{
+  g_cancellable_cancel (canvas->compress_cancellable);
+  g_clear_object (&canvas->compress_cancellable);
+}
 
+/* uploads tightly packed pixels that are already in the given format to a new texture */
+static GLuint
+upload_texture (BoomerangTextureFormat format, int width, int height, const guint8 *pixels)
+{
   GLuint texture = 0;
   glGenTextures (1, &texture);
   glActiveTexture (GL_TEXTURE0);
   glBindTexture (GL_TEXTURE_2D, texture);
-  glTexImage2D (GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, gdk_pixbuf_get_pixels (pixbuf));
+  glPixelStorei (GL_UNPACK_ROW_LENGTH, 0);
+  switch (format)
+    {
+    case BOOMERANG_TEXTURE_FORMAT_RGBA8:
+      glPixelStorei (GL_UNPACK_ALIGNMENT, 4);
+      glTexImage2D (GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+      break;
+    case BOOMERANG_TEXTURE_FORMAT_RGB565:
+      glPixelStorei (GL_UNPACK_ALIGNMENT, 2);
+      glTexImage2D (GL_TEXTURE_2D, 0, GL_RGB565, width, height, 0, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, pixels);
+      break;
+    case BOOMERANG_TEXTURE_FORMAT_ETC2:
+    case BOOMERANG_TEXTURE_FORMAT_BC1:
+      glCompressedTexImage2D (GL_TEXTURE_2D, 0, compressed_internal_format (format), width, height, 0,
+                              boomerang_compress_get_size (format, width, height), pixels);
+      break;
+    default:
+      g_return_val_if_reached (texture);
+    }
+
   glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
   glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  return texture;
+}
 
-  g_object_unref (pixbuf);
+static GLuint
+canvas_create_texture (BoomerangCanvas *canvas, GdkPixbuf *pixbuf)
+{
+  int width = gdk_pixbuf_get_width (pixbuf);
+  int height = gdk_pixbuf_get_height (pixbuf);
+  int channels = gdk_pixbuf_get_n_channels (pixbuf);
+  int rowstride = gdk_pixbuf_get_rowstride (pixbuf);
+  BoomerangPixelFormat format = pixbuf_format (pixbuf);
+
+  /* drivers take tightly packed rgba as it is, but many convert anything else to their own layout one pixel at a
+   * time, so do that conversion ourselves first unless the pixbuf is already in the right layout */
+  const guint8 *pixels = gdk_pixbuf_read_pixels (pixbuf);
+  g_autofree guint8 *converted = NULL;
+  if (format != BOOMERANG_PIXEL_FORMAT_RGBA8 || rowstride != width * 4)
+    {
+      gint64 convert_time = boomerang_trace_begin ();
+      converted = g_malloc ((gsize)width * height * 4);
+      boomerang_convert (format, pixels, rowstride, converted, (gsize)width * 4, width, height);
+      pixels = converted;
+      boomerang_trace_end (convert_time, "Convert", "%dx%d, %d channels, %s kernel", width, height, channels,
+                           boomerang_convert_kernel_name (boomerang_convert_get_kernel ()));
+    }
+
+  /* block compressed formats take too long to encode before the first frame, so rgb565 is shown until they are
+   * ready */
+  BoomerangTextureFormat texture_format = canvas_choose_format (canvas);
+  canvas->texture_format = blur_format (texture_format);
+  g_autofree guint8 *compact = NULL;
+  if (canvas->texture_format == BOOMERANG_TEXTURE_FORMAT_RGB565)
+    {
+      gint64 compress_time = boomerang_trace_begin ();
+      compact = g_malloc (boomerang_compress_get_size (BOOMERANG_TEXTURE_FORMAT_RGB565, width, height));
+      boomerang_compress (BOOMERANG_TEXTURE_FORMAT_RGB565, pixels, width, height, compact);
+      boomerang_trace_end (compress_time, "Compress", "%dx%d, rgb565", width, height);
+    }
+
+  gint64 trace_time = boomerang_trace_begin ();
+  GLuint texture = upload_texture (canvas->texture_format, width, height, compact ? compact : pixels);
+  boomerang_trace_end (trace_time, "Upload", "%dx%d, %d channels, %s", width, height, channels,
+                       boomerang_compress_format_name (canvas->texture_format));
+
+  /* the encoder keeps the rgba pixels until it is done with them */
+  if (texture_format != canvas->texture_format)
+    {
+      GBytes *rgba = converted ? g_bytes_new_take (g_steal_pointer (&converted), (gsize)width * height * 4)
+                               : gdk_pixbuf_read_pixel_bytes (pixbuf);
+      canvas->compress_format = texture_format;
+      canvas->compress_cancellable = g_cancellable_new ();
+      boomerang_compress_async (texture_format, rgba, width, height, canvas->compress_cancellable,
+                                canvas_compress_cb, canvas);
+      g_bytes_unref (rgba);
+    }
 
   return texture;
 }
 
 static void
-init_rendering (GtkWidget *widget, GError **error)
+canvas_create_blur_textures (BoomerangCanvas *canvas)
 {
-  BoomerangCanvas *canvas = BOOMERANG_CANVAS (widget);
+  glDeleteTextures (BLUR_LEVELS, canvas->blur_textures);
+  glGenTextures (BLUR_LEVELS, canvas->blur_textures);
 
-  gtk_gl_area_make_current (GTK_GL_AREA (widget));
+  gboolean compact = blur_format (canvas->texture_format) == BOOMERANG_TEXTURE_FORMAT_RGB565;
 
-  glClearColor (0, 0, 0, 1.0);
-  glFrontFace (GL_CW);
-  glCullFace (GL_BACK);
-  glEnable (GL_CULL_FACE);
+  glActiveTexture (GL_TEXTURE0);
+  for (int i = 0; i < BLUR_LEVELS; i++)
+    {
+      canvas->blur_size[i][0] = MAX (canvas->texture_size[0] >> (i + 1), 1);
+      canvas->blur_size[i][1] = MAX (canvas->texture_size[1] >> (i + 1), 1);
+
+      glBindTexture (GL_TEXTURE_2D, canvas->blur_textures[i]);
+      if (compact)
+        glTexImage2D (GL_TEXTURE_2D, 0, GL_RGB565, canvas->blur_size[i][0], canvas->blur_size[i][1], 0, GL_RGB,
+                      GL_UNSIGNED_SHORT_5_6_5, NULL);
+      else
+        glTexImage2D (GL_TEXTURE_2D, 0, GL_RGBA, canvas->blur_size[i][0], canvas->blur_size[i][1], 0, GL_RGBA,
+                      GL_UNSIGNED_BYTE, NULL);
+      glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+      glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+      glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+      glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
 
-  canvas->flashlight_zoom = false;
-  canvas->flashlight_enabled = 0;
-  canvas->flashlight_radius = (Animatable){ .value = 0.3, .start = 0.3, .target = 0.3 };
-  canvas->zoom_level = (Animatable){ .value = 1.0, .start = 1.0, .target = 1.0 };
+  canvas->blur_dirty = TRUE;
+}
 
-  /* initialise shader program */
+static void
+blur_pass (GLuint program, GLuint source, const int *source_size, GLuint target, const int *target_size)
+{
+  glFramebufferTexture2D (GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target, 0);
+  glViewport (0, 0, target_size[0], target_size[1]);
+  glBindTexture (GL_TEXTURE_2D, source);
 
-  canvas->program = create_program ("/shaders/vertex.glsl", "/shaders/fragment.glsl", error);
-  if (!canvas->program)
-    return;
+  GLint half_pixel_loc = glGetUniformLocation (program, "halfPixel");
+  glUniform2f (half_pixel_loc, 0.5f / source_size[0], 0.5f / source_size[1]);
 
-  /* initialise texture */
+  glDrawArrays (GL_TRIANGLES, 0, 3);
+}
 
-  canvas->texture = create_texture (canvas->filename, error);
-  if (!canvas->texture)
-    return;
+static void
+canvas_update_blur (BoomerangCanvas *canvas)
+{
+  gint64 trace_time = boomerang_trace_begin ();
 
-  GLint screenshot_texture_loc = glGetUniformLocation (canvas->program, "screenshotTexture");
-  glUniform1i (screenshot_texture_loc, canvas->texture);
+  if (!canvas->blur_framebuffer)
+    glGenFramebuffers (1, &canvas->blur_framebuffer);
+  glBindFramebuffer (GL_FRAMEBUFFER, canvas->blur_framebuffer);
+  glBindVertexArray (canvas->vao);
+  glActiveTexture (GL_TEXTURE0);
 
-  /* initialise geometry buffers */
+  /* the screenshot is normally drawn with nearest filtering to keep pixels sharp when zoomed, but the first
+   * downsample needs to average neighbouring pixels */
+  glBindTexture (GL_TEXTURE_2D, canvas->texture);
+  glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+
+  /* downsample all the way to the smallest level, then upsample back to the largest */
+  glUseProgram (canvas->blur_down_program);
+  GLint down_source_loc = glGetUniformLocation (canvas->blur_down_program, "sourceTexture");
+  glUniform1i (down_source_loc, 0);
+  blur_pass (canvas->blur_down_program, canvas->texture, canvas->texture_size, canvas->blur_textures[0],
+             canvas->blur_size[0]);
+  for (int i = 1; i < BLUR_LEVELS; i++)
+    blur_pass (canvas->blur_down_program, canvas->blur_textures[i - 1], canvas->blur_size[i - 1],
+               canvas->blur_textures[i], canvas->blur_size[i]);
+
+  glUseProgram (canvas->blur_up_program);
+  GLint up_source_loc = glGetUniformLocation (canvas->blur_up_program, "sourceTexture");
+  glUniform1i (up_source_loc, 0);
+  for (int i = BLUR_LEVELS - 1; i > 0; i--)
+    blur_pass (canvas->blur_up_program, canvas->blur_textures[i], canvas->blur_size[i], canvas->blur_textures[i - 1],
+               canvas->blur_size[i - 1]);
 
-  glGenVertexArrays (1, &canvas->vao);
-  glBindVertexArray (canvas->vao);
+  glBindTexture (GL_TEXTURE_2D, canvas->texture);
+  glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 
-  glGenBuffers (1, &canvas->vbo);
-  glBindBuffer (GL_ARRAY_BUFFER, canvas->vbo);
-  glBufferData (GL_ARRAY_BUFFER, sizeof (geometry), geometry, GL_STATIC_DRAW);
+  /* go back to drawing into the gl area */
+  gtk_gl_area_attach_buffers (GTK_GL_AREA (canvas));
+  glViewport (0, 0, (GLint)canvas->resolution[0], (GLint)canvas->resolution[1]);
 
-  GLint poscoord = glGetAttribLocation (canvas->program, "posCoord");
-  GLint texcoord = glGetAttribLocation (canvas->program, "texCoord");
-  glBindVertexArray (canvas->vao);
-  glVertexAttribPointer (poscoord, 2, GL_FLOAT, false, 4 * sizeof (GLfloat), (void *)0);
-  glVertexAttribPointer (texcoord, 2, GL_FLOAT, false, 4 * sizeof (GLfloat), (void *)8);
-  glEnableVertexAttribArray (poscoord);
-  glEnableVertexAttribArray (texcoord);
-}
+  canvas->blur_dirty = FALSE;
 
-static double
-ease_out_cubic (double timestep)
-{
-  /* cubic easing curve gives fast initial motion and slows down towards the finish */
-  return 1 - pow (1 - timestep, 3);
+  boomerang_trace_end (trace_time, "Blur", "%dx%d, %d levels", canvas->texture_size[0], canvas->texture_size[1],
+                       BLUR_LEVELS);
 }
 
-static void canvas_drag_end (GtkGestureDrag *gesture, double offset_x, double offset_y, gpointer data);
+/* size in pixels of the square tiles compared when updating a texture with a new screenshot */
+#define TILE_SIZE 64
 
 static gboolean
-canvas_animate_value (GtkWidget *widget, GdkFrameClock *frame_clock, gpointer data)
+pixbuf_same_layout (GdkPixbuf *a, GdkPixbuf *b)
 {
-  Animatable *animation = (Animatable *)data;
+  return gdk_pixbuf_get_width (a) == gdk_pixbuf_get_width (b) && gdk_pixbuf_get_height (a) == gdk_pixbuf_get_height (b)
+         && gdk_pixbuf_get_n_channels (a) == gdk_pixbuf_get_n_channels (b)
+         && gdk_pixbuf_get_rowstride (a) == gdk_pixbuf_get_rowstride (b);
+}
 
-  gboolean done = G_SOURCE_REMOVE;
+/* uploads only the tiles of the new pixbuf that differ from the old one, which must have the same layout, and
+ * returns the number of tiles that were uploaded */
+static int
+update_texture (GLuint texture, GdkPixbuf *old_pixbuf, GdkPixbuf *new_pixbuf)
+{
+  int width = gdk_pixbuf_get_width (new_pixbuf);
+  int height = gdk_pixbuf_get_height (new_pixbuf);
+  int channels = gdk_pixbuf_get_n_channels (new_pixbuf);
+  int rowstride = gdk_pixbuf_get_rowstride (new_pixbuf);
+  BoomerangPixelFormat format = pixbuf_format (new_pixbuf);
+  const guchar *old_pixels = gdk_pixbuf_read_pixels (old_pixbuf);
+  const guchar *new_pixels = gdk_pixbuf_read_pixels (new_pixbuf);
 
-  /* calculate the time since last frame and add it to the accumulated time since the start of the animation */
-  int64_t current_time = gdk_frame_clock_get_frame_time (frame_clock);
-  double delta_seconds = 0.0;
-  if (animation->last_time > 0)
+  int columns = (width + TILE_SIZE - 1) / TILE_SIZE;
+  gboolean *dirty = g_new (gboolean, columns);
+  int uploaded = 0;
+
+  /* changed tiles are converted to rgba in the same way as the whole screenshot is, a band at a time */
+  gboolean convert = format != BOOMERANG_PIXEL_FORMAT_RGBA8 || rowstride % 4 != 0;
+  guint8 *converted = convert ? g_malloc ((gsize)width * TILE_SIZE * 4) : NULL;
+
+  gint64 trace_time = boomerang_trace_begin ();
+
+  glActiveTexture (GL_TEXTURE0);
+  glBindTexture (GL_TEXTURE_2D, texture);
+
+  /* rgba pixbufs are uploaded straight from the pixbuf, giving the row length in pixels to step over the rest of
+   * each row */
+  glPixelStorei (GL_UNPACK_ALIGNMENT, 4);
+  glPixelStorei (GL_UNPACK_ROW_LENGTH, convert ? 0 : rowstride / 4);
+
+  for (int top = 0; top < height; top += TILE_SIZE)
     {
-      delta_seconds = (current_time - animation->last_time) / 1000000.0;
+      int rows = MIN (TILE_SIZE, height - top);
+
+      /* compare a row at a time across the whole band, skipping tiles once they are known to have changed, memcmp is
+       * vectorised by the c library so this runs at close to memory bandwidth */
+      int remaining = columns;
+      memset (dirty, 0, columns * sizeof (gboolean));
+      for (int y = top; y < top + rows && remaining > 0; y++)
+        {
+          gsize offset = (gsize)y * rowstride;
+          for (int column = 0; column < columns; column++)
+            {
+              if (dirty[column])
+                continue;
+              int x = column * TILE_SIZE;
+              gsize len = (gsize)MIN (TILE_SIZE, width - x) * channels;
+              gsize start = offset + (gsize)x * channels;
+              if (memcmp (old_pixels + start, new_pixels + start, len) != 0)
+                {
+                  dirty[column] = TRUE;
+                  remaining--;
+                }
+            }
+        }
+
+      /* upload horizontally adjacent changed tiles together */
+      for (int column = 0; column < columns; column++)
+        {
+          if (!dirty[column])
+            continue;
+          int first = column;
+          while (column + 1 < columns && dirty[column + 1])
+            column++;
+
+          int x = first * TILE_SIZE;
+          int span = MIN ((column + 1) * TILE_SIZE, width) - x;
+          const guint8 *pixels = new_pixels + (gsize)top * rowstride + (gsize)x * channels;
+          if (convert)
+            {
+              boomerang_convert_rows (format, pixels, rowstride, converted, (gsize)span * 4, span, rows);
+              pixels = converted;
+            }
+          glTexSubImage2D (GL_TEXTURE_2D, 0, x, top, span, rows, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+          uploaded += column - first + 1;
+        }
     }
-  animation->last_time = current_time;
-  animation->accum_seconds += delta_seconds;
 
-  if (animation->accum_seconds < 0.5)
-    {
-      float direction = animation->target > animation->value ? 1.0 : -1.0;
-      float difference = fabsf (animation->target - animation->start);
-      float progress = difference * ease_out_cubic (animation->accum_seconds * 2) * direction;
+  glPixelStorei (GL_UNPACK_ROW_LENGTH, 0);
+  g_free (converted);
+  g_free (dirty);
 
-      animation->value = animation->start + progress;
+  boomerang_trace_end (trace_time, "Upload", "%dx%d, %d channels, %d of %d tiles changed", width, height, channels,
+                       uploaded, columns * ((height + TILE_SIZE - 1) / TILE_SIZE));
+  return uploaded;
+}
 
-      done = G_SOURCE_CONTINUE;
+static GdkTexture *
+create_gdk_texture (GdkPixbuf *pixbuf)
+{
+  int width = gdk_pixbuf_get_width (pixbuf);
+  int height = gdk_pixbuf_get_height (pixbuf);
+  int channels = gdk_pixbuf_get_n_channels (pixbuf);
+  GdkMemoryFormat format = (channels == 4 ? GDK_MEMORY_R8G8B8A8 : GDK_MEMORY_R8G8B8);
+
+  gint64 trace_time = boomerang_trace_begin ();
+
+  /* wraps the pixbuf data without copying, gsk uploads it the first time the texture is drawn */
+  GBytes *bytes = gdk_pixbuf_read_pixel_bytes (pixbuf);
+  GdkTexture *texture = gdk_memory_texture_new (width, height, format, bytes, gdk_pixbuf_get_rowstride (pixbuf));
+  g_bytes_unref (bytes);
+
+  boomerang_trace_end (trace_time, "Upload", "%dx%d, %d channels, deferred to gsk", width, height, channels);
+
+  return texture;
+}
+
+static void
+canvas_regions_cb (GObject *source, GAsyncResult *result, gpointer data)
+{
+  GError *error = NULL;
+  BoomerangRegionIndex *regions = boomerang_region_index_new_finish (result, &error);
+  if (!regions)
+    {
+      /* the canvas may already be gone if indexing was cancelled */
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        g_printerr ("Error: %s\n", error->message);
+      g_error_free (error);
+      return;
     }
-  else
+
+  BoomerangCanvas *canvas = BOOMERANG_CANVAS (data);
+  canvas->regions = regions;
+}
+
+static GdkPixbuf *
+load_pixbuf (const char *filename, GError **error)
+{
+  /* qoi images are recognised by their contents and decoded by us, anything else is left to gdk-pixbuf */
+  GMappedFile *file = g_mapped_file_new (filename, FALSE, error);
+  if (!file)
+    return NULL;
+
+  g_autoptr (GBytes) bytes = g_mapped_file_get_bytes (file);
+  g_mapped_file_unref (file);
+
+  if (boomerang_qoi_check (bytes))
+    return boomerang_qoi_decode (bytes, error);
+  return gdk_pixbuf_new_from_file (filename, error);
+}
+
+static GdkPixbuf *
+crop_pixbuf (GdkPixbuf *pixbuf, const GdkRectangle *area, const GdkRectangle *desktop)
+{
+  /* the screenshot may be at a higher resolution than the logical desktop, so scale the area to match, copying it
+   * out so that the rest of the desktop is freed */
+  int width = gdk_pixbuf_get_width (pixbuf);
+  int height = gdk_pixbuf_get_height (pixbuf);
+  double scale_x = (double)width / desktop->width;
+  double scale_y = (double)height / desktop->height;
+  int left = CLAMP (round ((area->x - desktop->x) * scale_x), 0, width - 1);
+  int top = CLAMP (round ((area->y - desktop->y) * scale_y), 0, height - 1);
+  int right = CLAMP (round ((area->x + area->width - desktop->x) * scale_x), left + 1, width);
+  int bottom = CLAMP (round ((area->y + area->height - desktop->y) * scale_y), top + 1, height);
+  if (left == 0 && top == 0 && right == width && bottom == height)
+    return g_object_ref (pixbuf);
+
+  gint64 trace_time = boomerang_trace_begin ();
+
+  GdkPixbuf *subpixbuf = gdk_pixbuf_new_subpixbuf (pixbuf, left, top, right - left, bottom - top);
+  GdkPixbuf *cropped = gdk_pixbuf_copy (subpixbuf);
+  g_object_unref (subpixbuf);
+
+  boomerang_trace_end (trace_time, "Crop", "%dx%d to %dx%d", width, height, right - left, bottom - top);
+  return cropped;
+}
+
+/* decodes a screenshot and crops it to the given area of the desktop, or leaves it whole if that is NULL */
+static GdkPixbuf *
+decode_screenshot (const char *filename, const GdkRectangle *area, const GdkRectangle *desktop, GError **error)
+{
+  gint64 trace_time = boomerang_trace_begin ();
+
+  GdkPixbuf *pixbuf = load_pixbuf (filename, error);
+  if (!pixbuf)
     {
-      /* animation has finished */
-      animation->value = animation->target;
-      animation->last_time = 0;
+      boomerang_trace_end (trace_time, "Decode", "Error: %s", (*error)->message);
+      return NULL;
     }
 
-  /* ensure the drag limits are respected when we zoom out */
-  canvas_drag_end (NULL, 0, 0, widget);
+  boomerang_trace_end (trace_time, "Decode", "%s", filename);
 
-  gtk_gl_area_queue_render (GTK_GL_AREA (widget));
-  return done;
+  if (area)
+    {
+      GdkPixbuf *cropped = crop_pixbuf (pixbuf, area, desktop);
+      g_object_unref (pixbuf);
+      pixbuf = cropped;
+    }
+  return pixbuf;
+}
+
+static GdkPixbuf *
+canvas_decode_screenshot (BoomerangCanvas *canvas, GError **error)
+{
+  return decode_screenshot (canvas->filename, canvas->crop_enabled ? &canvas->crop_area : NULL,
+                            &canvas->crop_desktop, error);
 }
 
+/* a screenshot decoded again on a worker thread, with copies of what the canvas knew about it when it was asked */
+typedef struct
+{
+  char *filename;
+  gboolean crop_enabled;
+  GdkRectangle crop_area;
+  GdkRectangle crop_desktop;
+} PixelsRequest;
+
 static void
-canvas_animate_value_end (gpointer data)
+pixels_request_free (PixelsRequest *request)
 {
-  Animatable *animation = (Animatable *)data;
-  animation->id = 0;
+  g_free (request->filename);
+  g_free (request);
 }
 
 static void
-canvas_zoom (BoomerangCanvas *canvas, int direction)
+canvas_pixels_thread (GTask *task, gpointer source, gpointer task_data, GCancellable *cancellable)
+{
+  PixelsRequest *request = task_data;
+
+  GError *error = NULL;
+  GdkPixbuf *pixbuf = decode_screenshot (request->filename, request->crop_enabled ? &request->crop_area : NULL,
+                                         &request->crop_desktop, &error);
+  if (pixbuf)
+    g_task_return_pointer (task, pixbuf, g_object_unref);
+  else
+    g_task_return_error (task, error);
+}
+
+/* the pixels are kept to find what changed when recapturing, which never happens to a slide */
+static gboolean
+canvas_keeps_pixels (BoomerangCanvas *canvas)
+{
+  return (!canvas->memory_budget && !canvas->slides) || canvas->renderer == BOOMERANG_RENDERER_GSK
+         || canvas->inspector_enabled;
+}
+
+static void
+canvas_cancel_pixels (BoomerangCanvas *canvas)
+{
+  g_cancellable_cancel (canvas->pixels_cancellable);
+  g_clear_object (&canvas->pixels_cancellable);
+}
+
+static void
+canvas_pixels_cb (GObject *source, GAsyncResult *result, gpointer data)
+{
+  GError *error = NULL;
+  GdkPixbuf *pixbuf = g_task_propagate_pointer (G_TASK (result), &error);
+  if (!pixbuf)
+    {
+      /* the screenshot may already have been replaced if decoding was cancelled */
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+          g_printerr ("Error: Unable to inspect screenshot: %s\n", error->message);
+          g_clear_object (&BOOMERANG_CANVAS (source)->pixels_cancellable);
+        }
+      g_error_free (error);
+      return;
+    }
+
+  /* the inspector shows nothing until the pixels arrive, and may have been closed again in the meantime */
+  BoomerangCanvas *canvas = BOOMERANG_CANVAS (source);
+  g_clear_object (&canvas->pixels_cancellable);
+  if (canvas_keeps_pixels (canvas))
+    g_set_object (&canvas->pixbuf, pixbuf);
+  g_object_unref (pixbuf);
+
+  canvas_report_memory (canvas);
+  gtk_gl_area_queue_render (GTK_GL_AREA (canvas));
+}
+
+/* decodes the screenshot again in the background when the inspector needs its pixels after they were let go of, or
+ * lets them go again when it no longer does */
+static void
+canvas_update_pixels (BoomerangCanvas *canvas)
+{
+  if (!canvas_keeps_pixels (canvas))
+    {
+      canvas_cancel_pixels (canvas);
+      g_clear_object (&canvas->pixbuf);
+    }
+  else if (!canvas->pixbuf && canvas->texture_size[0] && !canvas->pixels_cancellable)
+    {
+      PixelsRequest *request = g_new0 (PixelsRequest, 1);
+      request->filename = g_strdup (canvas->filename);
+      request->crop_enabled = canvas->crop_enabled;
+      request->crop_area = canvas->crop_area;
+      request->crop_desktop = canvas->crop_desktop;
+
+      canvas->pixels_cancellable = g_cancellable_new ();
+      GTask *task = g_task_new (canvas, canvas->pixels_cancellable, canvas_pixels_cb, NULL);
+      g_task_set_task_data (task, request, (GDestroyNotify)pixels_request_free);
+      g_task_run_in_thread (task, canvas_pixels_thread);
+      g_object_unref (task);
+    }
+  canvas_report_memory (canvas);
+}
+
+static gboolean
+canvas_load_screenshot (BoomerangCanvas *canvas, GError **error)
+{
+  GdkPixbuf *pixbuf = canvas_decode_screenshot (canvas, error);
+  if (!pixbuf)
+    return FALSE;
+
+  /* pixels still being decoded for the inspector are of the screenshot being replaced */
+  canvas_cancel_pixels (canvas);
+
+  if (canvas->history)
+    boomerang_history_add (pixbuf);
+  canvas->history = FALSE;
+
+  canvas_cancel_compress (canvas);
+
+  canvas->texture_size[0] = gdk_pixbuf_get_width (pixbuf);
+  canvas->texture_size[1] = gdk_pixbuf_get_height (pixbuf);
+
+  if (canvas->renderer == BOOMERANG_RENDERER_GSK)
+    {
+      g_clear_object (&canvas->gdk_texture);
+      canvas->gdk_texture = create_gdk_texture (pixbuf);
+    }
+  else if (canvas->texture && canvas->texture_format == BOOMERANG_TEXTURE_FORMAT_RGBA8 && canvas->pixbuf
+           && pixbuf_same_layout (canvas->pixbuf, pixbuf))
+    {
+      /* a recapture of the same screen usually only differs in a few places, so leave the rest of the texture and
+       * the region index alone if nothing changed at all, textures in a compact format are always made again since
+       * tiles of rgba pixels cannot be written into them */
+      if (update_texture (canvas->texture, canvas->pixbuf, pixbuf) == 0)
+        {
+          g_set_object (&canvas->pixbuf, pixbuf);
+          g_object_unref (pixbuf);
+          return TRUE;
+        }
+      canvas->blur_dirty = TRUE;
+    }
+  else
+    {
+      if (canvas->texture)
+        glDeleteTextures (1, &canvas->texture);
+      canvas->texture = canvas_create_texture (canvas, pixbuf);
+      canvas_create_blur_textures (canvas);
+    }
+
+  /* without a copy of the old pixels the next recapture is uploaded in full, rather than just what changed */
+  g_set_object (&canvas->pixbuf, canvas_keeps_pixels (canvas) ? pixbuf : NULL);
+  canvas_report_memory (canvas);
+
+  /* discard the index of any previous screenshot and start indexing this one */
+  g_cancellable_cancel (canvas->cancellable);
+  g_clear_object (&canvas->cancellable);
+  g_clear_pointer (&canvas->regions, boomerang_region_index_free);
+
+  canvas->cancellable = g_cancellable_new ();
+  boomerang_region_index_new_async (pixbuf, canvas->cancellable, canvas_regions_cb, canvas);
+
+  g_object_unref (pixbuf);
+  return TRUE;
+}
+
+static Slide *
+slide_new (const char *filename)
+{
+  Slide *slide = g_new0 (Slide, 1);
+  slide->filename = g_strdup (filename);
+  slide->zoom_level = ZOOM_MIN;
+  slide->flashlight_radius = FLASHLIGHT_RADIUS;
+  slide->flashlight_shape = SPOTLIGHT_SHAPE_CIRCLE;
+  slide->pins = g_array_new (FALSE, FALSE, sizeof (PinnedSpotlight));
+  return slide;
+}
+
+/* lets go of everything decoded for the slide, keeping only its view, the gl context must be current */
+static void
+slide_release (Slide *slide)
+{
+  g_cancellable_cancel (slide->cancellable);
+  g_clear_object (&slide->cancellable);
+  slide->loading = FALSE;
+
+  if (slide->texture)
+    glDeleteTextures (1, &slide->texture);
+  slide->texture = 0;
+  g_clear_object (&slide->gdk_texture);
+  g_clear_object (&slide->pixbuf);
+  g_clear_pointer (&slide->regions, boomerang_region_index_free);
+}
+
+/* textures must have been released while the gl context was still around */
+static void
+slide_free (Slide *slide)
+{
+  g_warn_if_fail (slide->texture == 0);
+  g_cancellable_cancel (slide->cancellable);
+  g_clear_object (&slide->cancellable);
+  g_clear_object (&slide->gdk_texture);
+  g_clear_object (&slide->pixbuf);
+  g_clear_pointer (&slide->regions, boomerang_region_index_free);
+  g_array_unref (slide->pins);
+  g_free (slide->filename);
+  g_free (slide);
+}
+
+static SlideImage *
+slide_image_new (BoomerangCanvas *canvas, Slide *slide)
+{
+  /* the memory budget is shared between all the slides the cache may hold, and the compressed format depends on the
+   * gl context so it is found here rather than on the worker thread */
+  SlideImage *image = g_new0 (SlideImage, 1);
+  image->filename = g_strdup (slide->filename);
+  image->convert = canvas->renderer != BOOMERANG_RENDERER_GSK;
+  image->budget = canvas->memory_budget / SLIDE_CACHE_SIZE;
+  image->compressed = image->convert ? compressed_format () : BOOMERANG_TEXTURE_FORMAT_RGB565;
+  return image;
+}
+
+static void
+slide_image_free (SlideImage *image)
+{
+  g_free (image->filename);
+  g_clear_object (&image->pixbuf);
+  g_clear_pointer (&image->pixels, g_bytes_unref);
+  g_free (image);
+}
+
+/* does everything up to the upload itself, so that uploading a preloaded slide is all that is left for the main
+ * thread, gsk being given the pixbuf as it is */
+static gboolean
+slide_image_prepare (SlideImage *image, GError **error)
+{
+  gint64 trace_time = boomerang_trace_begin ();
+
+  image->pixbuf = load_pixbuf (image->filename, error);
+  if (!image->pixbuf)
+    {
+      boomerang_trace_end (trace_time, "Decode", "Error: %s", (*error)->message);
+      return FALSE;
+    }
+
+  boomerang_trace_end (trace_time, "Decode", "%s", image->filename);
+
+  if (!image->convert)
+    return TRUE;
+
+  int width = gdk_pixbuf_get_width (image->pixbuf);
+  int height = gdk_pixbuf_get_height (image->pixbuf);
+  int rowstride = gdk_pixbuf_get_rowstride (image->pixbuf);
+  BoomerangPixelFormat format = pixbuf_format (image->pixbuf);
+  gsize size = (gsize)width * height * 4;
+
+  GBytes *rgba;
+  if (format != BOOMERANG_PIXEL_FORMAT_RGBA8 || rowstride != width * 4)
+    {
+      gint64 convert_time = boomerang_trace_begin ();
+      guint8 *converted = g_malloc (size);
+      boomerang_convert (format, gdk_pixbuf_read_pixels (image->pixbuf), rowstride, converted, (gsize)width * 4,
+                         width, height);
+      rgba = g_bytes_new_take (converted, size);
+      boomerang_trace_end (convert_time, "Convert", "%dx%d, %d channels, %s kernel", width, height,
+                           gdk_pixbuf_get_n_channels (image->pixbuf),
+                           boomerang_convert_kernel_name (boomerang_convert_get_kernel ()));
+    }
+  else
+    {
+      rgba = gdk_pixbuf_read_pixel_bytes (image->pixbuf);
+    }
+
+  image->format = choose_format (image->budget, image->compressed, width, height);
+  if (image->format == BOOMERANG_TEXTURE_FORMAT_RGBA8)
+    {
+      image->pixels = rgba;
+      return TRUE;
+    }
+
+  gint64 compress_time = boomerang_trace_begin ();
+  gsize compact_size = boomerang_compress_get_size (image->format, width, height);
+  guint8 *compact = g_malloc (compact_size);
+  boomerang_compress (image->format, g_bytes_get_data (rgba, NULL), width, height, compact);
+  image->pixels = g_bytes_new_take (compact, compact_size);
+  g_bytes_unref (rgba);
+  boomerang_trace_end (compress_time, "Compress", "%dx%d, %s", width, height,
+                       boomerang_compress_format_name (image->format));
+  return TRUE;
+}
+
+static void
+slide_regions_cb (GObject *source, GAsyncResult *result, gpointer data)
+{
+  GError *error = NULL;
+  BoomerangRegionIndex *regions = boomerang_region_index_new_finish (result, &error);
+  if (!regions)
+    {
+      /* the slide may already have been let go of if indexing was cancelled */
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        g_printerr ("Error: %s\n", error->message);
+      g_error_free (error);
+      return;
+    }
+
+  Slide *slide = data;
+  slide->regions = regions;
+}
+
+/* uploads a decoded slide into its own textures, ready for when it is shown, the gl context must be current */
+static void
+canvas_upload_slide (BoomerangCanvas *canvas, Slide *slide, SlideImage *image)
+{
+  slide->loading = FALSE;
+  slide->texture_size[0] = gdk_pixbuf_get_width (image->pixbuf);
+  slide->texture_size[1] = gdk_pixbuf_get_height (image->pixbuf);
+
+  if (canvas->renderer == BOOMERANG_RENDERER_GSK)
+    {
+      slide->texture_format = BOOMERANG_TEXTURE_FORMAT_RGBA8;
+      slide->gdk_texture = create_gdk_texture (image->pixbuf);
+      slide->pixbuf = g_object_ref (image->pixbuf);
+    }
+  else
+    {
+      gint64 trace_time = boomerang_trace_begin ();
+      slide->texture_format = image->format;
+      slide->texture = upload_texture (image->format, slide->texture_size[0], slide->texture_size[1],
+                                       g_bytes_get_data (image->pixels, NULL));
+      boomerang_trace_end (trace_time, "Upload", "%dx%d, %s, %s", slide->texture_size[0], slide->texture_size[1],
+                           boomerang_compress_format_name (slide->texture_format), slide->filename);
+    }
+
+  boomerang_region_index_new_async (image->pixbuf, slide->cancellable, slide_regions_cb, slide);
+}
+
+static void
+slide_decode_thread (GTask *task, gpointer source, gpointer task_data, GCancellable *cancellable)
+{
+  GError *error = NULL;
+  if (!slide_image_prepare (task_data, &error))
+    g_task_return_error (task, error);
+  else
+    g_task_return_boolean (task, TRUE);
+}
+
+static void
+slide_decode_cb (GObject *source, GAsyncResult *result, gpointer data)
+{
+  GError *error = NULL;
+  if (!g_task_propagate_boolean (G_TASK (result), &error))
+    {
+      /* the slide may already have been let go of if decoding was cancelled, a slide that could not be decoded is
+       * tried again when it is shown, so that the error is reported then */
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+          Slide *slide = data;
+          g_debug ("Unable to preload %s: %s", slide->filename, error->message);
+          g_clear_object (&slide->cancellable);
+          slide->loading = FALSE;
+        }
+      g_error_free (error);
+      return;
+    }
+
+  BoomerangCanvas *canvas = BOOMERANG_CANVAS (source);
+  Slide *slide = data;
+  if (canvas->renderer != BOOMERANG_RENDERER_GSK)
+    {
+      gtk_gl_area_make_current (GTK_GL_AREA (canvas));
+      if (gtk_gl_area_get_error (GTK_GL_AREA (canvas)))
+        {
+          /* not uploaded, so it is decoded again when it is shown */
+          g_clear_object (&slide->cancellable);
+          slide->loading = FALSE;
+          return;
+        }
+    }
+  canvas_upload_slide (canvas, slide, g_task_get_task_data (G_TASK (result)));
+}
+
+/* decodes a slide on a worker thread and uploads it when it is ready, so that showing it later is only a matter of
+ * binding its texture */
+static void
+canvas_preload_slide (BoomerangCanvas *canvas, Slide *slide)
+{
+  slide->cancellable = g_cancellable_new ();
+  slide->loading = TRUE;
+
+  GTask *task = g_task_new (canvas, slide->cancellable, slide_decode_cb, slide);
+  g_task_set_task_data (task, slide_image_new (canvas, slide), (GDestroyNotify)slide_image_free);
+  g_task_run_in_thread (task, slide_decode_thread);
+  g_object_unref (task);
+}
+
+/* lets go of the slides used least recently until no more than the cache can hold are left */
+static void
+canvas_trim_slides (BoomerangCanvas *canvas)
+{
+  for (;;)
+    {
+      guint cached = 0;
+      Slide *oldest = NULL;
+      for (guint i = 0; i < canvas->slides->len; i++)
+        {
+          Slide *slide = g_ptr_array_index (canvas->slides, i);
+          if (!slide->cancellable)
+            continue;
+          cached++;
+          if (i != canvas->slide && (!oldest || slide->last_used < oldest->last_used))
+            oldest = slide;
+        }
+      if (cached <= SLIDE_CACHE_SIZE || !oldest)
+        return;
+      slide_release (oldest);
+    }
+}
+
+static void
+canvas_animatable_reset (BoomerangCanvas *canvas, Animatable *animation, double value)
+{
+  if (animation->id)
+    gtk_widget_remove_tick_callback (GTK_WIDGET (canvas), animation->id);
+  *animation = (Animatable){ .value = value, .start = value, .target = value };
+}
+
+static double animatable_final_value (Animatable *animation);
+
+/* hands the textures of the slide being shown back to it, along with the view it is being left at */
+static void
+canvas_leave_slide (BoomerangCanvas *canvas)
+{
+  if (!canvas->slide_shown)
+    return;
+
+  Slide *slide = g_ptr_array_index (canvas->slides, canvas->slide);
+  slide->zoom_level = animatable_final_value (&canvas->zoom_level);
+  slide->pan[0] = animatable_final_value (&canvas->pan[0]) + canvas->drag_offset[0];
+  slide->pan[1] = animatable_final_value (&canvas->pan[1]) + canvas->drag_offset[1];
+  slide->flashlight_radius = animatable_final_value (&canvas->flashlight_radius);
+  slide->flashlight_enabled = canvas->flashlight_enabled;
+  slide->flashlight_shape = canvas->flashlight_shape;
+  slide->flashlight_placed = canvas->flashlight_placed;
+  slide->flashlight_texel[0] = canvas->flashlight_texel[0];
+  slide->flashlight_texel[1] = canvas->flashlight_texel[1];
+  g_array_set_size (slide->pins, 0);
+  g_array_append_vals (slide->pins, canvas->pins->data, canvas->pins->len);
+
+  slide->texture = canvas->texture;
+  canvas->texture = 0;
+  slide->gdk_texture = g_steal_pointer (&canvas->gdk_texture);
+  slide->texture_size[0] = canvas->texture_size[0];
+  slide->texture_size[1] = canvas->texture_size[1];
+  slide->texture_format = canvas->texture_format;
+
+  /* gsk keeps the pixels alive for its texture anyway, otherwise they are only kept while they are being inspected */
+  if (canvas->renderer == BOOMERANG_RENDERER_GSK)
+    g_set_object (&slide->pixbuf, canvas->pixbuf);
+  g_clear_object (&canvas->pixbuf);
+
+  canvas->slide_shown = FALSE;
+}
+
+/* takes the textures of a cached slide to show it, and returns to the view it was left at */
+static void
+canvas_enter_slide (BoomerangCanvas *canvas, guint index)
+{
+  Slide *slide = g_ptr_array_index (canvas->slides, index);
+
+  /* whatever was shown before the deck is let go of, slides are never compressed or indexed by the canvas itself */
+  canvas_cancel_compress (canvas);
+  canvas_cancel_pixels (canvas);
+  g_cancellable_cancel (canvas->cancellable);
+  g_clear_object (&canvas->cancellable);
+  g_clear_pointer (&canvas->regions, boomerang_region_index_free);
+  if (canvas->texture)
+    glDeleteTextures (1, &canvas->texture);
+  g_clear_object (&canvas->gdk_texture);
+  g_clear_object (&canvas->pixbuf);
+
+  canvas->slide = index;
+  canvas->slide_shown = TRUE;
+  canvas->texture = slide->texture;
+  slide->texture = 0;
+  canvas->gdk_texture = g_steal_pointer (&slide->gdk_texture);
+  canvas->pixbuf = g_steal_pointer (&slide->pixbuf);
+  canvas->texture_size[0] = slide->texture_size[0];
+  canvas->texture_size[1] = slide->texture_size[1];
+  canvas->texture_format = slide->texture_format;
+  g_free (canvas->filename);
+  canvas->filename = g_strdup (slide->filename);
+  if (canvas->renderer != BOOMERANG_RENDERER_GSK)
+    canvas_create_blur_textures (canvas);
+
+  canvas_animatable_reset (canvas, &canvas->zoom_level, slide->zoom_level);
+  canvas_animatable_reset (canvas, &canvas->pan[0], slide->pan[0]);
+  canvas_animatable_reset (canvas, &canvas->pan[1], slide->pan[1]);
+  canvas_animatable_reset (canvas, &canvas->flashlight_radius, slide->flashlight_radius);
+  canvas->drag_offset[0] = 0.0;
+  canvas->drag_offset[1] = 0.0;
+  canvas->flashlight_enabled = slide->flashlight_enabled;
+  canvas->flashlight_shape = slide->flashlight_shape;
+  canvas->flashlight_placed = slide->flashlight_placed;
+  canvas->flashlight_texel[0] = slide->flashlight_texel[0];
+  canvas->flashlight_texel[1] = slide->flashlight_texel[1];
+  g_array_set_size (canvas->pins, 0);
+  g_array_append_vals (canvas->pins, slide->pins->data, slide->pins->len);
+
+  canvas_update_pixels (canvas);
+}
+
+/* shows a slide of the deck, decoding it now if it was not preloaded, and then starts preloading those around it,
+ * the gl context must be current */
+static gboolean
+canvas_show_slide (BoomerangCanvas *canvas, guint index, GError **error)
+{
+  if (canvas->slide_shown && canvas->slide == index)
+    return TRUE;
+
+  gint64 trace_time = boomerang_trace_begin ();
+
+  /* the slide being shown is only left once this one is known to be good */
+  Slide *slide = g_ptr_array_index (canvas->slides, index);
+  gboolean preloaded = slide->texture || slide->gdk_texture;
+  if (!preloaded)
+    {
+      slide_release (slide);
+      SlideImage *image = slide_image_new (canvas, slide);
+      gboolean decoded = slide_image_prepare (image, error);
+      if (decoded)
+        {
+          slide->cancellable = g_cancellable_new ();
+          canvas_upload_slide (canvas, slide, image);
+        }
+      slide_image_free (image);
+      if (!decoded)
+        {
+          boomerang_trace_end (trace_time, "Show slide", "Error: %s", (*error)->message);
+          return FALSE;
+        }
+    }
+
+  canvas_leave_slide (canvas);
+  canvas_enter_slide (canvas, index);
+
+  slide->last_used = ++canvas->slide_clock;
+  for (guint i = 0; i < G_N_ELEMENTS (slide_preload); i++)
+    {
+      int next = (int)index + slide_preload[i];
+      if (next < 0 || next >= (int)canvas->slides->len)
+        continue;
+
+      Slide *upcoming = g_ptr_array_index (canvas->slides, next);
+      upcoming->last_used = ++canvas->slide_clock;
+      if (!upcoming->cancellable)
+        canvas_preload_slide (canvas, upcoming);
+    }
+  canvas_trim_slides (canvas);
+
+  boomerang_trace_end (trace_time, "Show slide", "%u of %u, %s", index + 1, canvas->slides->len,
+                       preloaded ? "preloaded" : "decoded");
+  return TRUE;
+}
+
+/* lets go of the textures of every slide, including the one being shown, the gl context must be current */
+static void
+canvas_release_slides (BoomerangCanvas *canvas)
+{
+  if (!canvas->slides)
+    return;
+
+  canvas_leave_slide (canvas);
+  for (guint i = 0; i < canvas->slides->len; i++)
+    slide_release (g_ptr_array_index (canvas->slides, i));
+}
+
+/* lets go of the whole deck, the gl context must be current if the canvas is realized */
+static void
+canvas_clear_slides (BoomerangCanvas *canvas)
+{
+  canvas_release_slides (canvas);
+  g_clear_pointer (&canvas->slides, g_ptr_array_unref);
+}
+
+/* moves to the next or previous slide of the deck, staying on the first or last one */
+static void
+canvas_page (BoomerangCanvas *canvas, int direction)
+{
+  if (!canvas->slides)
+    return;
+
+  int index = CLAMP ((int)canvas->slide + direction, 0, (int)canvas->slides->len - 1);
+  if (canvas->renderer != BOOMERANG_RENDERER_GSK)
+    gtk_gl_area_make_current (GTK_GL_AREA (canvas));
+
+  GError *error = NULL;
+  if (!canvas_show_slide (canvas, index, &error))
+    {
+      g_printerr ("Error: Unable to show slide: %s\n", error->message);
+      g_error_free (error);
+    }
+}
+
+/* loads the screenshot, or the slide of the deck that is to be shown */
+static gboolean
+canvas_load (BoomerangCanvas *canvas, GError **error)
+{
+  if (canvas->slides)
+    return canvas_show_slide (canvas, canvas->slide, error);
+  return canvas_load_screenshot (canvas, error);
+}
+
+static void
+init_state (BoomerangCanvas *canvas)
+{
+  canvas->flashlight_zoom = false;
+  canvas->flashlight_enabled = 0;
+  canvas->flashlight_placed = FALSE;
+  canvas->flashlight_radius
+      = (Animatable){ .value = FLASHLIGHT_RADIUS, .start = FLASHLIGHT_RADIUS, .target = FLASHLIGHT_RADIUS };
+  canvas->flashlight_shape = SPOTLIGHT_SHAPE_CIRCLE;
+  canvas->blur_enabled = 1;
+  g_array_set_size (canvas->pins, 0);
+  canvas->lens_enabled = 0;
+  canvas->lens_shape = LENS_SHAPE_CIRCLE;
+  canvas->inspector_enabled = FALSE;
+  canvas->lens_zoom = (Animatable){ .value = 2.0, .start = 2.0, .target = 2.0 };
+  canvas->lens_radius = (Animatable){ .value = 0.25, .start = 0.25, .target = 0.25 };
+  canvas->zoom_level = (Animatable){ .value = 1.0, .start = 1.0, .target = 1.0 };
+  canvas->pan[0] = (Animatable){ .value = 0.0, .start = 0.0, .target = 0.0 };
+  canvas->pan[1] = (Animatable){ .value = 0.0, .start = 0.0, .target = 0.0 };
+}
+
+static void
+init_rendering (GtkWidget *widget, GError **error)
+{
+  BoomerangCanvas *canvas = BOOMERANG_CANVAS (widget);
+
+  gtk_gl_area_make_current (GTK_GL_AREA (widget));
+
+  glClearColor (0, 0, 0, 1.0);
+  glFrontFace (GL_CW);
+  glCullFace (GL_BACK);
+  glEnable (GL_CULL_FACE);
+
+  /* initialise shader program */
+
+  canvas->program = create_program ("/shaders/vertex.glsl", "/shaders/fragment.glsl", error);
+  if (!canvas->program)
+    return;
+
+  canvas->blur_down_program = create_program ("/shaders/blur-vertex.glsl", "/shaders/blur-downsample.glsl", error);
+  if (!canvas->blur_down_program)
+    return;
+
+  canvas->blur_up_program = create_program ("/shaders/blur-vertex.glsl", "/shaders/blur-upsample.glsl", error);
+  if (!canvas->blur_up_program)
+    return;
+
+  /* initialise texture */
+
+  if (!canvas_load (canvas, error))
+    return;
+
+  /* initialise geometry buffers */
+
+  glGenVertexArrays (1, &canvas->vao);
+  glBindVertexArray (canvas->vao);
+
+  glGenBuffers (1, &canvas->vbo);
+  glBindBuffer (GL_ARRAY_BUFFER, canvas->vbo);
+  glBufferData (GL_ARRAY_BUFFER, sizeof (geometry), geometry, GL_STATIC_DRAW);
+
+  GLint poscoord = glGetAttribLocation (canvas->program, "posCoord");
+  GLint texcoord = glGetAttribLocation (canvas->program, "texCoord");
+  glBindVertexArray (canvas->vao);
+  glVertexAttribPointer (poscoord, 2, GL_FLOAT, false, 4 * sizeof (GLfloat), (void *)0);
+  glVertexAttribPointer (texcoord, 2, GL_FLOAT, false, 4 * sizeof (GLfloat), (void *)8);
+  glEnableVertexAttribArray (poscoord);
+  glEnableVertexAttribArray (texcoord);
+
+  /* initialise spotlight buffer, big enough for the most spotlights we allow */
+
+  glGenBuffers (1, &canvas->spotlight_ubo);
+  glBindBuffer (GL_UNIFORM_BUFFER, canvas->spotlight_ubo);
+  glBufferData (GL_UNIFORM_BUFFER, sizeof (SpotlightBlock), NULL, GL_DYNAMIC_DRAW);
+
+  GLuint spotlights_index = glGetUniformBlockIndex (canvas->program, "Spotlights");
+  glUniformBlockBinding (canvas->program, spotlights_index, 0);
+}
+
+static double
+ease_out_cubic (double timestep)
+{
+  /* cubic easing curve gives fast initial motion and slows down towards the finish */
+  return 1 - pow (1 - timestep, 3);
+}
+
+static void canvas_drag_end (GtkGestureDrag *gesture, double offset_x, double offset_y, gpointer data);
+
+static gint64
+canvas_frame_time (BoomerangCanvas *canvas, GdkFrameClock *frame_clock)
+{
+  /* animations follow the virtual clock while replaying so that they progress the same way on every machine, offset
+   * by a second because a time of zero means an animation has not started */
+  if (canvas->replay_task)
+    return canvas->replay_time + G_USEC_PER_SEC;
+  return gdk_frame_clock_get_frame_time (frame_clock);
+}
+
+static gboolean
+canvas_animate_value (GtkWidget *widget, GdkFrameClock *frame_clock, gpointer data)
+{
+  Animatable *animation = (Animatable *)data;
+
+  gboolean done = G_SOURCE_REMOVE;
+
+  /* calculate the time since last frame and add it to the accumulated time since the start of the animation */
+  int64_t current_time = canvas_frame_time (BOOMERANG_CANVAS (widget), frame_clock);
+  double delta_seconds = 0.0;
+  if (animation->last_time > 0)
+    {
+      delta_seconds = (current_time - animation->last_time) / 1000000.0;
+    }
+  animation->last_time = current_time;
+  animation->accum_seconds += delta_seconds;
+
+  if (animation->accum_seconds < animation->duration)
+    {
+      double direction = animation->target > animation->value ? 1.0 : -1.0;
+      double difference = fabs (animation->target - animation->start);
+      double progress = difference * ease_out_cubic (animation->accum_seconds / animation->duration) * direction;
+
+      animation->value = animation->start + progress;
+
+      done = G_SOURCE_CONTINUE;
+    }
+  else
+    {
+      /* animation has finished */
+      animation->value = animation->target;
+      animation->last_time = 0;
+    }
+
+  /* ensure the drag limits are respected when we zoom out */
+  canvas_drag_end (NULL, 0, 0, widget);
+
+  gtk_gl_area_queue_render (GTK_GL_AREA (widget));
+  return done;
+}
+
+static void
+canvas_animate_value_end (gpointer data)
+{
+  Animatable *animation = (Animatable *)data;
+  animation->id = 0;
+}
+
+static void
+canvas_animate_for (BoomerangCanvas *canvas, Animatable *animation, double target, double duration)
+{
+  animation->accum_seconds = 0;
+  animation->duration = duration;
+  animation->start = animation->value;
+  animation->target = target;
+
+  if (duration <= 0)
+    {
+      /* jump straight to the target, any animation that is already running will finish on its next tick */
+      animation->value = target;
+      canvas_drag_end (NULL, 0, 0, canvas);
+      gtk_gl_area_queue_render (GTK_GL_AREA (canvas));
+      return;
+    }
+
+  if (!animation->id && animation->target != animation->start)
+    {
+      animation->id = gtk_widget_add_tick_callback (GTK_WIDGET (canvas), canvas_animate_value, animation,
+                                                    canvas_animate_value_end);
+    }
+}
+
+static void
+canvas_animate (BoomerangCanvas *canvas, Animatable *animation, double target)
+{
+  canvas_animate_for (canvas, animation, target, ANIMATION_DURATION);
+}
+
+static double
+animatable_final_value (Animatable *animation)
+{
+  /* the value an animation will settle on, which is where subsequent commands should be relative to */
+  return animation->id ? animation->target : animation->value;
+}
+
+static void
+canvas_zoom (BoomerangCanvas *canvas, int direction)
+{
+  Animatable *animation = &canvas->zoom_level;
+  double min = ZOOM_MIN;
+  double max = ZOOM_MAX;
+  if (canvas->lens_enabled && canvas->flashlight_zoom)
+    {
+      min = 0.05;
+      max = 1.0;
+      animation = &canvas->lens_radius;
+    }
+  else if (canvas->lens_enabled)
+    {
+      min = LENS_ZOOM_MIN;
+      max = LENS_ZOOM_MAX;
+      animation = &canvas->lens_zoom;
+    }
+  else if (canvas->flashlight_zoom)
+    {
+      min = 0.05;
+      animation = &canvas->flashlight_radius;
+    }
+
+  double increment = animation->value * 0.1;
+  double target = animation->target + increment * direction;
+  target = CLAMP (target, min, max);
+
+  canvas_animate (canvas, animation, target);
+}
+
+static void
+canvas_pointer_to_texel (BoomerangCanvas *canvas, double *texel)
+{
+  /* invert the zoom and drag transformation from the vertex shader to find the screenshot pixel under the pointer,
+   * remembering that texture coordinates have an inverted y-axis compared to the viewport */
+  for (int i = 0; i < 2; i++)
+    {
+      double drag = canvas->pan[i].value + canvas->drag_offset[i];
+      double ndc = 2.0 * canvas->pointer[i] / canvas->resolution[i] - 1.0;
+      double pos = (ndc - 2.0 * drag / canvas->resolution[i]) / canvas->zoom_level.value;
+      double coord = i == 0 ? (pos + 1.0) / 2.0 : (1.0 - pos) / 2.0;
+      texel[i] = coord * canvas->texture_size[i];
+    }
+}
+
+static void
+canvas_texel_to_view (BoomerangCanvas *canvas, const double *texel, double *view)
+{
+  /* the inverse of the above, using the current zoom and drag so that the result keeps up with animations and drags */
+  for (int i = 0; i < 2; i++)
+    {
+      double coord = texel[i] / canvas->texture_size[i];
+      double pos = i == 0 ? coord * 2.0 - 1.0 : 1.0 - coord * 2.0;
+      double drag = canvas->pan[i].value + canvas->drag_offset[i];
+      double ndc = pos * canvas->zoom_level.value + 2.0 * drag / canvas->resolution[i];
+      view[i] = (ndc + 1.0) / 2.0 * canvas->resolution[i];
+    }
+}
+
+static void
+canvas_flashlight_to_view (BoomerangCanvas *canvas, double *view)
+{
+  if (canvas->flashlight_placed)
+    {
+      canvas_texel_to_view (canvas, canvas->flashlight_texel, view);
+      return;
+    }
+  view[0] = canvas->pointer[0];
+  view[1] = canvas->pointer[1];
+}
+
+static void
+spotlight_data_init (BoomerangCanvas *canvas, SpotlightData *data, int shape, double x, double y, double radius)
+{
+  /* convert the centre from frame buffer coordinates to the normalised device coordinates used by the fragment
+   * shader, and make all but the circle wider than they are tall */
+  double divisor = MIN (canvas->resolution[0], canvas->resolution[1]);
+  data->geometry[0] = (2.0 * x - canvas->resolution[0]) / divisor;
+  data->geometry[1] = (2.0 * y - canvas->resolution[1]) / divisor;
+  data->geometry[2] = shape == SPOTLIGHT_SHAPE_CIRCLE ? radius : radius * 1.6;
+  data->geometry[3] = radius;
+  data->params[0] = shape;
+  data->params[1] = shape == SPOTLIGHT_SHAPE_ROUNDED_RECT ? radius * 0.25 : 0.0;
+  data->params[2] = 0.0;
+  data->params[3] = 0.0;
+}
+
+static int
+canvas_get_spotlights (BoomerangCanvas *canvas, SpotlightData *spotlights)
+{
+  int count = 0;
+
+  if (canvas->flashlight_enabled)
+    {
+      double view[2];
+      canvas_flashlight_to_view (canvas, view);
+      spotlight_data_init (canvas, &spotlights[count++], canvas->flashlight_shape, view[0], view[1],
+                           canvas->flashlight_radius.value);
+    }
+
+  for (guint i = 0; i < canvas->pins->len && count < MAX_SPOTLIGHTS; i++)
+    {
+      PinnedSpotlight *pin = &g_array_index (canvas->pins, PinnedSpotlight, i);
+      double view[2];
+      canvas_texel_to_view (canvas, pin->texel, view);
+      spotlight_data_init (canvas, &spotlights[count++], pin->shape, view[0], view[1],
+                           pin->radius * canvas->zoom_level.value);
+    }
+
+  return count;
+}
+
+static void
+canvas_pin_spotlight (BoomerangCanvas *canvas)
+{
+  /* always leave room for the flashlight */
+  if (!canvas->flashlight_enabled || canvas->pins->len >= MAX_SPOTLIGHTS - 1)
+    {
+      gtk_widget_error_bell (GTK_WIDGET (canvas));
+      return;
+    }
+
+  PinnedSpotlight pin = {
+    .shape = canvas->flashlight_shape,
+    .radius = canvas->flashlight_radius.value / canvas->zoom_level.value,
+  };
+  if (canvas->flashlight_placed)
+    {
+      pin.texel[0] = canvas->flashlight_texel[0];
+      pin.texel[1] = canvas->flashlight_texel[1];
+    }
+  else
+    {
+      canvas_pointer_to_texel (canvas, pin.texel);
+    }
+  g_array_append_val (canvas->pins, pin);
+}
+
+static gboolean
+canvas_pick (BoomerangCanvas *canvas, int *x, int *y, guint8 *rgba)
+{
+  /* answered from the copy of the screenshot we keep in memory, reading back from the gpu would stall rendering */
+  if (!canvas->pixbuf)
+    return FALSE;
+
+  double texel[2];
+  canvas_pointer_to_texel (canvas, texel);
+  *x = floor (texel[0]);
+  *y = floor (texel[1]);
+  if (*x < 0 || *y < 0 || *x >= gdk_pixbuf_get_width (canvas->pixbuf) || *y >= gdk_pixbuf_get_height (canvas->pixbuf))
+    return FALSE;
+
+  int channels = gdk_pixbuf_get_n_channels (canvas->pixbuf);
+  const guint8 *pixel = gdk_pixbuf_read_pixels (canvas->pixbuf) +
+                        (gsize)*y * gdk_pixbuf_get_rowstride (canvas->pixbuf) + (gsize)*x * channels;
+  rgba[0] = pixel[0];
+  rgba[1] = pixel[1];
+  rgba[2] = pixel[2];
+  rgba[3] = channels == 4 ? pixel[3] : 0xff;
+  return TRUE;
+}
+
+static void
+canvas_copy_colour (BoomerangCanvas *canvas)
+{
+  int x, y;
+  guint8 rgba[4];
+  if (!canvas_pick (canvas, &x, &y, rgba))
+    {
+      gtk_widget_error_bell (GTK_WIDGET (canvas));
+      return;
+    }
+
+  g_autofree char *text = g_strdup_printf ("#%02X%02X%02X%02X", rgba[0], rgba[1], rgba[2], rgba[3]);
+  gdk_clipboard_set_text (gtk_widget_get_clipboard (GTK_WIDGET (canvas)), text);
+}
+
+static void
+canvas_snapshot_inspector (BoomerangCanvas *canvas, GtkSnapshot *snapshot, float width, float height)
+{
+  int x, y;
+  guint8 rgba[4];
+  if (!canvas_pick (canvas, &x, &y, rgba))
+    return;
+
+  g_autofree char *text = g_strdup_printf ("%d, %d\n#%02X%02X%02X%02X\nrgba(%d, %d, %d, %.2f)", x, y, rgba[0], rgba[1],
+                                           rgba[2], rgba[3], rgba[0], rgba[1], rgba[2], rgba[3] / 255.0);
+  PangoLayout *layout = gtk_widget_create_pango_layout (GTK_WIDGET (canvas), text);
+  int text_width, text_height;
+  pango_layout_get_pixel_size (layout, &text_width, &text_height);
+
+  /* a swatch of the colour sits to the left of the text, and the whole thing follows the pointer, flipping to the
+   * other side of it when it would run off the edge of the screen */
+  const float padding = 8;
+  const float offset = 16;
+  float swatch = text_height;
+  float box_width = swatch + text_width + padding * 3;
+  float box_height = text_height + padding * 2;
+  float pointer_x = canvas->pointer[0] / canvas->scale_factor;
+  float pointer_y = height - canvas->pointer[1] / canvas->scale_factor;
+  float left = pointer_x + offset + box_width > width ? pointer_x - offset - box_width : pointer_x + offset;
+  float top = pointer_y + offset + box_height > height ? pointer_y - offset - box_height : pointer_y + offset;
+
+  GskRoundedRect box;
+  gsk_rounded_rect_init_from_rect (&box, &GRAPHENE_RECT_INIT (left, top, box_width, box_height), 6);
+  gtk_snapshot_push_rounded_clip (snapshot, &box);
+  gtk_snapshot_append_color (snapshot, &(GdkRGBA){ 0, 0, 0, 0.75 }, &box.bounds);
+  gtk_snapshot_pop (snapshot);
+
+  gtk_snapshot_append_color (snapshot,
+                             &(GdkRGBA){ rgba[0] / 255.0f, rgba[1] / 255.0f, rgba[2] / 255.0f, rgba[3] / 255.0f },
+                             &GRAPHENE_RECT_INIT (left + padding, top + padding, swatch, swatch));
+
+  gtk_snapshot_save (snapshot);
+  gtk_snapshot_translate (snapshot, &GRAPHENE_POINT_INIT (left + swatch + padding * 2, top + padding));
+  gtk_snapshot_append_layout (snapshot, layout, &(GdkRGBA){ 1, 1, 1, 1 });
+  gtk_snapshot_restore (snapshot);
+
+  g_object_unref (layout);
+}
+
+static void
+canvas_zoom_to_region (BoomerangCanvas *canvas, const GdkRectangle *region, double duration)
+{
+  /* choose the zoom level that fits the region to the screen, then pan so that the centre of the region ends up in
+   * the centre of the screen */
+  double zoom = MIN ((double)canvas->texture_size[0] / MAX (region->width, 1),
+                     (double)canvas->texture_size[1] / MAX (region->height, 1));
+  zoom = CLAMP (zoom, ZOOM_MIN, ZOOM_MAX);
+
+  double centre[2];
+  centre[0] = 2.0 * (region->x + region->width / 2.0) / canvas->texture_size[0] - 1.0;
+  centre[1] = 1.0 - 2.0 * (region->y + region->height / 2.0) / canvas->texture_size[1];
+
+  /* zoom first so that the drag limits allow for the new zoom level when panning */
+  canvas_animate_for (canvas, &canvas->zoom_level, zoom, duration);
+  for (int i = 0; i < 2; i++)
+    {
+      double limit = (canvas->resolution[i] * zoom - canvas->resolution[i]) / 2.0;
+      double drag = -centre[i] * zoom * canvas->resolution[i] / 2.0;
+      canvas_animate_for (canvas, &canvas->pan[i], CLAMP (drag, -limit, limit), duration);
+    }
+}
+
+static void
+canvas_snap_zoom (BoomerangCanvas *canvas)
+{
+  /* each slide keeps its own index, so that it is still there when paging back to it */
+  BoomerangRegionIndex *regions = canvas->regions;
+  if (canvas->slide_shown)
+    regions = ((Slide *)g_ptr_array_index (canvas->slides, canvas->slide))->regions;
+
+  /* nothing to snap to until the background indexing of the screenshot has finished */
+  if (!regions)
+    return;
+
+  double texel[2];
+  canvas_pointer_to_texel (canvas, texel);
+
+  GdkRectangle region;
+  if (!boomerang_region_index_lookup (regions, texel[0], texel[1], &region))
+    return;
+
+  canvas_zoom_to_region (canvas, &region, ANIMATION_DURATION);
+}
+
+static void
+canvas_record (BoomerangCanvas *canvas, BoomerangSessionEventType type, double x, double y, guint keyval,
+               guint state)
 {
-  Animatable *animation = &canvas->zoom_level;
-  float min = 1.0;
-  float max = 10.0;
-  if (canvas->flashlight_zoom)
-    {
-      min = 0.05;
-      animation = &canvas->flashlight_radius;
-    }
+  if (!canvas->session || canvas->replay_task)
+    return;
 
-  float increment = animation->value * 0.1;
-  animation->accum_seconds = 0;
-  animation->start = animation->value;
-  animation->target += increment * direction;
-  animation->target = fmaxf (animation->target, min);
-  animation->target = fminf (animation->target, max);
+  /* pointer positions only make sense when replayed on a canvas of the same size */
+  int width, height;
+  if (!boomerang_session_get_size (canvas->session, &width, &height))
+    boomerang_session_set_size (canvas->session, gtk_widget_get_width (GTK_WIDGET (canvas)),
+                                gtk_widget_get_height (GTK_WIDGET (canvas)));
+
+  BoomerangSessionEvent event = {
+    .time = g_get_monotonic_time () - canvas->record_start,
+    .type = type,
+    .x = x,
+    .y = y,
+    .keyval = keyval,
+    .state = state,
+  };
+  boomerang_session_add_event (canvas->session, &event);
+}
 
-  if (!animation->id && animation->target != animation->start)
-    {
-      animation->id = gtk_widget_add_tick_callback (GTK_WIDGET (canvas), canvas_animate_value, animation,
-                                                    canvas_animate_value_end);
-    }
+/* real input is ignored while replaying, so that the replay and its timings are the same however the pointer is
+ * moved, replayed input is given without a controller */
+static gboolean
+canvas_ignores_input (BoomerangCanvas *canvas, gpointer controller)
+{
+  return controller && canvas->replay_task;
 }
 
 static gboolean
@@ -317,6 +2010,11 @@ canvas_scroll (GtkEventControllerScroll *controller, gdouble dx, gdouble dy, gpo
 {
   BoomerangCanvas *canvas = BOOMERANG_CANVAS (data);
 
+  if (canvas_ignores_input (canvas, controller))
+    return FALSE;
+
+  canvas_record (canvas, BOOMERANG_SESSION_SCROLL, dx, dy, 0, 0);
+
   canvas_zoom (canvas, -dy);
 
   gtk_gl_area_queue_render (GTK_GL_AREA (data));
@@ -329,18 +2027,62 @@ canvas_key_pressed (GtkEventControllerKey *controller, guint keyval, guint keyco
 {
   BoomerangCanvas *canvas = BOOMERANG_CANVAS (data);
 
-  /* holding ctrl zooms the flashlight area instead of the screenshot */
+  if (canvas_ignores_input (canvas, controller))
+    return;
+
+  canvas_record (canvas, BOOMERANG_SESSION_KEY_PRESSED, 0, 0, keyval, state);
+
+  /* holding ctrl zooms the flashlight area, or resizes the lens, instead of zooming the screenshot */
   if (keyval == GDK_KEY_Control_L || keyval == GDK_KEY_Control_R)
     canvas->flashlight_zoom = true;
 
+  /* switching the flashlight back on brings it back to the pointer */
   if (keyval == GDK_KEY_f)
-    canvas->flashlight_enabled = canvas->flashlight_enabled ? 0 : 1;
+    {
+      canvas->flashlight_enabled = canvas->flashlight_enabled ? 0 : 1;
+      canvas->flashlight_placed = FALSE;
+    }
+
+  /* the inspector shows the colour of the pixel under the pointer, which ctrl+c copies */
+  if (keyval == GDK_KEY_i)
+    {
+      canvas->inspector_enabled = !canvas->inspector_enabled;
+      canvas_update_pixels (canvas);
+    }
+  if (keyval == GDK_KEY_c && (state & GDK_CONTROL_MASK))
+    canvas_copy_colour (canvas);
+
+  /* pinning leaves a copy of the flashlight on the screenshot, so that several areas can be lit at once */
+  if (keyval == GDK_KEY_c && !(state & GDK_CONTROL_MASK))
+    canvas->flashlight_shape = (canvas->flashlight_shape + 1) % SPOTLIGHT_SHAPE_COUNT;
+  if (keyval == GDK_KEY_p)
+    canvas_pin_spotlight (canvas);
+  if (keyval == GDK_KEY_P || keyval == GDK_KEY_BackSpace)
+    g_array_set_size (canvas->pins, 0);
+
+  if (keyval == GDK_KEY_b)
+    canvas->blur_enabled = canvas->blur_enabled ? 0 : 1;
+
+  /* while the lens is shown, zooming changes the magnification of the lens instead of the screenshot */
+  if (keyval == GDK_KEY_l)
+    canvas->lens_enabled = canvas->lens_enabled ? 0 : 1;
+  if (keyval == GDK_KEY_L)
+    canvas->lens_shape = (canvas->lens_shape + 1) % LENS_SHAPE_COUNT;
 
   if (keyval == GDK_KEY_equal || keyval == GDK_KEY_plus)
     canvas_zoom (canvas, 1);
   if (keyval == GDK_KEY_minus || keyval == GDK_KEY_underscore)
     canvas_zoom (canvas, -1);
 
+  if (keyval == GDK_KEY_s)
+    canvas_snap_zoom (canvas);
+
+  /* presentation remotes send page up and down to change slides */
+  if (keyval == GDK_KEY_Page_Down)
+    canvas_page (canvas, 1);
+  if (keyval == GDK_KEY_Page_Up)
+    canvas_page (canvas, -1);
+
   if (keyval == GDK_KEY_F12)
     canvas->debugging = canvas->debugging ? 0 : 1;
 
@@ -353,6 +2095,11 @@ canvas_key_released (GtkEventControllerKey *controller, guint keyval, guint keyc
 {
   BoomerangCanvas *canvas = BOOMERANG_CANVAS (data);
 
+  if (canvas_ignores_input (canvas, controller))
+    return;
+
+  canvas_record (canvas, BOOMERANG_SESSION_KEY_RELEASED, 0, 0, keyval, state);
+
   if (keyval == GDK_KEY_Control_L || keyval == GDK_KEY_Control_R)
     canvas->flashlight_zoom = false;
 }
@@ -362,6 +2109,11 @@ canvas_motion (GtkEventControllerMotion *controller, double x, double y, gpointe
 {
   BoomerangCanvas *canvas = BOOMERANG_CANVAS (data);
 
+  if (canvas_ignores_input (canvas, controller))
+    return;
+
+  canvas_record (canvas, BOOMERANG_SESSION_MOTION, x, y, 0, 0);
+
   /* use the scale factor to convert from widget coordinates to frame buffer coordinates */
   canvas->pointer[0] = x * canvas->scale_factor;
   canvas->pointer[1] = y * canvas->scale_factor;
@@ -377,6 +2129,13 @@ canvas_drag_update (GtkGestureDrag *gesture, double offset_x, double offset_y, g
 {
   BoomerangCanvas *canvas = BOOMERANG_CANVAS (data);
 
+  if (canvas_ignores_input (canvas, gesture))
+    return;
+
+  /* this is also called without a gesture to apply the drag limits, which is not input */
+  if (gesture)
+    canvas_record (canvas, BOOMERANG_SESSION_DRAG_UPDATE, offset_x, offset_y, 0, 0);
+
   canvas->drag_offset[0] = offset_x * canvas->scale_factor;
   canvas->drag_offset[1] = offset_y * canvas->scale_factor * -1.0;
 
@@ -384,13 +2143,13 @@ canvas_drag_update (GtkGestureDrag *gesture, double offset_x, double offset_y, g
   for (int i = 0; i < 2; i++)
     {
       double limit = (canvas->resolution[i] * canvas->zoom_level.value - canvas->resolution[i]) / 2.0;
-      double proposed = canvas->drag_total[i] + canvas->drag_offset[i];
+      double proposed = canvas->pan[i].value + canvas->drag_offset[i];
       if (fabs (proposed) > limit)
         {
           if (proposed > 0)
-            canvas->drag_offset[i] = limit - canvas->drag_total[i];
+            canvas->drag_offset[i] = limit - canvas->pan[i].value;
           else
-            canvas->drag_offset[i] = -limit - canvas->drag_total[i];
+            canvas->drag_offset[i] = -limit - canvas->pan[i].value;
         }
     }
 
@@ -402,24 +2161,149 @@ canvas_drag_end (GtkGestureDrag *gesture, double offset_x, double offset_y, gpoi
 {
   BoomerangCanvas *canvas = BOOMERANG_CANVAS (data);
 
-  canvas_drag_update (gesture, offset_x, offset_y, data);
+  if (canvas_ignores_input (canvas, gesture))
+    return;
+
+  if (gesture)
+    canvas_record (canvas, BOOMERANG_SESSION_DRAG_END, offset_x, offset_y, 0, 0);
+
+  canvas_drag_update (NULL, offset_x, offset_y, data);
 
-  canvas->drag_total[0] += canvas->drag_offset[0];
-  canvas->drag_total[1] += canvas->drag_offset[1];
+  canvas->pan[0].value += canvas->drag_offset[0];
+  canvas->pan[1].value += canvas->drag_offset[1];
   canvas->drag_offset[0] = 0.0;
   canvas->drag_offset[1] = 0.0;
 }
 
+static void
+canvas_replay_event (BoomerangCanvas *canvas, const BoomerangSessionEvent *event)
+{
+  switch (event->type)
+    {
+    case BOOMERANG_SESSION_MOTION:
+      canvas_motion (NULL, event->x, event->y, canvas);
+      break;
+    case BOOMERANG_SESSION_SCROLL:
+      canvas_scroll (NULL, event->x, event->y, canvas);
+      break;
+    case BOOMERANG_SESSION_DRAG_UPDATE:
+      canvas_drag_update (NULL, event->x, event->y, canvas);
+      break;
+    case BOOMERANG_SESSION_DRAG_END:
+      canvas_drag_end (NULL, event->x, event->y, canvas);
+      break;
+    case BOOMERANG_SESSION_KEY_PRESSED:
+      canvas_key_pressed (NULL, event->keyval, 0, event->state, canvas);
+      break;
+    case BOOMERANG_SESSION_KEY_RELEASED:
+      canvas_key_released (NULL, event->keyval, 0, event->state, canvas);
+      break;
+    default:
+      break;
+    }
+}
+
+static void
+canvas_replay_finish (BoomerangCanvas *canvas, GError *error)
+{
+  GTask *task = g_steal_pointer (&canvas->replay_task);
+  canvas->replay_id = 0;
+  canvas->session = NULL;
+
+  if (error)
+    g_task_return_error (task, error);
+  else
+    g_task_return_boolean (task, TRUE);
+  g_object_unref (task);
+}
+
+static gboolean
+canvas_replay_tick (GtkWidget *widget, GdkFrameClock *frame_clock, gpointer data)
+{
+  BoomerangCanvas *canvas = BOOMERANG_CANVAS (widget);
+
+  /* the virtual clock starts once there is something to draw, then advances by exactly one frame every frame no
+   * matter how long the frame really took */
+  if (!canvas->texture_size[0] || !canvas->resolution[0])
+    return G_SOURCE_CONTINUE;
+
+  gint64 frame_time = gdk_frame_clock_get_frame_time (frame_clock);
+  if (canvas->replay_started)
+    {
+      canvas->replay_time += REPLAY_FRAME_TIME;
+      canvas->replay_interval = frame_time - canvas->replay_frame_time;
+    }
+  canvas->replay_started = TRUE;
+  canvas->replay_frame_time = frame_time;
+
+  guint n_events;
+  const BoomerangSessionEvent *events = boomerang_session_get_events (canvas->session, &n_events);
+  canvas->replay_events = 0;
+  while (canvas->replay_next < n_events && events[canvas->replay_next].time <= canvas->replay_time)
+    {
+      canvas_replay_event (canvas, &events[canvas->replay_next++]);
+      canvas->replay_events++;
+    }
+
+  /* carry on after the last event for long enough that any animation it started has finished */
+  if (canvas->replay_next >= n_events && canvas->replay_time >= canvas->replay_end)
+    {
+      canvas_replay_finish (canvas, NULL);
+      return G_SOURCE_REMOVE;
+    }
+
+  /* draw every frame, even when nothing changed, so that each one is timed */
+  gtk_gl_area_queue_render (GTK_GL_AREA (canvas));
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+canvas_replay_frame (BoomerangCanvas *canvas, gint64 start_time)
+{
+  if (!canvas->replay_task || !canvas->replay_started)
+    return;
+
+  BoomerangSessionFrame frame = {
+    .time = canvas->replay_time,
+    .events = canvas->replay_events,
+    .render_time = g_get_monotonic_time () - start_time,
+    .interval = canvas->replay_interval,
+  };
+  boomerang_session_add_frame (canvas->session, &frame);
+}
+
+static void
+canvas_set_error (BoomerangCanvas *canvas, GError *error)
+{
+  /* the gl area only displays errors when it is doing the rendering */
+  if (canvas->renderer == BOOMERANG_RENDERER_GSK)
+    g_printerr ("Error: %s\n", error->message);
+  else
+    gtk_gl_area_set_error (GTK_GL_AREA (canvas), error);
+  g_error_free (error);
+}
+
 static void
 canvas_realize (GtkWidget *widget)
 {
+  BoomerangCanvas *canvas = BOOMERANG_CANVAS (widget);
+
+  gint64 trace_time = boomerang_trace_begin ();
+
+  init_state (canvas);
+
   GError *error = NULL;
-  init_rendering (widget, &error);
-  if (error)
+  if (canvas->renderer == BOOMERANG_RENDERER_GSK)
     {
-      gtk_gl_area_set_error (GTK_GL_AREA (widget), error);
-      g_error_free (error);
+      canvas->scale_factor = gtk_widget_get_scale_factor (widget);
+      canvas_load (canvas, &error);
+    }
+  else
+    {
+      init_rendering (widget, &error);
     }
+  if (error)
+    canvas_set_error (canvas, error);
 
   GtkEventController *motion_controller = gtk_event_controller_motion_new ();
   gtk_widget_add_controller (widget, motion_controller);
@@ -439,15 +2323,52 @@ canvas_realize (GtkWidget *widget)
   gtk_widget_add_controller (widget, key_controller);
   g_signal_connect (key_controller, "key-pressed", G_CALLBACK (canvas_key_pressed), widget);
   g_signal_connect (key_controller, "key-released", G_CALLBACK (canvas_key_released), widget);
+
+  boomerang_trace_end (trace_time, "Realize", NULL);
 }
 
 static void
 canvas_unrealize (GtkWidget *widget)
 {
   BoomerangCanvas *canvas = BOOMERANG_CANVAS (widget);
+  gint64 trace_time = boomerang_trace_begin ();
+
+  if (canvas->replay_task)
+    {
+      gtk_widget_remove_tick_callback (widget, canvas->replay_id);
+      canvas_replay_finish (canvas, g_error_new (G_IO_ERROR, G_IO_ERROR_CANCELLED, "Replay was interrupted"));
+    }
+
+  /* the textures of the slides go with the gl context, they are decoded again if the canvas is realized again */
+  if (canvas->renderer != BOOMERANG_RENDERER_GSK)
+    gtk_gl_area_make_current (GTK_GL_AREA (widget));
+  canvas_release_slides (canvas);
+
+  g_cancellable_cancel (canvas->cancellable);
+  g_clear_object (&canvas->cancellable);
+  g_clear_pointer (&canvas->regions, boomerang_region_index_free);
+  canvas_cancel_compress (canvas);
+  canvas_cancel_pixels (canvas);
+
+  g_clear_object (&canvas->gdk_texture);
+  g_clear_object (&canvas->pixbuf);
+  if (canvas->renderer == BOOMERANG_RENDERER_GSK)
+    {
+      boomerang_trace_end (trace_time, "Unrealize", NULL);
+      return;
+    }
 
   gtk_gl_area_make_current (GTK_GL_AREA (widget));
 
+  glDeleteTextures (BLUR_LEVELS, canvas->blur_textures);
+  if (canvas->blur_framebuffer)
+    glDeleteFramebuffers (1, &canvas->blur_framebuffer);
+  if (canvas->blur_up_program)
+    glDeleteProgram (canvas->blur_up_program);
+  if (canvas->blur_down_program)
+    glDeleteProgram (canvas->blur_down_program);
+  if (canvas->spotlight_ubo)
+    glDeleteBuffers (1, &canvas->spotlight_ubo);
   if (canvas->vbo)
     glDeleteBuffers (1, &canvas->vbo);
   if (canvas->vao)
@@ -456,6 +2377,8 @@ canvas_unrealize (GtkWidget *widget)
     glDeleteTextures (1, &canvas->texture);
   if (canvas->program)
     glDeleteProgram (canvas->program);
+
+  boomerang_trace_end (trace_time, "Unrealize", NULL);
 }
 
 static void
@@ -473,28 +2396,65 @@ canvas_resize (GtkGLArea *widget, int width, int height)
   glViewport (0, 0, (GLint)width, (GLint)height);
 
   /* compute an orthographic projection */
-  GLfloat left = -1.0f;
-  GLfloat right = 1.0f;
-  GLfloat bottom = -1.0f;
-  GLfloat top = 1.0f;
-  GLfloat near = -1.0f;
-  GLfloat far = 1.0f;
-  canvas->projection[0] = 2.0f / (right - left);
-  canvas->projection[1] = 0.0f;
-  canvas->projection[2] = 0.0f;
-  canvas->projection[3] = 0.0f;
-  canvas->projection[4] = 0.0f;
-  canvas->projection[5] = 2.0f / (top - bottom);
-  canvas->projection[6] = 0.0f;
-  canvas->projection[7] = 0.0f;
-  canvas->projection[8] = 0.0f;
-  canvas->projection[9] = 0.0f;
-  canvas->projection[10] = -2.0f / (far - near);
-  canvas->projection[11] = 0.0f;
+  double left = -1.0;
+  double right = 1.0;
+  double bottom = -1.0;
+  double top = 1.0;
+  double near = -1.0;
+  double far = 1.0;
+  canvas->projection[0] = 2.0 / (right - left);
+  canvas->projection[1] = 0.0;
+  canvas->projection[2] = 0.0;
+  canvas->projection[3] = 0.0;
+  canvas->projection[4] = 0.0;
+  canvas->projection[5] = 2.0 / (top - bottom);
+  canvas->projection[6] = 0.0;
+  canvas->projection[7] = 0.0;
+  canvas->projection[8] = 0.0;
+  canvas->projection[9] = 0.0;
+  canvas->projection[10] = -2.0 / (far - near);
+  canvas->projection[11] = 0.0;
   canvas->projection[12] = -(right + left) / (right - left);
   canvas->projection[13] = -(top + bottom) / (top - bottom);
   canvas->projection[14] = -(far + near) / (far - near);
-  canvas->projection[15] = 1.0f;
+  canvas->projection[15] = 1.0;
+}
+
+static void
+canvas_view_matrix (BoomerangCanvas *canvas, GLfloat *matrix)
+{
+  /* the screenshot is zoomed about the centre of the screen and then offset by the drag position, this is worked out
+   * in double precision and only the result is given to the vertex shader, so that it stays steady at high zoom */
+  double transform[16] = { 0.0 };
+  transform[0] = canvas->zoom_level.value;
+  transform[5] = canvas->zoom_level.value;
+  transform[10] = 1.0;
+  transform[12] = 2.0 * (canvas->pan[0].value + canvas->drag_offset[0]) / canvas->resolution[0];
+  transform[13] = 2.0 * (canvas->pan[1].value + canvas->drag_offset[1]) / canvas->resolution[1];
+  transform[15] = 1.0;
+
+  /* both matrices are in column-major order, as gl expects */
+  for (int col = 0; col < 4; col++)
+    for (int row = 0; row < 4; row++)
+      {
+        double sum = 0.0;
+        for (int k = 0; k < 4; k++)
+          sum += canvas->projection[k * 4 + row] * transform[col * 4 + k];
+        matrix[col * 4 + row] = sum;
+      }
+}
+
+static double
+canvas_grid_opacity (BoomerangCanvas *canvas)
+{
+  if (canvas->texture_size[0] == 0 || canvas->texture_size[1] == 0)
+    return 0.0;
+
+  /* the screenshot is stretched to fill the widget, so its pixels may not be square on screen */
+  double texel_size = MIN (canvas->resolution[0] / canvas->texture_size[0],
+                           canvas->resolution[1] / canvas->texture_size[1]);
+  texel_size *= canvas->zoom_level.value / MAX (canvas->scale_factor, 1);
+  return CLAMP (texel_size / GRID_TEXEL_SIZE - 1.0, 0.0, 1.0);
 }
 
 static gboolean
@@ -502,25 +2462,37 @@ canvas_render (GtkGLArea *widget, GdkGLContext *context)
 {
   BoomerangCanvas *canvas = BOOMERANG_CANVAS (widget);
 
+  gint64 trace_time = boomerang_trace_begin ();
+  gint64 start_time = g_get_monotonic_time ();
+
+  if (canvas->blur_dirty)
+    canvas_update_blur (canvas);
+
   glClear (GL_COLOR_BUFFER_BIT);
 
   glUseProgram (canvas->program);
   glActiveTexture (GL_TEXTURE0);
   glBindTexture (GL_TEXTURE_2D, canvas->texture);
+  glActiveTexture (GL_TEXTURE1);
+  glBindTexture (GL_TEXTURE_2D, canvas->blur_textures[0]);
   glBindVertexArray (canvas->vao);
 
-  GLint projection_loc = glGetUniformLocation (canvas->program, "projection");
-  glUniformMatrix4fv (projection_loc, 1, GL_FALSE, &canvas->projection[0]);
+  GLint screenshot_texture_loc = glGetUniformLocation (canvas->program, "screenshotTexture");
+  glUniform1i (screenshot_texture_loc, 0);
+
+  GLint blurred_texture_loc = glGetUniformLocation (canvas->program, "blurredTexture");
+  glUniform1i (blurred_texture_loc, 1);
+
+  GLfloat view[16];
+  canvas_view_matrix (canvas, view);
+  GLint view_loc = glGetUniformLocation (canvas->program, "view");
+  glUniformMatrix4fv (view_loc, 1, GL_FALSE, view);
 
   GLint resolution_loc = glGetUniformLocation (canvas->program, "resolution");
   glUniform2f (resolution_loc, canvas->resolution[0], canvas->resolution[1]);
 
-  GLint drag_pos_loc = glGetUniformLocation (canvas->program, "dragPosition");
-  glUniform2f (drag_pos_loc, canvas->drag_total[0] + canvas->drag_offset[0],
-               canvas->drag_total[1] + canvas->drag_offset[1]);
-
-  GLint zoom_level_loc = glGetUniformLocation (canvas->program, "zoomLevel");
-  glUniform1f (zoom_level_loc, canvas->zoom_level.value);
+  GLint grid_opacity_loc = glGetUniformLocation (canvas->program, "gridOpacity");
+  glUniform1f (grid_opacity_loc, canvas_grid_opacity (canvas));
 
   GLint pointer_loc = glGetUniformLocation (canvas->program, "pointer");
   glUniform2f (pointer_loc, canvas->pointer[0], canvas->pointer[1]);
@@ -528,8 +2500,35 @@ canvas_render (GtkGLArea *widget, GdkGLContext *context)
   GLint fenabled_loc = glGetUniformLocation (canvas->program, "fenabled");
   glUniform1i (fenabled_loc, canvas->flashlight_enabled);
 
-  GLint fradius_loc = glGetUniformLocation (canvas->program, "fradius");
-  glUniform1f (fradius_loc, canvas->flashlight_radius.value);
+  GLint benabled_loc = glGetUniformLocation (canvas->program, "benabled");
+  glUniform1i (benabled_loc, canvas->blur_enabled);
+
+  /* only the spotlights in use need to be sent */
+  SpotlightBlock spotlights;
+  spotlights.count = canvas_get_spotlights (canvas, spotlights.spotlight);
+  glBindBufferBase (GL_UNIFORM_BUFFER, 0, canvas->spotlight_ubo);
+  glBufferSubData (GL_UNIFORM_BUFFER, 0,
+                   G_STRUCT_OFFSET (SpotlightBlock, spotlight) + spotlights.count * sizeof (SpotlightData),
+                   &spotlights);
+
+  /* the lens is centred on the texture coordinate under the pointer */
+  double texel[2];
+  canvas_pointer_to_texel (canvas, texel);
+
+  GLint lenabled_loc = glGetUniformLocation (canvas->program, "lenabled");
+  glUniform1i (lenabled_loc, canvas->lens_enabled);
+
+  GLint lshape_loc = glGetUniformLocation (canvas->program, "lshape");
+  glUniform1i (lshape_loc, canvas->lens_shape);
+
+  GLint lcentre_loc = glGetUniformLocation (canvas->program, "lcentre");
+  glUniform2f (lcentre_loc, texel[0] / canvas->texture_size[0], texel[1] / canvas->texture_size[1]);
+
+  GLint lzoom_loc = glGetUniformLocation (canvas->program, "lzoom");
+  glUniform1f (lzoom_loc, canvas->lens_zoom.value);
+
+  GLint lradius_loc = glGetUniformLocation (canvas->program, "lradius");
+  glUniform1f (lradius_loc, canvas->lens_radius.value);
 
   /* below here uniforms used only for shader debugging */
 
@@ -546,12 +2545,188 @@ canvas_render (GtkGLArea *widget, GdkGLContext *context)
 
   glFlush ();
 
+  /* wait for the gpu while replaying so that frame timings include the time it took to draw */
+  if (canvas->replay_task)
+    {
+      glFinish ();
+      canvas_replay_frame (canvas, start_time);
+    }
+
+  boomerang_trace_end (trace_time, "Render", NULL);
   return TRUE;
 }
 
+static void
+canvas_snapshot (GtkWidget *widget, GtkSnapshot *snapshot)
+{
+  BoomerangCanvas *canvas = BOOMERANG_CANVAS (widget);
+
+  /* the gl area snapshot emits the resize and render signals, which draw using our own shaders into a frame buffer
+   * that gsk then composites, the alternative is to describe the scene directly as render nodes */
+  if (canvas->renderer != BOOMERANG_RENDERER_GSK)
+    {
+      GTK_WIDGET_CLASS (boomerang_canvas_parent_class)->snapshot (widget, snapshot);
+
+      /* the inspector is composited over the frame buffer by gsk, so it never has to wait on our rendering */
+      if (canvas->inspector_enabled)
+        canvas_snapshot_inspector (canvas, snapshot, gtk_widget_get_width (widget), gtk_widget_get_height (widget));
+      return;
+    }
+
+  gint64 trace_time = boomerang_trace_begin ();
+  gint64 start_time = g_get_monotonic_time ();
+
+  /* input handling works in frame buffer coordinates, so track the resolution in the same way the gl renderer does
+   * and convert back to widget coordinates here */
+  float width = gtk_widget_get_width (widget);
+  float height = gtk_widget_get_height (widget);
+  float scale = canvas->scale_factor = gtk_widget_get_scale_factor (widget);
+  canvas->resolution[0] = width * scale;
+  canvas->resolution[1] = height * scale;
+
+  graphene_rect_t bounds = GRAPHENE_RECT_INIT (0, 0, width, height);
+  gtk_snapshot_append_color (snapshot, &(GdkRGBA){ 0, 0, 0, 1 }, &bounds);
+  if (!canvas->gdk_texture)
+    {
+      boomerang_trace_end (trace_time, "Snapshot", "No screenshot");
+      return;
+    }
+
+  gtk_snapshot_push_clip (snapshot, &bounds);
+
+  /* the screenshot is stretched over the widget and zoomed about its centre, then offset by the drag position,
+   * which has an inverted y-axis compared to the widget */
+  double zoom = canvas->zoom_level.value;
+  double drag_x = (canvas->pan[0].value + canvas->drag_offset[0]) / scale;
+  double drag_y = (canvas->pan[1].value + canvas->drag_offset[1]) / scale;
+  graphene_rect_t view = GRAPHENE_RECT_INIT ((width - width * zoom) / 2 + drag_x, (height - height * zoom) / 2 - drag_y,
+                                             width * zoom, height * zoom);
+  gtk_snapshot_append_scaled_texture (snapshot, canvas->gdk_texture, GSK_SCALING_FILTER_NEAREST, &view);
+
+  /* the pixel grid is a single texel with a line along two of its edges, repeated over the visible part of the view */
+  double grid_opacity = canvas_grid_opacity (canvas);
+  graphene_rect_t visible;
+  if (grid_opacity > 0.0 && graphene_rect_intersection (&view, &bounds, &visible))
+    {
+      float texel_width = view.size.width / canvas->texture_size[0];
+      float texel_height = view.size.height / canvas->texture_size[1];
+      float line = 1.0f / scale;
+      const GdkRGBA grey = { 0.5, 0.5, 0.5, grid_opacity * 0.4 };
+      gtk_snapshot_push_repeat (snapshot, &visible,
+                                &GRAPHENE_RECT_INIT (view.origin.x, view.origin.y, texel_width, texel_height));
+      gtk_snapshot_append_color (snapshot, &grey,
+                                 &GRAPHENE_RECT_INIT (view.origin.x, view.origin.y, texel_width, line));
+      gtk_snapshot_append_color (snapshot, &grey,
+                                 &GRAPHENE_RECT_INIT (view.origin.x, view.origin.y + line, line, texel_height - line));
+      gtk_snapshot_pop (snapshot);
+    }
+
+  graphene_point_t pointer = GRAPHENE_POINT_INIT (canvas->pointer[0] / scale, height - canvas->pointer[1] / scale);
+  float divisor = MIN (width, height) / 2;
+
+  SpotlightData spotlights[MAX_SPOTLIGHTS];
+  int count = canvas_get_spotlights (canvas, spotlights);
+  if (count > 0)
+    {
+      /* darken everything outside the union of the spotlights, which are drawn into the mask as rounded clips that
+       * gsk anti-aliases for us, an ellipse being a rounded rectangle whose corners are as big as the rectangle */
+      gtk_snapshot_push_mask (snapshot, GSK_MASK_MODE_INVERTED_ALPHA);
+      for (int i = 0; i < count; i++)
+        {
+          const GLfloat *geometry = spotlights[i].geometry;
+          graphene_size_t size = GRAPHENE_SIZE_INIT (geometry[2] * divisor, geometry[3] * divisor);
+          graphene_size_t corner = GRAPHENE_SIZE_INIT (spotlights[i].params[1] * divisor,
+                                                       spotlights[i].params[1] * divisor);
+          if (spotlights[i].params[0] == SPOTLIGHT_SHAPE_CIRCLE || spotlights[i].params[0] == SPOTLIGHT_SHAPE_ELLIPSE)
+            corner = size;
+
+          GskRoundedRect outline;
+          gsk_rounded_rect_init (&outline,
+                                 &GRAPHENE_RECT_INIT (width / 2 + geometry[0] * divisor - size.width,
+                                                      height / 2 - geometry[1] * divisor - size.height,
+                                                      size.width * 2, size.height * 2),
+                                 &corner, &corner, &corner, &corner);
+          gtk_snapshot_push_rounded_clip (snapshot, &outline);
+          gtk_snapshot_append_color (snapshot, &(GdkRGBA){ 0, 0, 0, 1 }, &outline.bounds);
+          gtk_snapshot_pop (snapshot);
+        }
+      gtk_snapshot_pop (snapshot);
+      gtk_snapshot_append_color (snapshot, &(GdkRGBA){ 0, 0, 0, 0.6 }, &bounds);
+      gtk_snapshot_pop (snapshot);
+    }
+
+  if (canvas->lens_enabled)
+    {
+      float radius = canvas->lens_radius.value * divisor;
+      GskRoundedRect outline;
+      if (canvas->lens_shape == LENS_SHAPE_ROUNDED_RECT)
+        gsk_rounded_rect_init_from_rect (
+            &outline, &GRAPHENE_RECT_INIT (pointer.x - radius * 1.6f, pointer.y - radius, radius * 3.2f, radius * 2),
+            radius * 0.25f);
+      else
+        gsk_rounded_rect_init_from_rect (
+            &outline, &GRAPHENE_RECT_INIT (pointer.x - radius, pointer.y - radius, radius * 2, radius * 2), radius);
+
+      /* magnify the main view about the point under the pointer */
+      float lens_zoom = canvas->lens_zoom.value;
+      graphene_rect_t lens = GRAPHENE_RECT_INIT (
+          pointer.x - (pointer.x - view.origin.x) * lens_zoom, pointer.y - (pointer.y - view.origin.y) * lens_zoom,
+          view.size.width * lens_zoom, view.size.height * lens_zoom);
+
+      gtk_snapshot_push_rounded_clip (snapshot, &outline);
+      gtk_snapshot_append_color (snapshot, &(GdkRGBA){ 0, 0, 0, 1 }, &outline.bounds);
+      gtk_snapshot_append_scaled_texture (snapshot, canvas->gdk_texture, GSK_SCALING_FILTER_NEAREST, &lens);
+      gtk_snapshot_pop (snapshot);
+
+      const GdkRGBA white = { 1, 1, 1, 0.8 };
+      gtk_snapshot_append_border (snapshot, &outline, (float[4]){ 2, 2, 2, 2 },
+                                  (GdkRGBA[4]){ white, white, white, white });
+    }
+
+  if (canvas->inspector_enabled)
+    canvas_snapshot_inspector (canvas, snapshot, width, height);
+
+  gtk_snapshot_pop (snapshot);
+
+  /* gsk draws the nodes later, on its own, so only the time taken to describe them can be measured here */
+  canvas_replay_frame (canvas, start_time);
+
+  boomerang_trace_end (trace_time, "Snapshot", NULL);
+}
+
+/* gsk draws the scene itself, so the gl area is skipped when realizing to avoid making a gl context that would never
+ * be used, the gl area copes with having none when it is unrealized */
+static void
+boomerang_canvas_realize (GtkWidget *widget)
+{
+  if (BOOMERANG_CANVAS (widget)->renderer == BOOMERANG_RENDERER_GSK)
+    GTK_WIDGET_CLASS (g_type_class_peek (GTK_TYPE_WIDGET))->realize (widget);
+  else
+    GTK_WIDGET_CLASS (boomerang_canvas_parent_class)->realize (widget);
+}
+
+static void
+boomerang_canvas_finalize (GObject *object)
+{
+  BoomerangCanvas *canvas = BOOMERANG_CANVAS (object);
+
+  g_clear_pointer (&canvas->slides, g_ptr_array_unref);
+  g_free (canvas->filename);
+  g_array_unref (canvas->pins);
+
+  G_OBJECT_CLASS (boomerang_canvas_parent_class)->finalize (object);
+}
+
 static void
 boomerang_canvas_class_init (BoomerangCanvasClass *klass)
 {
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  object_class->finalize = boomerang_canvas_finalize;
+
+  GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
+  widget_class->realize = boomerang_canvas_realize;
+  widget_class->snapshot = canvas_snapshot;
+
   GtkGLAreaClass *glarea_class = GTK_GL_AREA_CLASS (klass);
   glarea_class->resize = canvas_resize;
   glarea_class->render = canvas_render;
@@ -560,6 +2735,8 @@ boomerang_canvas_class_init (BoomerangCanvasClass *klass)
 static void
 boomerang_canvas_init (BoomerangCanvas *canvas)
 {
+  canvas->pins = g_array_new (FALSE, FALSE, sizeof (PinnedSpotlight));
+
   g_signal_connect (canvas, "realize", G_CALLBACK (canvas_realize), NULL);
   g_signal_connect (canvas, "unrealize", G_CALLBACK (canvas_unrealize), NULL);
 }
@@ -569,6 +2746,211 @@ boomerang_canvas_set_filename (BoomerangCanvas *canvas, const char *filename)
 {
   g_return_if_fail (BOOMERANG_IS_CANVAS (canvas));
 
+  gboolean realized = gtk_widget_get_realized (GTK_WIDGET (canvas));
+  if (realized && canvas->renderer != BOOMERANG_RENDERER_GSK)
+    gtk_gl_area_make_current (GTK_GL_AREA (canvas));
+
+  canvas_clear_slides (canvas);
+  g_free (canvas->filename);
   canvas->filename = g_strdup (filename);
+
+  /* replace the screenshot if we are already rendering one, otherwise it will be loaded when we are realized */
+  if (realized)
+    {
+      GError *error = NULL;
+      if (!canvas_load_screenshot (canvas, &error))
+        canvas_set_error (canvas, error);
+      gtk_gl_area_queue_render (GTK_GL_AREA (canvas));
+    }
+}
+
+/* shows a deck of screenshots one at a time instead of a single screenshot, starting with the first, those either side
+ * of the one shown being decoded in the background so that paging through them is immediate */
+void
+boomerang_canvas_set_slides (BoomerangCanvas *canvas, const char *const *filenames)
+{
+  g_return_if_fail (BOOMERANG_IS_CANVAS (canvas));
+  g_return_if_fail (filenames && filenames[0]);
+
+  gboolean realized = gtk_widget_get_realized (GTK_WIDGET (canvas));
+  if (realized && canvas->renderer != BOOMERANG_RENDERER_GSK)
+    gtk_gl_area_make_current (GTK_GL_AREA (canvas));
+
+  canvas_clear_slides (canvas);
+  canvas->slides = g_ptr_array_new_with_free_func ((GDestroyNotify)slide_free);
+  for (guint i = 0; filenames[i]; i++)
+    g_ptr_array_add (canvas->slides, slide_new (filenames[i]));
+  canvas->slide = 0;
+
+  /* replace what we are already rendering, otherwise the first slide will be loaded when we are realized */
+  if (realized)
+    {
+      GError *error = NULL;
+      if (!canvas_show_slide (canvas, 0, &error))
+        canvas_set_error (canvas, error);
+      gtk_gl_area_queue_render (GTK_GL_AREA (canvas));
+    }
+}
+
+/* chooses how the canvas is drawn, this must be called before the canvas is realized */
+void
+boomerang_canvas_set_renderer (BoomerangCanvas *canvas, BoomerangRenderer renderer)
+{
+  g_return_if_fail (BOOMERANG_IS_CANVAS (canvas));
+  g_return_if_fail (!gtk_widget_get_realized (GTK_WIDGET (canvas)));
+
+  canvas->renderer = renderer;
+}
+
+/* limits the memory taken up by the screenshot textures to about this many bytes by storing them in smaller formats,
+ * and lets go of the pixels once they have been uploaded, this applies from the next screenshot to be loaded and
+ * zero means no limit */
+void
+boomerang_canvas_set_memory_budget (BoomerangCanvas *canvas, gsize budget)
+{
+  g_return_if_fail (BOOMERANG_IS_CANVAS (canvas));
+
+  canvas->memory_budget = budget;
+}
+
+/* adds the next screenshot to be loaded to the history once it has been decoded, and only that one */
+void
+boomerang_canvas_set_history (BoomerangCanvas *canvas, gboolean history)
+{
+  g_return_if_fail (BOOMERANG_IS_CANVAS (canvas));
+
+  canvas->history = history;
+}
+
+/* shows only the given area of a screenshot of the whole desktop, both rectangles being in logical desktop
+ * coordinates, this must be called before setting the filename, passing NULL shows the whole screenshot */
+void
+boomerang_canvas_set_crop (BoomerangCanvas *canvas, const GdkRectangle *area, const GdkRectangle *desktop)
+{
+  g_return_if_fail (BOOMERANG_IS_CANVAS (canvas));
+  g_return_if_fail (!area || desktop);
+
+  canvas->crop_enabled = area && desktop->width > 0 && desktop->height > 0;
+  if (canvas->crop_enabled)
+    {
+      canvas->crop_area = *area;
+      canvas->crop_desktop = *desktop;
+    }
+}
+
+/* zooms and pans so that the given region of the screenshot, in screenshot pixels, fills the screen */
+void
+boomerang_canvas_zoom_to (BoomerangCanvas *canvas, const GdkRectangle *region, double duration)
+{
+  g_return_if_fail (BOOMERANG_IS_CANVAS (canvas));
+
+  /* nothing to position relative to until a screenshot has been loaded */
+  if (!canvas->texture_size[0])
+    return;
+
+  canvas_zoom_to_region (canvas, region, duration);
+}
+
+/* moves the view across the screenshot by the given distance in screenshot pixels */
+void
+boomerang_canvas_pan (BoomerangCanvas *canvas, double dx, double dy, double duration)
+{
+  g_return_if_fail (BOOMERANG_IS_CANVAS (canvas));
+
+  if (!canvas->texture_size[0])
+    return;
+
+  double zoom = animatable_final_value (&canvas->zoom_level);
+  double delta[2] = { -dx, dy };
+  for (int i = 0; i < 2; i++)
+    {
+      double limit = (canvas->resolution[i] * zoom - canvas->resolution[i]) / 2.0;
+      double drag = animatable_final_value (&canvas->pan[i]);
+      drag += delta[i] * canvas->resolution[i] / canvas->texture_size[i] * zoom;
+      canvas_animate_for (canvas, &canvas->pan[i], CLAMP (drag, -limit, limit), duration);
+    }
+}
+
+/* centres the flashlight on the given point, with the given radius, both in screenshot pixels at the zoom level that
+ * any running animation will end up at, where it stays rather than following the pointer until it is switched off,
+ * a radius of zero switches off the flashlight */
+void
+boomerang_canvas_set_flashlight (BoomerangCanvas *canvas, double x, double y, double radius, double duration)
+{
+  g_return_if_fail (BOOMERANG_IS_CANVAS (canvas));
+
+  if (!canvas->texture_size[0])
+    return;
+
+  if (radius <= 0)
+    {
+      canvas->flashlight_enabled = 0;
+      canvas->flashlight_placed = FALSE;
+      gtk_gl_area_queue_render (GTK_GL_AREA (canvas));
+      return;
+    }
+
+  canvas->flashlight_placed = TRUE;
+  canvas->flashlight_texel[0] = x;
+  canvas->flashlight_texel[1] = y;
+
+  /* the flashlight radius is kept relative to the shorter side of the frame buffer, like the spotlight geometry, the
+   * screenshot may be stretched by different amounts along each axis but the flashlight stays round, so it is given
+   * the same area as the circle asked for */
+  double stretch = sqrt ((double)canvas->resolution[0] / canvas->texture_size[0] * canvas->resolution[1]
+                         / canvas->texture_size[1]);
+  double scale = animatable_final_value (&canvas->zoom_level) * stretch;
+  double relative = 2.0 * radius * scale / MIN (canvas->resolution[0], canvas->resolution[1]);
+  canvas->flashlight_enabled = 1;
+  canvas_animate_for (canvas, &canvas->flashlight_radius, relative, duration);
+  gtk_gl_area_queue_render (GTK_GL_AREA (canvas));
+}
+
+/* records all input made on the canvas to the given session, which must outlive the recording */
+void
+boomerang_canvas_record (BoomerangCanvas *canvas, BoomerangSession *session)
+{
+  g_return_if_fail (BOOMERANG_IS_CANVAS (canvas));
+  g_return_if_fail (!canvas->replay_task);
+
+  canvas->session = session;
+  canvas->record_start = g_get_monotonic_time ();
+}
+
+/* feeds the input recorded in the session back through the same handlers that received it, advancing the recording by
+ * one frame at sixty frames per second for every frame drawn, and adds the time each frame took to the session */
+void
+boomerang_canvas_replay_async (BoomerangCanvas *canvas, BoomerangSession *session, GCancellable *cancellable,
+                               GAsyncReadyCallback callback, gpointer data)
+{
+  g_return_if_fail (BOOMERANG_IS_CANVAS (canvas));
+  g_return_if_fail (session != NULL);
+
+  if (canvas->replay_task)
+    {
+      g_task_report_new_error (canvas, callback, data, boomerang_canvas_replay_async, G_IO_ERROR, G_IO_ERROR_PENDING,
+                               "A replay is already running");
+      return;
+    }
+
+  guint n_events;
+  const BoomerangSessionEvent *events = boomerang_session_get_events (session, &n_events);
+
+  canvas->session = session;
+  canvas->replay_task = g_task_new (canvas, cancellable, callback, data);
+  g_task_set_source_tag (canvas->replay_task, boomerang_canvas_replay_async);
+  canvas->replay_started = FALSE;
+  canvas->replay_time = 0;
+  canvas->replay_end = (n_events > 0 ? events[n_events - 1].time : 0) + ANIMATION_DURATION * G_USEC_PER_SEC;
+  canvas->replay_interval = 0;
+  canvas->replay_next = 0;
+  canvas->replay_id = gtk_widget_add_tick_callback (GTK_WIDGET (canvas), canvas_replay_tick, NULL, NULL);
 }
 
+gboolean
+boomerang_canvas_replay_finish (BoomerangCanvas *canvas, GAsyncResult *result, GError **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, canvas), FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
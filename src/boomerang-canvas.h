@@ -21,14 +21,45 @@
 
 #include <gtk/gtk.h>
 
+#include "boomerang-session.h"
+
 G_BEGIN_DECLS
 
 #define BOOMERANG_TYPE_CANVAS (boomerang_canvas_get_type ())
 
 G_DECLARE_FINAL_TYPE (BoomerangCanvas, boomerang_canvas, BOOMERANG, CANVAS, GtkGLArea)
 
+typedef enum
+{
+  BOOMERANG_RENDERER_GL,
+  BOOMERANG_RENDERER_GSK,
+} BoomerangRenderer;
+
+void boomerang_canvas_set_crop (BoomerangCanvas *canvas, const GdkRectangle *area, const GdkRectangle *desktop);
+
+void boomerang_canvas_set_renderer (BoomerangCanvas *canvas, BoomerangRenderer renderer);
+
+void boomerang_canvas_set_memory_budget (BoomerangCanvas *canvas, gsize budget);
+
+void boomerang_canvas_set_history (BoomerangCanvas *canvas, gboolean history);
+
 void boomerang_canvas_set_filename (BoomerangCanvas *canvas, const char *filename);
 
+void boomerang_canvas_set_slides (BoomerangCanvas *canvas, const char *const *filenames);
+
+void boomerang_canvas_zoom_to (BoomerangCanvas *canvas, const GdkRectangle *region, double duration);
+
+void boomerang_canvas_pan (BoomerangCanvas *canvas, double dx, double dy, double duration);
+
+void boomerang_canvas_set_flashlight (BoomerangCanvas *canvas, double x, double y, double radius, double duration);
+
+void boomerang_canvas_record (BoomerangCanvas *canvas, BoomerangSession *session);
+
+void boomerang_canvas_replay_async (BoomerangCanvas *canvas, BoomerangSession *session, GCancellable *cancellable,
+                                    GAsyncReadyCallback callback, gpointer data);
+
+gboolean boomerang_canvas_replay_finish (BoomerangCanvas *canvas, GAsyncResult *result, GError **error);
+
 G_END_DECLS
 
 #endif /* BOOMERANG_CANVAS_H_ */
@@ -0,0 +1,87 @@
+/* Copyright 2026 Mat Booth
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "boomerang-capture-backend.h"
+
+G_DEFINE_INTERFACE (BoomerangCaptureBackend, boomerang_capture_backend, G_TYPE_OBJECT)
+
+static void
+boomerang_capture_backend_default_init (BoomerangCaptureBackendInterface *iface)
+{
+}
+
+const char *
+boomerang_capture_backend_get_name (BoomerangCaptureBackend *backend)
+{
+  g_return_val_if_fail (BOOMERANG_IS_CAPTURE_BACKEND (backend), NULL);
+
+  return BOOMERANG_CAPTURE_BACKEND_GET_IFACE (backend)->get_name (backend);
+}
+
+void
+boomerang_capture_backend_probe (BoomerangCaptureBackend *backend, GCancellable *cancellable,
+                                 GAsyncReadyCallback callback, gpointer data)
+{
+  g_return_if_fail (BOOMERANG_IS_CAPTURE_BACKEND (backend));
+
+  BOOMERANG_CAPTURE_BACKEND_GET_IFACE (backend)->probe (backend, cancellable, callback, data);
+}
+
+gboolean
+boomerang_capture_backend_probe_finish (BoomerangCaptureBackend *backend, GAsyncResult *result, GError **error)
+{
+  g_return_val_if_fail (BOOMERANG_IS_CAPTURE_BACKEND (backend), FALSE);
+
+  return BOOMERANG_CAPTURE_BACKEND_GET_IFACE (backend)->probe_finish (backend, result, error);
+}
+
+void
+boomerang_capture_backend_capture (BoomerangCaptureBackend *backend, GCancellable *cancellable,
+                                   GAsyncReadyCallback callback, gpointer data)
+{
+  g_return_if_fail (BOOMERANG_IS_CAPTURE_BACKEND (backend));
+
+  BOOMERANG_CAPTURE_BACKEND_GET_IFACE (backend)->capture (backend, cancellable, callback, data);
+}
+
+char *
+boomerang_capture_backend_capture_finish (BoomerangCaptureBackend *backend, GAsyncResult *result, GError **error)
+{
+  g_return_val_if_fail (BOOMERANG_IS_CAPTURE_BACKEND (backend), NULL);
+
+  return BOOMERANG_CAPTURE_BACKEND_GET_IFACE (backend)->capture_finish (backend, result, error);
+}
+
+gboolean
+boomerang_capture_backend_can_capture_area (BoomerangCaptureBackend *backend)
+{
+  g_return_val_if_fail (BOOMERANG_IS_CAPTURE_BACKEND (backend), FALSE);
+
+  return BOOMERANG_CAPTURE_BACKEND_GET_IFACE (backend)->capture_area != NULL;
+}
+
+/* captures only the given area of the desktop, in logical desktop coordinates */
+void
+boomerang_capture_backend_capture_area (BoomerangCaptureBackend *backend, const GdkRectangle *area,
+                                        GCancellable *cancellable, GAsyncReadyCallback callback, gpointer data)
+{
+  g_return_if_fail (BOOMERANG_IS_CAPTURE_BACKEND (backend));
+  g_return_if_fail (boomerang_capture_backend_can_capture_area (backend));
+
+  BOOMERANG_CAPTURE_BACKEND_GET_IFACE (backend)->capture_area (backend, area, cancellable, callback, data);
+}
@@ -0,0 +1,72 @@
+/* Copyright 2026 Mat Booth
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef BOOMERANG_CAPTURE_BACKEND_H_
+#define BOOMERANG_CAPTURE_BACKEND_H_
+
+#include <gdk/gdk.h>
+
+G_BEGIN_DECLS
+
+#define BOOMERANG_TYPE_CAPTURE_BACKEND (boomerang_capture_backend_get_type ())
+
+G_DECLARE_INTERFACE (BoomerangCaptureBackend, boomerang_capture_backend, BOOMERANG, CAPTURE_BACKEND, GObject)
+
+/* a way of getting a screenshot, probing determines whether the backend can work at all on this system, and capturing
+ * returns the URI of a newly taken screenshot, backends that can capture just part of the desktop also implement
+ * capture_area, which is finished in the same way */
+struct _BoomerangCaptureBackendInterface
+{
+  GTypeInterface parent_iface;
+
+  const char *(*get_name) (BoomerangCaptureBackend *backend);
+
+  void (*probe) (BoomerangCaptureBackend *backend, GCancellable *cancellable, GAsyncReadyCallback callback,
+                 gpointer data);
+  gboolean (*probe_finish) (BoomerangCaptureBackend *backend, GAsyncResult *result, GError **error);
+
+  void (*capture) (BoomerangCaptureBackend *backend, GCancellable *cancellable, GAsyncReadyCallback callback,
+                   gpointer data);
+  char *(*capture_finish) (BoomerangCaptureBackend *backend, GAsyncResult *result, GError **error);
+
+  void (*capture_area) (BoomerangCaptureBackend *backend, const GdkRectangle *area, GCancellable *cancellable,
+                        GAsyncReadyCallback callback, gpointer data);
+};
+
+const char *boomerang_capture_backend_get_name (BoomerangCaptureBackend *backend);
+
+void boomerang_capture_backend_probe (BoomerangCaptureBackend *backend, GCancellable *cancellable,
+                                      GAsyncReadyCallback callback, gpointer data);
+
+gboolean boomerang_capture_backend_probe_finish (BoomerangCaptureBackend *backend, GAsyncResult *result,
+                                                 GError **error);
+
+void boomerang_capture_backend_capture (BoomerangCaptureBackend *backend, GCancellable *cancellable,
+                                        GAsyncReadyCallback callback, gpointer data);
+
+char *boomerang_capture_backend_capture_finish (BoomerangCaptureBackend *backend, GAsyncResult *result,
+                                                GError **error);
+
+gboolean boomerang_capture_backend_can_capture_area (BoomerangCaptureBackend *backend);
+
+void boomerang_capture_backend_capture_area (BoomerangCaptureBackend *backend, const GdkRectangle *area,
+                                             GCancellable *cancellable, GAsyncReadyCallback callback, gpointer data);
+
+G_END_DECLS
+
+#endif /* BOOMERANG_CAPTURE_BACKEND_H_ */
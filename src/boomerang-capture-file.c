@@ -0,0 +1,220 @@
+/* Copyright 2026 Mat Booth
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "boomerang-capture-file.h"
+
+struct _BoomerangCaptureFile
+{
+  GObject parent_instance;
+
+  /* the file to use as the screenshot, or "-" to read it from standard input */
+  char *filename;
+
+  /* standard input can only be read once, so keep a copy for any later captures, which is deleted along with us */
+  GFile *stdin_copy;
+};
+
+static void capture_file_iface_init (BoomerangCaptureBackendInterface *iface);
+
+G_DEFINE_FINAL_TYPE_WITH_CODE (BoomerangCaptureFile, boomerang_capture_file, G_TYPE_OBJECT,
+                               G_IMPLEMENT_INTERFACE (BOOMERANG_TYPE_CAPTURE_BACKEND, capture_file_iface_init))
+
+static const char *
+capture_file_get_name (BoomerangCaptureBackend *backend)
+{
+  return "file";
+}
+
+static void
+capture_file_probe (BoomerangCaptureBackend *backend, GCancellable *cancellable, GAsyncReadyCallback callback,
+                    gpointer data)
+{
+  /* the file is only checked when it is captured, so that it may be created or replaced in the meantime */
+  GTask *task = g_task_new (backend, cancellable, callback, data);
+  g_task_return_boolean (task, TRUE);
+  g_object_unref (task);
+}
+
+static gboolean
+capture_file_probe_finish (BoomerangCaptureBackend *backend, GAsyncResult *result, GError **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, backend), FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+typedef struct
+{
+  GFile *copy;
+  GFileIOStream *iostream;
+} StdinCapture;
+
+static void
+stdin_capture_free (StdinCapture *capture)
+{
+  g_object_unref (capture->copy);
+  g_object_unref (capture->iostream);
+  g_free (capture);
+}
+
+static void
+file_stdin_splice_cb (GObject *object, GAsyncResult *result, gpointer data)
+{
+  g_autoptr (GTask) task = data;
+  BoomerangCaptureFile *self = g_task_get_source_object (task);
+  StdinCapture *capture = g_task_get_task_data (task);
+
+  GError *error = NULL;
+  if (g_output_stream_splice_finish (G_OUTPUT_STREAM (object), result, &error) < 0)
+    {
+      g_file_delete (capture->copy, NULL, NULL);
+      g_task_return_error (task, error);
+      return;
+    }
+
+  g_set_object (&self->stdin_copy, capture->copy);
+  g_task_return_pointer (task, g_file_get_uri (capture->copy), g_free);
+}
+
+static void
+file_stdin_read_cb (GObject *object, GAsyncResult *result, gpointer data)
+{
+  g_autoptr (GTask) task = data;
+  StdinCapture *capture = g_task_get_task_data (task);
+
+  GError *error = NULL;
+  g_autoptr (GFileInputStream) input = g_file_read_finish (G_FILE (object), result, &error);
+  if (!input)
+    {
+      g_task_return_error (task, error);
+      return;
+    }
+
+  GOutputStream *output = g_io_stream_get_output_stream (G_IO_STREAM (capture->iostream));
+  g_output_stream_splice_async (output, G_INPUT_STREAM (input),
+                                G_OUTPUT_STREAM_SPLICE_CLOSE_SOURCE | G_OUTPUT_STREAM_SPLICE_CLOSE_TARGET,
+                                G_PRIORITY_DEFAULT, g_task_get_cancellable (task), file_stdin_splice_cb,
+                                g_object_ref (task));
+}
+
+static void
+file_query_cb (GObject *object, GAsyncResult *result, gpointer data)
+{
+  g_autoptr (GTask) task = data;
+
+  GError *error = NULL;
+  g_autoptr (GFileInfo) info = g_file_query_info_finish (G_FILE (object), result, &error);
+  if (!info)
+    {
+      g_task_return_error (task, error);
+      return;
+    }
+
+  g_task_return_pointer (task, g_file_get_uri (G_FILE (object)), g_free);
+}
+
+static void
+capture_file_capture (BoomerangCaptureBackend *backend, GCancellable *cancellable, GAsyncReadyCallback callback,
+                      gpointer data)
+{
+  BoomerangCaptureFile *self = BOOMERANG_CAPTURE_FILE (backend);
+
+  GTask *task = g_task_new (self, cancellable, callback, data);
+
+  if (self->stdin_copy)
+    {
+      g_task_return_pointer (task, g_file_get_uri (self->stdin_copy), g_free);
+      g_object_unref (task);
+      return;
+    }
+
+  if (g_strcmp0 (self->filename, "-") == 0)
+    {
+      /* copy standard input to a temporary file, because the canvas loads screenshots by name */
+      GError *error = NULL;
+      StdinCapture *capture = g_new0 (StdinCapture, 1);
+      capture->copy = g_file_new_tmp ("boomerang-XXXXXX", &capture->iostream, &error);
+      if (!capture->copy)
+        {
+          g_free (capture);
+          g_task_return_error (task, error);
+          g_object_unref (task);
+          return;
+        }
+      g_task_set_task_data (task, capture, (GDestroyNotify)stdin_capture_free);
+
+      g_autoptr (GFile) input = g_file_new_for_path ("/dev/stdin");
+      g_file_read_async (input, G_PRIORITY_DEFAULT, cancellable, file_stdin_read_cb, task);
+      return;
+    }
+
+  g_autoptr (GFile) file = g_file_new_for_commandline_arg (self->filename);
+  g_file_query_info_async (file, G_FILE_ATTRIBUTE_STANDARD_TYPE, G_FILE_QUERY_INFO_NONE, G_PRIORITY_DEFAULT,
+                           cancellable, file_query_cb, task);
+}
+
+static char *
+capture_file_capture_finish (BoomerangCaptureBackend *backend, GAsyncResult *result, GError **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, backend), NULL);
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+static void
+capture_file_iface_init (BoomerangCaptureBackendInterface *iface)
+{
+  iface->get_name = capture_file_get_name;
+  iface->probe = capture_file_probe;
+  iface->probe_finish = capture_file_probe_finish;
+  iface->capture = capture_file_capture;
+  iface->capture_finish = capture_file_capture_finish;
+}
+
+static void
+boomerang_capture_file_finalize (GObject *object)
+{
+  BoomerangCaptureFile *self = BOOMERANG_CAPTURE_FILE (object);
+
+  g_free (self->filename);
+  if (self->stdin_copy)
+    g_file_delete (self->stdin_copy, NULL, NULL);
+  g_clear_object (&self->stdin_copy);
+
+  G_OBJECT_CLASS (boomerang_capture_file_parent_class)->finalize (object);
+}
+
+static void
+boomerang_capture_file_class_init (BoomerangCaptureFileClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  object_class->finalize = boomerang_capture_file_finalize;
+}
+
+static void
+boomerang_capture_file_init (BoomerangCaptureFile *self)
+{
+}
+
+BoomerangCaptureBackend *
+boomerang_capture_file_new (const char *filename)
+{
+  BoomerangCaptureFile *self = g_object_new (BOOMERANG_TYPE_CAPTURE_FILE, NULL);
+  self->filename = g_strdup (filename);
+  return BOOMERANG_CAPTURE_BACKEND (self);
+}
@@ -0,0 +1,258 @@
+/* Copyright 2026 Mat Booth
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "boomerang-capture-portal.h"
+#include "boomerang-trace.h"
+
+#define PORTAL_BUS "org.freedesktop.portal.Desktop"
+#define PORTAL_PATH "/org/freedesktop/portal/desktop"
+#define PORTAL_SCREENSHOT "org.freedesktop.portal.Screenshot"
+
+struct _BoomerangCapturePortal
+{
+  GObject parent_instance;
+
+  GDBusConnection *conn;
+
+  /* state of the request in progress */
+  GTask *task;
+  char *object_path;
+  guint signal_id;
+  gulong cancelled_id;
+
+  gint64 request_time;
+};
+
+static void capture_portal_iface_init (BoomerangCaptureBackendInterface *iface);
+
+G_DEFINE_FINAL_TYPE_WITH_CODE (BoomerangCapturePortal, boomerang_capture_portal, G_TYPE_OBJECT,
+                               G_IMPLEMENT_INTERFACE (BOOMERANG_TYPE_CAPTURE_BACKEND, capture_portal_iface_init))
+
+static void
+portal_cleanup (BoomerangCapturePortal *bs)
+{
+  g_clear_signal_handler (&bs->cancelled_id, g_task_get_cancellable (bs->task));
+  g_clear_object (&bs->task);
+
+  if (bs->signal_id)
+    g_dbus_connection_signal_unsubscribe (bs->conn, bs->signal_id);
+  bs->signal_id = 0;
+
+  g_clear_pointer (&bs->object_path, g_free);
+}
+
+static void
+portal_response_cb (GDBusConnection *bus, const char *sender_name, const char *object_path,
+                    const char *interface_name, const char *signal_name, GVariant *parameters, gpointer data)
+{
+  BoomerangCapturePortal *bs = BOOMERANG_CAPTURE_PORTAL (data);
+
+  unsigned int response;
+  g_autoptr (GVariant) results = NULL;
+  g_variant_get (parameters, "(u@a{sv})", &response, &results);
+
+  boomerang_trace_end (bs->request_time, "Portal request", "Response %u", response);
+
+  if (response == 0)
+    {
+      const char *uri = NULL;
+      if (g_variant_lookup (results, "uri", "&s", &uri))
+        g_task_return_pointer (bs->task, g_strdup (uri), g_free);
+      else
+        g_task_return_new_error (bs->task, G_IO_ERROR, G_IO_ERROR_FAILED, "Unable to retrieve URI to screenshot");
+    }
+  else if (response == 1)
+    {
+      g_task_return_new_error (bs->task, G_IO_ERROR, G_IO_ERROR_CANCELLED, "Screenshot taking was cancelled");
+    }
+  else
+    {
+      g_task_return_new_error (bs->task, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to take screenshot");
+    }
+
+  portal_cleanup (bs);
+}
+
+static void
+portal_cancelled_cb (GCancellable *cancellable, gpointer data)
+{
+  BoomerangCapturePortal *bs = BOOMERANG_CAPTURE_PORTAL (data);
+
+  /* cancel the in-progress screenshot request, a response signal will not be sent */
+  g_dbus_connection_call (bs->conn, PORTAL_BUS, bs->object_path, "org.freedesktop.portal.Request", "Close", NULL, NULL,
+                          G_DBUS_CALL_FLAGS_NONE, -1, NULL, NULL, NULL);
+
+  boomerang_trace_end (bs->request_time, "Portal request", "Cancelled");
+
+  g_task_return_new_error (bs->task, G_IO_ERROR, G_IO_ERROR_CANCELLED, "Screenshot taking was cancelled");
+
+  portal_cleanup (bs);
+}
+
+static void
+portal_screenshot_cb (GObject *object, GAsyncResult *result, gpointer data)
+{
+  BoomerangCapturePortal *bs = BOOMERANG_CAPTURE_PORTAL (data);
+
+  /* portal methods return the object path for the request whose response signal we need to observe for the results of
+   * the call, but we discard it here because we computed it earlier and are already subscribed */
+
+  GError *error = NULL;
+  g_autoptr (GVariant) ret_val = g_dbus_connection_call_finish (G_DBUS_CONNECTION (object), result, &error);
+
+  if (error)
+    {
+      boomerang_trace_end (bs->request_time, "Portal request", "Error: %s", error->message);
+      g_task_return_error (bs->task, error);
+      portal_cleanup (bs);
+    }
+}
+
+static const char *
+capture_portal_get_name (BoomerangCaptureBackend *backend)
+{
+  return "portal";
+}
+
+static void
+portal_probe_cb (GObject *object, GAsyncResult *result, gpointer data)
+{
+  g_autoptr (GTask) task = data;
+
+  /* reading the version of the screenshot interface starts the portal if it is activatable, and fails if the
+   * portal does not implement screenshots at all */
+  GError *error = NULL;
+  g_autoptr (GVariant) ret_val = g_dbus_connection_call_finish (G_DBUS_CONNECTION (object), result, &error);
+  if (error)
+    g_task_return_error (task, error);
+  else
+    g_task_return_boolean (task, TRUE);
+}
+
+static void
+capture_portal_probe (BoomerangCaptureBackend *backend, GCancellable *cancellable, GAsyncReadyCallback callback,
+                      gpointer data)
+{
+  BoomerangCapturePortal *self = BOOMERANG_CAPTURE_PORTAL (backend);
+
+  GTask *task = g_task_new (self, cancellable, callback, data);
+  g_dbus_connection_call (self->conn, PORTAL_BUS, PORTAL_PATH, "org.freedesktop.DBus.Properties", "Get",
+                          g_variant_new ("(ss)", PORTAL_SCREENSHOT, "version"), G_VARIANT_TYPE ("(v)"),
+                          G_DBUS_CALL_FLAGS_NONE, -1, cancellable, portal_probe_cb, task);
+}
+
+static gboolean
+capture_portal_probe_finish (BoomerangCaptureBackend *backend, GAsyncResult *result, GError **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, backend), FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+static void
+capture_portal_capture (BoomerangCaptureBackend *backend, GCancellable *cancellable, GAsyncReadyCallback callback,
+                        gpointer data)
+{
+  BoomerangCapturePortal *self = BOOMERANG_CAPTURE_PORTAL (backend);
+
+  if (self->task)
+    {
+      g_task_report_new_error (self, callback, data, capture_portal_capture, G_IO_ERROR, G_IO_ERROR_PENDING,
+                               "A screenshot is already being taken");
+      return;
+    }
+
+  self->task = g_task_new (self, cancellable, callback, data);
+
+  /* compute object path on which to listen for the request response signal */
+  g_autofree char *token = g_strdup_printf ("boomerang_%d", g_random_int_range (0, G_MAXINT));
+  g_autofree char *sender = g_strdup (g_dbus_connection_get_unique_name (self->conn) + 1);
+  for (int i = 0; sender[i]; i++)
+    if (sender[i] == '.')
+      sender[i] = '_';
+  self->object_path = g_strconcat ("/org/freedesktop/portal/desktop/request/", sender, "/", token, NULL);
+
+  /* subscribe to the request response signal on the object path computed above */
+  self->signal_id = g_dbus_connection_signal_subscribe (self->conn, PORTAL_BUS, "org.freedesktop.portal.Request",
+                                                        "Response", self->object_path, NULL,
+                                                        G_DBUS_SIGNAL_FLAGS_NO_MATCH_RULE, portal_response_cb, self, NULL);
+
+  /* register cancellation callback */
+  if (cancellable)
+    self->cancelled_id = g_signal_connect (cancellable, "cancelled", G_CALLBACK (portal_cancelled_cb), self);
+
+  /* create input parameters for the screenshot portal request */
+  GVariantBuilder *builder = g_variant_builder_new (G_VARIANT_TYPE ("a{sv}"));
+  g_variant_builder_add (builder, "{sv}", "interactive", g_variant_new_boolean (FALSE));
+  g_variant_builder_add (builder, "{sv}", "handle_token", g_variant_new_string (token));
+  GVariant *params = g_variant_new ("(sa{sv})", "", builder);
+  g_variant_builder_unref (builder);
+
+  /* https://flatpak.github.io/xdg-desktop-portal/docs/doc-org.freedesktop.portal.Screenshot.html */
+  self->request_time = boomerang_trace_begin ();
+  g_dbus_connection_call (self->conn, PORTAL_BUS, PORTAL_PATH, PORTAL_SCREENSHOT, "Screenshot", params,
+                          G_VARIANT_TYPE ("(o)"), G_DBUS_CALL_FLAGS_NONE, -1, NULL, portal_screenshot_cb, self);
+}
+
+static char *
+capture_portal_capture_finish (BoomerangCaptureBackend *backend, GAsyncResult *result, GError **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, backend), NULL);
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+static void
+capture_portal_iface_init (BoomerangCaptureBackendInterface *iface)
+{
+  iface->get_name = capture_portal_get_name;
+  iface->probe = capture_portal_probe;
+  iface->probe_finish = capture_portal_probe_finish;
+  iface->capture = capture_portal_capture;
+  iface->capture_finish = capture_portal_capture_finish;
+}
+
+static void
+boomerang_capture_portal_dispose (GObject *object)
+{
+  BoomerangCapturePortal *self = BOOMERANG_CAPTURE_PORTAL (object);
+
+  g_clear_object (&self->conn);
+
+  G_OBJECT_CLASS (boomerang_capture_portal_parent_class)->dispose (object);
+}
+
+static void
+boomerang_capture_portal_class_init (BoomerangCapturePortalClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  object_class->dispose = boomerang_capture_portal_dispose;
+}
+
+static void
+boomerang_capture_portal_init (BoomerangCapturePortal *self)
+{
+}
+
+BoomerangCaptureBackend *
+boomerang_capture_portal_new (GDBusConnection *connection)
+{
+  BoomerangCapturePortal *self = g_object_new (BOOMERANG_TYPE_CAPTURE_PORTAL, NULL);
+  self->conn = g_object_ref (connection);
+  return BOOMERANG_CAPTURE_BACKEND (self);
+}
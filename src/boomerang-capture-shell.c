@@ -0,0 +1,243 @@
+/* Copyright 2026 Mat Booth
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "boomerang-capture-shell.h"
+#include "boomerang-trace.h"
+
+#include <glib/gstdio.h>
+
+#define SHELL_BUS "org.gnome.Shell.Screenshot"
+#define SHELL_PATH "/org/gnome/Shell/Screenshot"
+
+struct _BoomerangCaptureShell
+{
+  GObject parent_instance;
+
+  GDBusConnection *conn;
+
+  /* temporary file holding the most recent screenshot, kept for as long as it may still be shown and deleted once
+   * it is replaced by the next one or the backend goes away */
+  char *filename;
+};
+
+static void capture_shell_iface_init (BoomerangCaptureBackendInterface *iface);
+
+G_DEFINE_FINAL_TYPE_WITH_CODE (BoomerangCaptureShell, boomerang_capture_shell, G_TYPE_OBJECT,
+                               G_IMPLEMENT_INTERFACE (BOOMERANG_TYPE_CAPTURE_BACKEND, capture_shell_iface_init))
+
+static const char *
+capture_shell_get_name (BoomerangCaptureBackend *backend)
+{
+  return "shell";
+}
+
+static void
+shell_probe_cb (GObject *object, GAsyncResult *result, gpointer data)
+{
+  g_autoptr (GTask) task = data;
+
+  GError *error = NULL;
+  g_autoptr (GVariant) ret_val = g_dbus_connection_call_finish (G_DBUS_CONNECTION (object), result, &error);
+  if (error)
+    {
+      g_task_return_error (task, error);
+      return;
+    }
+
+  gboolean has_owner;
+  g_variant_get (ret_val, "(b)", &has_owner);
+  if (has_owner)
+    g_task_return_boolean (task, TRUE);
+  else
+    g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED, "GNOME Shell is not running");
+}
+
+static void
+capture_shell_probe (BoomerangCaptureBackend *backend, GCancellable *cancellable, GAsyncReadyCallback callback,
+                     gpointer data)
+{
+  BoomerangCaptureShell *self = BOOMERANG_CAPTURE_SHELL (backend);
+
+  /* the shell is never activated on demand, so it is only available if it is already running, whether we are
+   * permitted to use it is only discovered when we try, since recent versions only allow trusted callers */
+  GTask *task = g_task_new (self, cancellable, callback, data);
+  g_dbus_connection_call (self->conn, "org.freedesktop.DBus", "/org/freedesktop/DBus", "org.freedesktop.DBus",
+                          "NameHasOwner", g_variant_new ("(s)", SHELL_BUS), G_VARIANT_TYPE ("(b)"),
+                          G_DBUS_CALL_FLAGS_NONE, -1, cancellable, shell_probe_cb, task);
+}
+
+static gboolean
+capture_shell_probe_finish (BoomerangCaptureBackend *backend, GAsyncResult *result, GError **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, backend), FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+typedef struct
+{
+  char *filename;
+  gint64 request_time;
+} ShellCapture;
+
+static void
+shell_capture_free (ShellCapture *capture)
+{
+  g_free (capture->filename);
+  g_free (capture);
+}
+
+static void
+shell_screenshot_cb (GObject *object, GAsyncResult *result, gpointer data)
+{
+  g_autoptr (GTask) task = data;
+  BoomerangCaptureShell *self = g_task_get_source_object (task);
+  ShellCapture *capture = g_task_get_task_data (task);
+
+  GError *error = NULL;
+  g_autoptr (GVariant) ret_val = g_dbus_connection_call_finish (G_DBUS_CONNECTION (object), result, &error);
+  if (error)
+    {
+      boomerang_trace_end (capture->request_time, "Shell request", "Error: %s", error->message);
+      g_unlink (capture->filename);
+      g_task_return_error (task, error);
+      return;
+    }
+
+  gboolean success;
+  const char *filename_used;
+  g_variant_get (ret_val, "(b&s)", &success, &filename_used);
+
+  boomerang_trace_end (capture->request_time, "Shell request", "Success %d", success);
+
+  if (!success)
+    {
+      g_unlink (capture->filename);
+      g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to take screenshot");
+      return;
+    }
+
+  /* the shell may write somewhere other than the file we made for it, which is then left empty */
+  if (g_strcmp0 (filename_used, capture->filename) != 0)
+    g_unlink (capture->filename);
+
+  if (self->filename)
+    g_unlink (self->filename);
+  g_free (self->filename);
+  self->filename = g_strdup (filename_used);
+  g_task_return_pointer (task, g_filename_to_uri (filename_used, NULL, NULL), g_free);
+}
+
+static void
+shell_capture (BoomerangCaptureShell *self, const GdkRectangle *area, GCancellable *cancellable,
+               GAsyncReadyCallback callback, gpointer data)
+{
+  GTask *task = g_task_new (self, cancellable, callback, data);
+
+  /* the shell writes the screenshot to a file of our choosing */
+  GError *error = NULL;
+  ShellCapture *capture = g_new0 (ShellCapture, 1);
+  int fd = g_file_open_tmp ("boomerang-XXXXXX.png", &capture->filename, &error);
+  g_task_set_task_data (task, capture, (GDestroyNotify)shell_capture_free);
+  if (fd < 0)
+    {
+      g_task_return_error (task, error);
+      g_object_unref (task);
+      return;
+    }
+  g_close (fd, NULL);
+
+  /* https://gitlab.gnome.org/GNOME/gnome-shell/-/blob/main/data/dbus-interfaces/org.gnome.Shell.Screenshot.xml */
+  capture->request_time = boomerang_trace_begin ();
+  if (area)
+    g_dbus_connection_call (self->conn, SHELL_BUS, SHELL_PATH, "org.gnome.Shell.Screenshot", "ScreenshotArea",
+                            g_variant_new ("(iiiibs)", area->x, area->y, area->width, area->height, FALSE,
+                                           capture->filename),
+                            G_VARIANT_TYPE ("(bs)"), G_DBUS_CALL_FLAGS_NONE, -1, cancellable, shell_screenshot_cb,
+                            task);
+  else
+    g_dbus_connection_call (self->conn, SHELL_BUS, SHELL_PATH, "org.gnome.Shell.Screenshot", "Screenshot",
+                            g_variant_new ("(bbs)", FALSE, FALSE, capture->filename), G_VARIANT_TYPE ("(bs)"),
+                            G_DBUS_CALL_FLAGS_NONE, -1, cancellable, shell_screenshot_cb, task);
+}
+
+static void
+capture_shell_capture (BoomerangCaptureBackend *backend, GCancellable *cancellable, GAsyncReadyCallback callback,
+                       gpointer data)
+{
+  shell_capture (BOOMERANG_CAPTURE_SHELL (backend), NULL, cancellable, callback, data);
+}
+
+static void
+capture_shell_capture_area (BoomerangCaptureBackend *backend, const GdkRectangle *area, GCancellable *cancellable,
+                            GAsyncReadyCallback callback, gpointer data)
+{
+  shell_capture (BOOMERANG_CAPTURE_SHELL (backend), area, cancellable, callback, data);
+}
+
+static char *
+capture_shell_capture_finish (BoomerangCaptureBackend *backend, GAsyncResult *result, GError **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, backend), NULL);
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+static void
+capture_shell_iface_init (BoomerangCaptureBackendInterface *iface)
+{
+  iface->get_name = capture_shell_get_name;
+  iface->probe = capture_shell_probe;
+  iface->probe_finish = capture_shell_probe_finish;
+  iface->capture = capture_shell_capture;
+  iface->capture_finish = capture_shell_capture_finish;
+  iface->capture_area = capture_shell_capture_area;
+}
+
+static void
+boomerang_capture_shell_dispose (GObject *object)
+{
+  BoomerangCaptureShell *self = BOOMERANG_CAPTURE_SHELL (object);
+
+  g_clear_object (&self->conn);
+  if (self->filename)
+    g_unlink (self->filename);
+  g_clear_pointer (&self->filename, g_free);
+
+  G_OBJECT_CLASS (boomerang_capture_shell_parent_class)->dispose (object);
+}
+
+static void
+boomerang_capture_shell_class_init (BoomerangCaptureShellClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  object_class->dispose = boomerang_capture_shell_dispose;
+}
+
+static void
+boomerang_capture_shell_init (BoomerangCaptureShell *self)
+{
+}
+
+BoomerangCaptureBackend *
+boomerang_capture_shell_new (GDBusConnection *connection)
+{
+  BoomerangCaptureShell *self = g_object_new (BOOMERANG_TYPE_CAPTURE_SHELL, NULL);
+  self->conn = g_object_ref (connection);
+  return BOOMERANG_CAPTURE_BACKEND (self);
+}
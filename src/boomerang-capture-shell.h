@@ -0,0 +1,34 @@
+/* Copyright 2026 Mat Booth
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef BOOMERANG_CAPTURE_SHELL_H_
+#define BOOMERANG_CAPTURE_SHELL_H_
+
+#include "boomerang-capture-backend.h"
+
+G_BEGIN_DECLS
+
+#define BOOMERANG_TYPE_CAPTURE_SHELL (boomerang_capture_shell_get_type ())
+
+G_DECLARE_FINAL_TYPE (BoomerangCaptureShell, boomerang_capture_shell, BOOMERANG, CAPTURE_SHELL, GObject)
+
+BoomerangCaptureBackend *boomerang_capture_shell_new (GDBusConnection *connection);
+
+G_END_DECLS
+
+#endif /* BOOMERANG_CAPTURE_SHELL_H_ */
@@ -0,0 +1,438 @@
+/* Copyright 2026 Mat Booth
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "boomerang-compress.h"
+#include "boomerang-parallel.h"
+#include "boomerang-trace.h"
+
+#include <limits.h>
+#include <math.h>
+
+/* rows are handed to worker threads in bands of this many, which is a whole number of blocks */
+#define BAND_ROWS 32
+
+/* both compressed formats store each block of 4x4 pixels in 64 bits */
+#define BLOCK_BYTES 8
+
+static const char *format_names[] = { "rgba8", "rgb565", "etc2", "bc1" };
+
+/* etc2 moves every pixel in half a block away from the base colour of that half by one of the four amounts in a row
+ * of this table, the positive or negative of either column */
+static const int etc_modifiers[8][2] = {
+  { 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 }, { 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 },
+};
+
+typedef guint8 Block[16][3];
+
+typedef struct
+{
+  BoomerangTextureFormat format;
+  const guint8 *rgba;
+  int width;
+  int height;
+  guint8 *dest;
+  GCancellable *cancellable;
+} CompressJob;
+
+typedef struct
+{
+  BoomerangTextureFormat format;
+  GBytes *rgba;
+  int width;
+  int height;
+} CompressData;
+
+static void
+compress_rgb565_rows (const guint8 *rgba, int width, int rows, guint16 *dest)
+{
+  for (gsize i = 0; i < (gsize)width * rows; i++, rgba += 4)
+    dest[i] = (rgba[0] * 31 + 127) / 255 << 11 | (rgba[1] * 63 + 127) / 255 << 5 | (rgba[2] * 31 + 127) / 255;
+}
+
+/* copies out the block with its top left corner at the given pixel, repeating the last row and column of the image
+ * over any part of the block that lies beyond its edges */
+static void
+read_block (const guint8 *rgba, int width, int height, int left, int top, Block block)
+{
+  for (int y = 0; y < 4; y++)
+    for (int x = 0; x < 4; x++)
+      {
+        const guint8 *pixel = rgba + ((gsize)MIN (top + y, height - 1) * width + MIN (left + x, width - 1)) * 4;
+        block[y * 4 + x][0] = pixel[0];
+        block[y * 4 + x][1] = pixel[1];
+        block[y * 4 + x][2] = pixel[2];
+      }
+}
+
+static int
+colour_error (const int *colour, const guint8 *pixel)
+{
+  int error = 0;
+  for (int c = 0; c < 3; c++)
+    error += (colour[c] - pixel[c]) * (colour[c] - pixel[c]);
+  return error;
+}
+
+/* picks the row of modifiers that best fits half of a block to its base colour, adding the index chosen for each
+ * pixel to the indices of the block and returning the squared error */
+static int
+etc_fit_half (const Block block, int flip, int half, const int *base, int *table, guint32 *indices)
+{
+  int best_error = INT_MAX;
+  guint32 best_indices = 0;
+
+  for (int t = 0; t < 8; t++)
+    {
+      int error = 0;
+      guint32 bits = 0;
+      for (int i = 0; i < 8 && error < best_error; i++)
+        {
+          /* the halves are the left and right pairs of columns, or the top and bottom pairs of rows when flipped */
+          int x = flip ? i % 4 : half * 2 + i / 4;
+          int y = flip ? half * 2 + i / 4 : i % 4;
+          const guint8 *pixel = block[y * 4 + x];
+
+          /* the modifier is added to every channel, so the one nearest the mean difference from the base colour
+           * is the best fit except where the channels are clamped */
+          int offset = pixel[0] + pixel[1] + pixel[2] - base[0] - base[1] - base[2];
+          int best_index = ABS (ABS (offset) - 3 * etc_modifiers[t][1]) < ABS (ABS (offset) - 3 * etc_modifiers[t][0]);
+          if (offset < 0)
+            best_index |= 2;
+          int modifier = (best_index & 2 ? -1 : 1) * etc_modifiers[t][best_index & 1];
+          int colour[3] = { CLAMP (base[0] + modifier, 0, 255), CLAMP (base[1] + modifier, 0, 255),
+                            CLAMP (base[2] + modifier, 0, 255) };
+          error += colour_error (colour, pixel);
+
+          /* pixels are numbered down the columns, with the high bits of their indices in the upper half word */
+          int position = x * 4 + y;
+          bits |= (guint32)(best_index >> 1) << (16 + position) | (guint32)(best_index & 1) << position;
+        }
+
+      if (error < best_error)
+        {
+          best_error = error;
+          best_indices = bits;
+          *table = t;
+        }
+    }
+
+  *indices |= best_indices;
+  return best_error;
+}
+
+/* encodes a block in the individual or differential modes etc2 shares with etc1, trying both ways of splitting the
+ * block in half and keeping whichever gives the smallest error */
+static void
+etc2_encode_block (const Block block, guint8 *dest)
+{
+  int best_error = INT_MAX;
+
+  for (int flip = 0; flip < 2; flip++)
+    {
+      int sums[2][3] = { { 0 } };
+      for (int i = 0; i < 16; i++)
+        for (int c = 0; c < 3; c++)
+          sums[flip ? i / 8 : i % 4 / 2][c] += block[i][c];
+
+      /* each half has its own four bit base colour, or if they are close enough, the first has a five bit colour and
+       * the second a three bit difference from it */
+      int individual[2][3], differential[2][3];
+      gboolean can_differ = TRUE;
+      for (int c = 0; c < 3; c++)
+        {
+          for (int half = 0; half < 2; half++)
+            {
+              individual[half][c] = (sums[half][c] * 15 + 1020) / 2040;
+              differential[half][c] = (sums[half][c] * 31 + 1020) / 2040;
+            }
+          int difference = differential[1][c] - differential[0][c];
+          can_differ = can_differ && difference >= -4 && difference <= 3;
+        }
+
+      for (int diff = 0; diff < 2; diff++)
+        {
+          if (diff && !can_differ)
+            continue;
+
+          int base[2][3];
+          for (int half = 0; half < 2; half++)
+            for (int c = 0; c < 3; c++)
+              base[half][c] = diff ? differential[half][c] << 3 | differential[half][c] >> 2 : individual[half][c] * 17;
+
+          int tables[2];
+          guint32 indices = 0;
+          int error = etc_fit_half (block, flip, 0, base[0], &tables[0], &indices);
+          if (error >= best_error)
+            continue;
+          error += etc_fit_half (block, flip, 1, base[1], &tables[1], &indices);
+          if (error >= best_error)
+            continue;
+
+          best_error = error;
+          for (int c = 0; c < 3; c++)
+            dest[c] = diff ? differential[0][c] << 3 | ((differential[1][c] - differential[0][c]) & 7)
+                           : individual[0][c] << 4 | individual[1][c];
+          dest[3] = tables[0] << 5 | tables[1] << 2 | diff << 1 | flip;
+          dest[4] = indices >> 24;
+          dest[5] = indices >> 16;
+          dest[6] = indices >> 8;
+          dest[7] = indices;
+        }
+    }
+}
+
+static guint16
+pack_rgb565 (const guint8 *rgb)
+{
+  return (rgb[0] * 31 + 127) / 255 << 11 | (rgb[1] * 63 + 127) / 255 << 5 | (rgb[2] * 31 + 127) / 255;
+}
+
+static void
+unpack_rgb565 (guint16 packed, int *rgb)
+{
+  rgb[0] = (packed >> 11) << 3 | (packed >> 13);
+  rgb[1] = (packed >> 5 & 0x3f) << 2 | (packed >> 9 & 0x3);
+  rgb[2] = (packed & 0x1f) << 3 | (packed >> 2 & 0x7);
+}
+
+/* encodes a block as two end points and two colours between them, taking the pixels furthest apart along the main
+ * axis of the colours in the block as the end points, which is found with a few rounds of power iteration */
+static void
+bc1_encode_block (const Block block, guint8 *dest)
+{
+  double mean[3] = { 0 };
+  for (int i = 0; i < 16; i++)
+    for (int c = 0; c < 3; c++)
+      mean[c] += block[i][c] / 16.0;
+
+  double covariance[3][3] = { { 0 } };
+  for (int i = 0; i < 16; i++)
+    for (int a = 0; a < 3; a++)
+      for (int b = 0; b < 3; b++)
+        covariance[a][b] += (block[i][a] - mean[a]) * (block[i][b] - mean[b]);
+
+  double axis[3] = { 1, 1, 1 };
+  for (int round = 0; round < 4; round++)
+    {
+      double next[3], largest = 0;
+      for (int a = 0; a < 3; a++)
+        {
+          next[a] = covariance[a][0] * axis[0] + covariance[a][1] * axis[1] + covariance[a][2] * axis[2];
+          largest = MAX (largest, fabs (next[a]));
+        }
+      if (largest < 1e-6)
+        break;
+      for (int a = 0; a < 3; a++)
+        axis[a] = next[a] / largest;
+    }
+
+  int first = 0, last = 0;
+  double lowest = G_MAXDOUBLE, highest = -G_MAXDOUBLE;
+  for (int i = 0; i < 16; i++)
+    {
+      double projection = 0;
+      for (int c = 0; c < 3; c++)
+        projection += (block[i][c] - mean[c]) * axis[c];
+      if (projection < lowest)
+        {
+          lowest = projection;
+          last = i;
+        }
+      if (projection > highest)
+        {
+          highest = projection;
+          first = i;
+        }
+    }
+
+  /* the first end point must be the larger for the block to be read as four colours */
+  guint16 ends[2] = { pack_rgb565 (block[first]), pack_rgb565 (block[last]) };
+  if (ends[0] < ends[1])
+    {
+      guint16 swap = ends[0];
+      ends[0] = ends[1];
+      ends[1] = swap;
+    }
+
+  guint32 indices = 0;
+  if (ends[0] != ends[1])
+    {
+      int colours[4][3];
+      unpack_rgb565 (ends[0], colours[0]);
+      unpack_rgb565 (ends[1], colours[1]);
+      for (int c = 0; c < 3; c++)
+        {
+          colours[2][c] = (2 * colours[0][c] + colours[1][c]) / 3;
+          colours[3][c] = (colours[0][c] + 2 * colours[1][c]) / 3;
+        }
+
+      /* pixels are numbered along the rows, two bits each from the bottom of the word */
+      for (int i = 0; i < 16; i++)
+        {
+          int best_index = 0;
+          int best_error = colour_error (colours[0], block[i]);
+          for (int index = 1; index < 4; index++)
+            {
+              int error = colour_error (colours[index], block[i]);
+              if (error < best_error)
+                {
+                  best_error = error;
+                  best_index = index;
+                }
+            }
+          indices |= (guint32)best_index << (i * 2);
+        }
+    }
+
+  dest[0] = ends[0];
+  dest[1] = ends[0] >> 8;
+  dest[2] = ends[1];
+  dest[3] = ends[1] >> 8;
+  dest[4] = indices;
+  dest[5] = indices >> 8;
+  dest[6] = indices >> 16;
+  dest[7] = indices >> 24;
+}
+
+static void
+compress_band (guint index, gpointer data)
+{
+  CompressJob *job = data;
+  int top = index * BAND_ROWS;
+  int rows = MIN (BAND_ROWS, job->height - top);
+
+  if (g_cancellable_is_cancelled (job->cancellable))
+    return;
+
+  if (job->format == BOOMERANG_TEXTURE_FORMAT_RGB565)
+    {
+      compress_rgb565_rows (job->rgba + (gsize)top * job->width * 4, job->width, rows,
+                            (guint16 *)job->dest + (gsize)top * job->width);
+      return;
+    }
+
+  int columns = (job->width + 3) / 4;
+  Block block;
+  for (int y = top; y < top + rows; y += 4)
+    for (int x = 0; x < job->width; x += 4)
+      {
+        guint8 *dest = job->dest + ((gsize)(y / 4) * columns + x / 4) * BLOCK_BYTES;
+        read_block (job->rgba, job->width, job->height, x, y, block);
+        if (job->format == BOOMERANG_TEXTURE_FORMAT_ETC2)
+          etc2_encode_block (block, dest);
+        else
+          bc1_encode_block (block, dest);
+      }
+}
+
+/* returns the number of bytes needed to store an image in the given format */
+gsize
+boomerang_compress_get_size (BoomerangTextureFormat format, int width, int height)
+{
+  switch (format)
+    {
+    case BOOMERANG_TEXTURE_FORMAT_RGBA8:
+      return (gsize)width * height * 4;
+    case BOOMERANG_TEXTURE_FORMAT_RGB565:
+      return (gsize)width * height * 2;
+    case BOOMERANG_TEXTURE_FORMAT_ETC2:
+    case BOOMERANG_TEXTURE_FORMAT_BC1:
+      return (gsize)((width + 3) / 4) * ((height + 3) / 4) * BLOCK_BYTES;
+    default:
+      g_return_val_if_reached (0);
+    }
+}
+
+const char *
+boomerang_compress_format_name (BoomerangTextureFormat format)
+{
+  g_return_val_if_fail (format < G_N_ELEMENTS (format_names), NULL);
+
+  return format_names[format];
+}
+
+/* converts tightly packed rgba to one of the smaller formats, spreading the rows across all processors, alpha is
+ * dropped since screenshots are always opaque */
+void
+boomerang_compress (BoomerangTextureFormat format, const guint8 *rgba, int width, int height, guint8 *dest)
+{
+  g_return_if_fail (format != BOOMERANG_TEXTURE_FORMAT_RGBA8 && format < G_N_ELEMENTS (format_names));
+
+  CompressJob job = { format, rgba, width, height, dest, NULL };
+  boomerang_parallel_for ((height + BAND_ROWS - 1) / BAND_ROWS, compress_band, &job);
+}
+
+static void
+compress_data_free (CompressData *data)
+{
+  g_bytes_unref (data->rgba);
+  g_free (data);
+}
+
+static void
+compress_thread (GTask *task, gpointer source, gpointer task_data, GCancellable *cancellable)
+{
+  CompressData *data = task_data;
+
+  gint64 trace_time = boomerang_trace_begin ();
+
+  gsize size = boomerang_compress_get_size (data->format, data->width, data->height);
+  guint8 *dest = g_malloc (size);
+  CompressJob job = { data->format, g_bytes_get_data (data->rgba, NULL), data->width, data->height, dest, cancellable };
+  boomerang_parallel_for ((data->height + BAND_ROWS - 1) / BAND_ROWS, compress_band, &job);
+
+  if (g_task_return_error_if_cancelled (task))
+    {
+      boomerang_trace_end (trace_time, "Compress", "Cancelled");
+      g_free (dest);
+      return;
+    }
+
+  boomerang_trace_end (trace_time, "Compress", "%dx%d, %s", data->width, data->height,
+                       boomerang_compress_format_name (data->format));
+
+  g_task_return_pointer (task, g_bytes_new_take (dest, size), (GDestroyNotify)g_bytes_unref);
+}
+
+/* compresses on a worker thread, for the block formats that take too long to encode before the first frame */
+void
+boomerang_compress_async (BoomerangTextureFormat format, GBytes *rgba, int width, int height,
+                          GCancellable *cancellable, GAsyncReadyCallback callback, gpointer data)
+{
+  g_return_if_fail (format != BOOMERANG_TEXTURE_FORMAT_RGBA8 && format < G_N_ELEMENTS (format_names));
+  g_return_if_fail (g_bytes_get_size (rgba) >= (gsize)width * height * 4);
+
+  CompressData *task_data = g_new (CompressData, 1);
+  task_data->format = format;
+  task_data->rgba = g_bytes_ref (rgba);
+  task_data->width = width;
+  task_data->height = height;
+
+  GTask *task = g_task_new (NULL, cancellable, callback, data);
+  g_task_set_task_data (task, task_data, (GDestroyNotify)compress_data_free);
+  g_task_run_in_thread (task, compress_thread);
+  g_object_unref (task);
+}
+
+GBytes *
+boomerang_compress_finish (GAsyncResult *result, GError **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, NULL), NULL);
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
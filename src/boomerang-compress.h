@@ -0,0 +1,48 @@
+/* Copyright 2026 Mat Booth
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef BOOMERANG_COMPRESS_H_
+#define BOOMERANG_COMPRESS_H_
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/* formats the screenshot texture may be stored in, from the largest and most faithful to the smallest */
+typedef enum
+{
+  BOOMERANG_TEXTURE_FORMAT_RGBA8,
+  BOOMERANG_TEXTURE_FORMAT_RGB565,
+  BOOMERANG_TEXTURE_FORMAT_ETC2,
+  BOOMERANG_TEXTURE_FORMAT_BC1,
+} BoomerangTextureFormat;
+
+gsize boomerang_compress_get_size (BoomerangTextureFormat format, int width, int height);
+
+const char *boomerang_compress_format_name (BoomerangTextureFormat format);
+
+void boomerang_compress (BoomerangTextureFormat format, const guint8 *rgba, int width, int height, guint8 *dest);
+
+void boomerang_compress_async (BoomerangTextureFormat format, GBytes *rgba, int width, int height,
+                               GCancellable *cancellable, GAsyncReadyCallback callback, gpointer data);
+
+GBytes *boomerang_compress_finish (GAsyncResult *result, GError **error);
+
+G_END_DECLS
+
+#endif /* BOOMERANG_COMPRESS_H_ */
@@ -0,0 +1,396 @@
+/* Copyright 2026 Mat Booth
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "boomerang-convert.h"
+#include "boomerang-parallel.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HAVE_X86_KERNELS 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#define HAVE_NEON_KERNELS 1
+#include <arm_neon.h>
+#endif
+
+/* rows are handed to worker threads in bands of this many, which is enough work to be worth the hand over */
+#define BAND_ROWS 32
+
+#define N_FORMATS (BOOMERANG_PIXEL_FORMAT_RGBA16 + 1)
+#define N_KERNELS (BOOMERANG_CONVERT_KERNEL_NEON + 1)
+
+/* converts a row of pixels to tightly packed rgba */
+typedef void (*ConvertRowFunc) (const guint8 *src, guint8 *dest, int width);
+
+static void
+rgb_row_scalar (const guint8 *src, guint8 *dest, int width)
+{
+  for (int x = 0; x < width; x++, src += 3, dest += 4)
+    {
+      dest[0] = src[0];
+      dest[1] = src[1];
+      dest[2] = src[2];
+      dest[3] = 0xff;
+    }
+}
+
+static void
+rgba_row (const guint8 *src, guint8 *dest, int width)
+{
+  memcpy (dest, src, (gsize)width * 4);
+}
+
+static void
+bgrx_row_scalar (const guint8 *src, guint8 *dest, int width)
+{
+  for (int x = 0; x < width; x++, src += 4, dest += 4)
+    {
+      dest[0] = src[2];
+      dest[1] = src[1];
+      dest[2] = src[0];
+      dest[3] = 0xff;
+    }
+}
+
+static void
+bgra_row_scalar (const guint8 *src, guint8 *dest, int width)
+{
+  for (int x = 0; x < width; x++, src += 4, dest += 4)
+    {
+      dest[0] = src[2];
+      dest[1] = src[1];
+      dest[2] = src[0];
+      dest[3] = src[3];
+    }
+}
+
+static void
+rgba16_row_scalar (const guint8 *src, guint8 *dest, int width)
+{
+  /* keeping the high byte of each component is the same as rounding down */
+  const guint16 *components = (const guint16 *)src;
+  for (int i = 0; i < width * 4; i++)
+    dest[i] = components[i] >> 8;
+}
+
+#if defined(HAVE_X86_KERNELS)
+
+__attribute__ ((target ("ssse3"))) static void
+rgb_row_ssse3 (const guint8 *src, guint8 *dest, int width)
+{
+  const __m128i shuffle = _mm_setr_epi8 (0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+  const __m128i alpha = _mm_set1_epi32 ((int)0xff000000);
+
+  /* each load reads sixteen bytes to convert four pixels, so stop while the load stays within the row */
+  int x = 0;
+  for (; x + 6 <= width; x += 4)
+    {
+      __m128i v = _mm_loadu_si128 ((const __m128i *)(src + x * 3));
+      _mm_storeu_si128 ((__m128i *)(dest + x * 4), _mm_or_si128 (_mm_shuffle_epi8 (v, shuffle), alpha));
+    }
+  rgb_row_scalar (src + x * 3, dest + x * 4, width - x);
+}
+
+__attribute__ ((target ("ssse3"))) static void
+bgrx_row_ssse3 (const guint8 *src, guint8 *dest, int width)
+{
+  const __m128i shuffle = _mm_setr_epi8 (2, 1, 0, -1, 6, 5, 4, -1, 10, 9, 8, -1, 14, 13, 12, -1);
+  const __m128i alpha = _mm_set1_epi32 ((int)0xff000000);
+
+  int x = 0;
+  for (; x + 4 <= width; x += 4)
+    {
+      __m128i v = _mm_loadu_si128 ((const __m128i *)(src + x * 4));
+      _mm_storeu_si128 ((__m128i *)(dest + x * 4), _mm_or_si128 (_mm_shuffle_epi8 (v, shuffle), alpha));
+    }
+  bgrx_row_scalar (src + x * 4, dest + x * 4, width - x);
+}
+
+__attribute__ ((target ("ssse3"))) static void
+bgra_row_ssse3 (const guint8 *src, guint8 *dest, int width)
+{
+  const __m128i shuffle = _mm_setr_epi8 (2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+  int x = 0;
+  for (; x + 4 <= width; x += 4)
+    {
+      __m128i v = _mm_loadu_si128 ((const __m128i *)(src + x * 4));
+      _mm_storeu_si128 ((__m128i *)(dest + x * 4), _mm_shuffle_epi8 (v, shuffle));
+    }
+  bgra_row_scalar (src + x * 4, dest + x * 4, width - x);
+}
+
+__attribute__ ((target ("ssse3"))) static void
+rgba16_row_ssse3 (const guint8 *src, guint8 *dest, int width)
+{
+  int x = 0;
+  for (; x + 4 <= width; x += 4)
+    {
+      __m128i a = _mm_srli_epi16 (_mm_loadu_si128 ((const __m128i *)(src + x * 8)), 8);
+      __m128i b = _mm_srli_epi16 (_mm_loadu_si128 ((const __m128i *)(src + x * 8 + 16)), 8);
+      _mm_storeu_si128 ((__m128i *)(dest + x * 4), _mm_packus_epi16 (a, b));
+    }
+  rgba16_row_scalar (src + x * 8, dest + x * 4, width - x);
+}
+
+__attribute__ ((target ("avx2"))) static void
+rgb_row_avx2 (const guint8 *src, guint8 *dest, int width)
+{
+  /* the shuffle cannot cross the two halves of the register, so four pixels are loaded into each half */
+  const __m256i shuffle = _mm256_setr_epi8 (0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1, 0, 1, 2, -1, 3, 4,
+                                            5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+  const __m256i alpha = _mm256_set1_epi32 ((int)0xff000000);
+
+  int x = 0;
+  for (; x + 10 <= width; x += 8)
+    {
+      __m128i lo = _mm_loadu_si128 ((const __m128i *)(src + x * 3));
+      __m128i hi = _mm_loadu_si128 ((const __m128i *)(src + x * 3 + 12));
+      __m256i v = _mm256_inserti128_si256 (_mm256_castsi128_si256 (lo), hi, 1);
+      _mm256_storeu_si256 ((__m256i *)(dest + x * 4), _mm256_or_si256 (_mm256_shuffle_epi8 (v, shuffle), alpha));
+    }
+  rgb_row_scalar (src + x * 3, dest + x * 4, width - x);
+}
+
+__attribute__ ((target ("avx2"))) static void
+bgrx_row_avx2 (const guint8 *src, guint8 *dest, int width)
+{
+  const __m256i shuffle = _mm256_setr_epi8 (2, 1, 0, -1, 6, 5, 4, -1, 10, 9, 8, -1, 14, 13, 12, -1, 2, 1, 0, -1, 6, 5,
+                                            4, -1, 10, 9, 8, -1, 14, 13, 12, -1);
+  const __m256i alpha = _mm256_set1_epi32 ((int)0xff000000);
+
+  int x = 0;
+  for (; x + 8 <= width; x += 8)
+    {
+      __m256i v = _mm256_loadu_si256 ((const __m256i *)(src + x * 4));
+      _mm256_storeu_si256 ((__m256i *)(dest + x * 4), _mm256_or_si256 (_mm256_shuffle_epi8 (v, shuffle), alpha));
+    }
+  bgrx_row_scalar (src + x * 4, dest + x * 4, width - x);
+}
+
+__attribute__ ((target ("avx2"))) static void
+bgra_row_avx2 (const guint8 *src, guint8 *dest, int width)
+{
+  const __m256i shuffle = _mm256_setr_epi8 (2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15, 2, 1, 0, 3, 6, 5, 4,
+                                            7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+  int x = 0;
+  for (; x + 8 <= width; x += 8)
+    {
+      __m256i v = _mm256_loadu_si256 ((const __m256i *)(src + x * 4));
+      _mm256_storeu_si256 ((__m256i *)(dest + x * 4), _mm256_shuffle_epi8 (v, shuffle));
+    }
+  bgra_row_scalar (src + x * 4, dest + x * 4, width - x);
+}
+
+__attribute__ ((target ("avx2"))) static void
+rgba16_row_avx2 (const guint8 *src, guint8 *dest, int width)
+{
+  int x = 0;
+  for (; x + 8 <= width; x += 8)
+    {
+      __m256i a = _mm256_srli_epi16 (_mm256_loadu_si256 ((const __m256i *)(src + x * 8)), 8);
+      __m256i b = _mm256_srli_epi16 (_mm256_loadu_si256 ((const __m256i *)(src + x * 8 + 32)), 8);
+
+      /* packing works within each half of the register, which leaves the pixels in the order 0, 2, 1, 3 */
+      __m256i packed = _mm256_permute4x64_epi64 (_mm256_packus_epi16 (a, b), _MM_SHUFFLE (3, 1, 2, 0));
+      _mm256_storeu_si256 ((__m256i *)(dest + x * 4), packed);
+    }
+  rgba16_row_scalar (src + x * 8, dest + x * 4, width - x);
+}
+
+#elif defined(HAVE_NEON_KERNELS)
+
+static void
+rgb_row_neon (const guint8 *src, guint8 *dest, int width)
+{
+  int x = 0;
+  for (; x + 16 <= width; x += 16)
+    {
+      uint8x16x3_t rgb = vld3q_u8 (src + x * 3);
+      uint8x16x4_t rgba = { { rgb.val[0], rgb.val[1], rgb.val[2], vdupq_n_u8 (0xff) } };
+      vst4q_u8 (dest + x * 4, rgba);
+    }
+  rgb_row_scalar (src + x * 3, dest + x * 4, width - x);
+}
+
+static void
+bgrx_row_neon (const guint8 *src, guint8 *dest, int width)
+{
+  int x = 0;
+  for (; x + 16 <= width; x += 16)
+    {
+      uint8x16x4_t bgrx = vld4q_u8 (src + x * 4);
+      uint8x16x4_t rgba = { { bgrx.val[2], bgrx.val[1], bgrx.val[0], vdupq_n_u8 (0xff) } };
+      vst4q_u8 (dest + x * 4, rgba);
+    }
+  bgrx_row_scalar (src + x * 4, dest + x * 4, width - x);
+}
+
+static void
+bgra_row_neon (const guint8 *src, guint8 *dest, int width)
+{
+  int x = 0;
+  for (; x + 16 <= width; x += 16)
+    {
+      uint8x16x4_t bgra = vld4q_u8 (src + x * 4);
+      uint8x16x4_t rgba = { { bgra.val[2], bgra.val[1], bgra.val[0], bgra.val[3] } };
+      vst4q_u8 (dest + x * 4, rgba);
+    }
+  bgra_row_scalar (src + x * 4, dest + x * 4, width - x);
+}
+
+static void
+rgba16_row_neon (const guint8 *src, guint8 *dest, int width)
+{
+  const guint16 *components = (const guint16 *)src;
+  int x = 0;
+  for (; x + 4 <= width; x += 4)
+    {
+      uint8x8_t lo = vshrn_n_u16 (vld1q_u16 (components + x * 4), 8);
+      uint8x8_t hi = vshrn_n_u16 (vld1q_u16 (components + x * 4 + 8), 8);
+      vst1q_u8 (dest + x * 4, vcombine_u8 (lo, hi));
+    }
+  rgba16_row_scalar (src + x * 8, dest + x * 4, width - x);
+}
+
+#endif
+
+/* kernels for each pixel format, in the same order as the formats */
+static const ConvertRowFunc kernels[N_KERNELS][N_FORMATS] = {
+  [BOOMERANG_CONVERT_KERNEL_SCALAR] = { rgb_row_scalar, rgba_row, bgrx_row_scalar, bgra_row_scalar, rgba16_row_scalar },
+#if defined(HAVE_X86_KERNELS)
+  [BOOMERANG_CONVERT_KERNEL_SSSE3] = { rgb_row_ssse3, rgba_row, bgrx_row_ssse3, bgra_row_ssse3, rgba16_row_ssse3 },
+  [BOOMERANG_CONVERT_KERNEL_AVX2] = { rgb_row_avx2, rgba_row, bgrx_row_avx2, bgra_row_avx2, rgba16_row_avx2 },
+#elif defined(HAVE_NEON_KERNELS)
+  [BOOMERANG_CONVERT_KERNEL_NEON] = { rgb_row_neon, rgba_row, bgrx_row_neon, bgra_row_neon, rgba16_row_neon },
+#endif
+};
+
+static const char *kernel_names[N_KERNELS] = { "scalar", "ssse3", "avx2", "neon" };
+
+static BoomerangConvertKernel active_kernel;
+
+static void
+convert_init (void)
+{
+  static gsize initialised = 0;
+  if (!g_once_init_enter (&initialised))
+    return;
+
+  /* the best kernel this cpu supports */
+  active_kernel = BOOMERANG_CONVERT_KERNEL_SCALAR;
+  for (int kernel = N_KERNELS - 1; kernel >= 0; kernel--)
+    if (boomerang_convert_kernel_supported (kernel))
+      {
+        active_kernel = kernel;
+        break;
+      }
+
+  g_once_init_leave (&initialised, 1);
+}
+
+/* converts pixels to tightly packed rgba on the calling thread, suitable for small areas */
+void
+boomerang_convert_rows (BoomerangPixelFormat format, const guint8 *src, gsize src_stride, guint8 *dest,
+                        gsize dest_stride, int width, int height)
+{
+  g_return_if_fail (format < N_FORMATS);
+
+  convert_init ();
+
+  ConvertRowFunc row = kernels[active_kernel][format];
+  for (int y = 0; y < height; y++)
+    row (src + (gsize)y * src_stride, dest + (gsize)y * dest_stride, width);
+}
+
+typedef struct
+{
+  BoomerangPixelFormat format;
+  const guint8 *src;
+  gsize src_stride;
+  guint8 *dest;
+  gsize dest_stride;
+  int width;
+  int height;
+} ConvertJob;
+
+static void
+convert_band (guint index, gpointer data)
+{
+  ConvertJob *job = data;
+  int top = index * BAND_ROWS;
+  boomerang_convert_rows (job->format, job->src + (gsize)top * job->src_stride, job->src_stride,
+                          job->dest + (gsize)top * job->dest_stride, job->dest_stride, job->width,
+                          MIN (BAND_ROWS, job->height - top));
+}
+
+/* converts pixels to tightly packed rgba, the layout every driver can upload without converting it again itself,
+ * spreading the rows across all processors */
+void
+boomerang_convert (BoomerangPixelFormat format, const guint8 *src, gsize src_stride, guint8 *dest, gsize dest_stride,
+                   int width, int height)
+{
+  g_return_if_fail (format < N_FORMATS);
+
+  ConvertJob job = { format, src, src_stride, dest, dest_stride, width, height };
+  boomerang_parallel_for ((height + BAND_ROWS - 1) / BAND_ROWS, convert_band, &job);
+}
+
+gboolean
+boomerang_convert_kernel_supported (BoomerangConvertKernel kernel)
+{
+  if (kernel >= N_KERNELS || !kernels[kernel][0])
+    return FALSE;
+
+#if defined(HAVE_X86_KERNELS)
+  if (kernel == BOOMERANG_CONVERT_KERNEL_SSSE3)
+    return __builtin_cpu_supports ("ssse3");
+  if (kernel == BOOMERANG_CONVERT_KERNEL_AVX2)
+    return __builtin_cpu_supports ("avx2");
+#endif
+  return TRUE;
+}
+
+BoomerangConvertKernel
+boomerang_convert_get_kernel (void)
+{
+  convert_init ();
+
+  return active_kernel;
+}
+
+/* overrides the kernel chosen for this cpu, for benchmarking */
+void
+boomerang_convert_set_kernel (BoomerangConvertKernel kernel)
+{
+  g_return_if_fail (boomerang_convert_kernel_supported (kernel));
+
+  convert_init ();
+
+  active_kernel = kernel;
+}
+
+const char *
+boomerang_convert_kernel_name (BoomerangConvertKernel kernel)
+{
+  g_return_val_if_fail (kernel < N_KERNELS, NULL);
+
+  return kernel_names[kernel];
+}
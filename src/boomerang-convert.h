@@ -0,0 +1,60 @@
+/* Copyright 2026 Mat Booth
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef BOOMERANG_CONVERT_H_
+#define BOOMERANG_CONVERT_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* layouts of pixel data that can be converted, sixteen bit components are in host byte order */
+typedef enum
+{
+  BOOMERANG_PIXEL_FORMAT_RGB8,
+  BOOMERANG_PIXEL_FORMAT_RGBA8,
+  BOOMERANG_PIXEL_FORMAT_BGRX8,
+  BOOMERANG_PIXEL_FORMAT_BGRA8,
+  BOOMERANG_PIXEL_FORMAT_RGBA16,
+} BoomerangPixelFormat;
+
+typedef enum
+{
+  BOOMERANG_CONVERT_KERNEL_SCALAR,
+  BOOMERANG_CONVERT_KERNEL_SSSE3,
+  BOOMERANG_CONVERT_KERNEL_AVX2,
+  BOOMERANG_CONVERT_KERNEL_NEON,
+} BoomerangConvertKernel;
+
+void boomerang_convert_rows (BoomerangPixelFormat format, const guint8 *src, gsize src_stride, guint8 *dest,
+                             gsize dest_stride, int width, int height);
+
+void boomerang_convert (BoomerangPixelFormat format, const guint8 *src, gsize src_stride, guint8 *dest,
+                        gsize dest_stride, int width, int height);
+
+gboolean boomerang_convert_kernel_supported (BoomerangConvertKernel kernel);
+
+BoomerangConvertKernel boomerang_convert_get_kernel (void);
+
+void boomerang_convert_set_kernel (BoomerangConvertKernel kernel);
+
+const char *boomerang_convert_kernel_name (BoomerangConvertKernel kernel);
+
+G_END_DECLS
+
+#endif /* BOOMERANG_CONVERT_H_ */
@@ -0,0 +1,106 @@
+/* Copyright 2026 Mat Booth
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "boomerang-history.h"
+#include "boomerang-qoi.h"
+#include "boomerang-trace.h"
+
+#include <gio/gio.h>
+#include <glib/gstdio.h>
+
+/* number of screenshots to keep */
+#define HISTORY_SIZE 10
+
+char *
+boomerang_history_get_dir (void)
+{
+  return g_build_filename (g_get_user_cache_dir (), "boomerang", "history", NULL);
+}
+
+static int
+history_compare (gconstpointer a, gconstpointer b)
+{
+  return g_strcmp0 (*(const char **)a, *(const char **)b);
+}
+
+static void
+history_prune (const char *dir)
+{
+  GDir *entries = g_dir_open (dir, 0, NULL);
+  if (!entries)
+    return;
+
+  /* entries are named by the time they were taken, so sorting them by name puts the oldest first */
+  g_autoptr (GPtrArray) names = g_ptr_array_new_with_free_func (g_free);
+  const char *name;
+  while ((name = g_dir_read_name (entries)))
+    if (g_str_has_suffix (name, ".qoi"))
+      g_ptr_array_add (names, g_strdup (name));
+  g_dir_close (entries);
+
+  g_ptr_array_sort (names, history_compare);
+  for (guint i = 0; i + HISTORY_SIZE < names->len; i++)
+    {
+      g_autofree char *path = g_build_filename (dir, g_ptr_array_index (names, i), NULL);
+      g_unlink (path);
+    }
+}
+
+static void
+history_add_thread (GTask *task, gpointer source, gpointer data, GCancellable *cancellable)
+{
+  GdkPixbuf *pixbuf = data;
+
+  gint64 trace_time = boomerang_trace_begin ();
+
+  g_autofree char *dir = boomerang_history_get_dir ();
+  g_mkdir_with_parents (dir, 0700);
+
+  /* in utc, so that the names still sort oldest first when the clocks go back */
+  g_autoptr (GDateTime) now = g_date_time_new_now_utc ();
+  g_autofree char *name = g_date_time_format (now, "%Y%m%d-%H%M%S-%f.qoi");
+  g_autofree char *path = g_build_filename (dir, name, NULL);
+
+  GError *error = NULL;
+  if (boomerang_qoi_save (pixbuf, path, &error))
+    {
+      history_prune (dir);
+    }
+  else
+    {
+      g_printerr ("Error: Unable to save screenshot history: %s\n", error->message);
+      g_error_free (error);
+    }
+
+  boomerang_trace_end (trace_time, "History", "%dx%d", gdk_pixbuf_get_width (pixbuf),
+                       gdk_pixbuf_get_height (pixbuf));
+
+  /* nothing waits for the result, but a task must always return one */
+  g_task_return_boolean (task, TRUE);
+}
+
+/* keeps a copy of the given screenshot in the user's cache directory, encoding it as qoi in the background so that
+ * it opens more quickly if it is shown again, the pixels must not be changed afterwards */
+void
+boomerang_history_add (GdkPixbuf *pixbuf)
+{
+  GTask *task = g_task_new (NULL, NULL, NULL, NULL);
+  g_task_set_task_data (task, g_object_ref (pixbuf), g_object_unref);
+  g_task_run_in_thread (task, history_add_thread);
+  g_object_unref (task);
+}
@@ -0,0 +1,89 @@
+/* Copyright 2026 Mat Booth
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "boomerang-parallel.h"
+
+typedef struct
+{
+  BoomerangParallelFunc func;
+  gpointer data;
+  guint n_items;
+
+  /* next item to be processed, shared between the calling thread and the helpers */
+  gint next;
+
+  /* helpers that have not yet finished */
+  GMutex mutex;
+  GCond cond;
+  guint helpers;
+} ParallelBatch;
+
+static GThreadPool *pool;
+
+static void
+parallel_run (ParallelBatch *batch)
+{
+  guint index;
+  while ((index = (guint)g_atomic_int_add (&batch->next, 1)) < batch->n_items)
+    batch->func (index, batch->data);
+}
+
+static void
+parallel_helper (gpointer data, gpointer user_data)
+{
+  ParallelBatch *batch = data;
+
+  parallel_run (batch);
+
+  g_mutex_lock (&batch->mutex);
+  if (--batch->helpers == 0)
+    g_cond_signal (&batch->cond);
+  g_mutex_unlock (&batch->mutex);
+}
+
+/* calls func once for every index from zero to n_items, spread over all processors, and returns when every call has
+ * returned, the calling thread does its share of the work so that it makes progress even if the pool is busy */
+void
+boomerang_parallel_for (guint n_items, BoomerangParallelFunc func, gpointer data)
+{
+  static gsize initialised = 0;
+  if (g_once_init_enter (&initialised))
+    {
+      pool = g_thread_pool_new (parallel_helper, NULL, g_get_num_processors (), FALSE, NULL);
+      g_once_init_leave (&initialised, 1);
+    }
+
+  ParallelBatch batch = { .func = func, .data = data, .n_items = n_items };
+  g_mutex_init (&batch.mutex);
+  g_cond_init (&batch.cond);
+
+  guint helpers = n_items > 1 ? MIN (n_items, (guint)g_get_num_processors ()) - 1 : 0;
+  batch.helpers = helpers;
+  for (guint i = 0; i < helpers; i++)
+    g_thread_pool_push (pool, &batch, NULL);
+
+  parallel_run (&batch);
+
+  g_mutex_lock (&batch.mutex);
+  while (batch.helpers > 0)
+    g_cond_wait (&batch.cond, &batch.mutex);
+  g_mutex_unlock (&batch.mutex);
+
+  g_mutex_clear (&batch.mutex);
+  g_cond_clear (&batch.cond);
+}
@@ -0,0 +1,500 @@
+/* Copyright 2026 Mat Booth
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/* Reads and writes images in the "Quite OK Image" format, https://qoiformat.org/qoi-specification.pdf
+ *
+ * QOI decodes many times faster than PNG, but each pixel depends on the ones before it, so a file can normally only be
+ * decoded by a single thread. Files we write are divided into bands of rows that do not depend on each other: the
+ * first pixel of each band is stored in full, runs never continue from one band into the next and only colours seen
+ * earlier in the same band are referred to by index. A table of where each band starts is appended after the end
+ * marker, where other decoders will ignore it, so the files remain valid QOI images that any decoder can read.
+ */
+
+#include "boomerang-qoi.h"
+#include "boomerang-parallel.h"
+
+#define QOI_OP_INDEX 0x00
+#define QOI_OP_DIFF 0x40
+#define QOI_OP_LUMA 0x80
+#define QOI_OP_RUN 0xc0
+#define QOI_OP_RGB 0xfe
+#define QOI_OP_RGBA 0xff
+#define QOI_MASK_2 0xc0
+
+#define QOI_HEADER_SIZE 14
+#define QOI_PADDING_SIZE 8
+#define QOI_PIXELS_MAX 400000000
+
+/* the band table is followed by the number of bands, the number of rows in each band and this magic */
+#define BAND_MAGIC "BMRB"
+#define BAND_TRAILER_SIZE 12
+
+/* number of rows in each band, small enough to give every processor plenty of bands even for small screens */
+#define BAND_ROWS 64
+
+static const guint8 qoi_padding[QOI_PADDING_SIZE] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+typedef union
+{
+  struct
+  {
+    guint8 r, g, b, a;
+  } rgba;
+  guint32 v;
+} QoiPixel;
+
+static inline guint
+qoi_hash (QoiPixel px)
+{
+  return (px.rgba.r * 3 + px.rgba.g * 5 + px.rgba.b * 7 + px.rgba.a * 11) % 64;
+}
+
+static inline int
+qoi_op_size (guint8 b1)
+{
+  if (b1 == QOI_OP_RGB)
+    return 4;
+  if (b1 == QOI_OP_RGBA)
+    return 5;
+  if ((b1 & QOI_MASK_2) == QOI_OP_LUMA)
+    return 2;
+  return 1;
+}
+
+static inline guint32
+read_be32 (const guint8 *p)
+{
+  return (guint32)p[0] << 24 | (guint32)p[1] << 16 | (guint32)p[2] << 8 | p[3];
+}
+
+static inline void
+write_be32 (guint8 *p, guint32 v)
+{
+  p[0] = v >> 24;
+  p[1] = v >> 16;
+  p[2] = v >> 8;
+  p[3] = v;
+}
+
+typedef struct
+{
+  const guint8 *pixels;
+  int width;
+  int height;
+  int rowstride;
+  int channels;
+
+  GByteArray **bands;
+} EncodeJob;
+
+static void
+encode_band (guint band, gpointer data)
+{
+  EncodeJob *job = data;
+  int first_row = band * BAND_ROWS;
+  int last_row = MIN (first_row + BAND_ROWS, job->height);
+
+  /* the worst case is every pixel stored in full */
+  GByteArray *out = g_byte_array_new ();
+  g_byte_array_set_size (out, (gsize)(last_row - first_row) * job->width * 5);
+  guint8 *buf = out->data;
+  gsize pos = 0;
+
+  QoiPixel index[64];
+  guint64 valid = 0;
+  QoiPixel prev = { .v = 0 };
+  gboolean first = TRUE;
+  int run = 0;
+
+  for (int y = first_row; y < last_row; y++)
+    {
+      const guint8 *p = job->pixels + (gsize)y * job->rowstride;
+      for (int x = 0; x < job->width; x++, p += job->channels)
+        {
+          QoiPixel px = { .rgba = { p[0], p[1], p[2], job->channels == 4 ? p[3] : 255 } };
+
+          if (px.v == prev.v && !first)
+            {
+              if (++run == 62)
+                {
+                  buf[pos++] = QOI_OP_RUN | (run - 1);
+                  run = 0;
+                }
+              continue;
+            }
+
+          if (run > 0)
+            {
+              buf[pos++] = QOI_OP_RUN | (run - 1);
+              run = 0;
+            }
+
+          guint hash = qoi_hash (px);
+          if (first)
+            {
+              /* nothing from before the band may be relied upon */
+              buf[pos++] = QOI_OP_RGBA;
+              buf[pos++] = px.rgba.r;
+              buf[pos++] = px.rgba.g;
+              buf[pos++] = px.rgba.b;
+              buf[pos++] = px.rgba.a;
+              first = FALSE;
+            }
+          else if ((valid & (G_GUINT64_CONSTANT (1) << hash)) && index[hash].v == px.v)
+            {
+              buf[pos++] = QOI_OP_INDEX | hash;
+            }
+          else if (px.rgba.a == prev.rgba.a)
+            {
+              signed char vr = px.rgba.r - prev.rgba.r;
+              signed char vg = px.rgba.g - prev.rgba.g;
+              signed char vb = px.rgba.b - prev.rgba.b;
+              signed char vg_r = vr - vg;
+              signed char vg_b = vb - vg;
+
+              if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2)
+                {
+                  buf[pos++] = QOI_OP_DIFF | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2);
+                }
+              else if (vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32 && vg_b > -9 && vg_b < 8)
+                {
+                  buf[pos++] = QOI_OP_LUMA | (vg + 32);
+                  buf[pos++] = (vg_r + 8) << 4 | (vg_b + 8);
+                }
+              else
+                {
+                  buf[pos++] = QOI_OP_RGB;
+                  buf[pos++] = px.rgba.r;
+                  buf[pos++] = px.rgba.g;
+                  buf[pos++] = px.rgba.b;
+                }
+            }
+          else
+            {
+              buf[pos++] = QOI_OP_RGBA;
+              buf[pos++] = px.rgba.r;
+              buf[pos++] = px.rgba.g;
+              buf[pos++] = px.rgba.b;
+              buf[pos++] = px.rgba.a;
+            }
+
+          index[hash] = px;
+          valid |= G_GUINT64_CONSTANT (1) << hash;
+          prev = px;
+        }
+    }
+
+  if (run > 0)
+    buf[pos++] = QOI_OP_RUN | (run - 1);
+
+  g_byte_array_set_size (out, pos);
+  job->bands[band] = out;
+}
+
+GBytes *
+boomerang_qoi_encode (GdkPixbuf *pixbuf)
+{
+  EncodeJob job = {
+    .pixels = gdk_pixbuf_read_pixels (pixbuf),
+    .width = gdk_pixbuf_get_width (pixbuf),
+    .height = gdk_pixbuf_get_height (pixbuf),
+    .rowstride = gdk_pixbuf_get_rowstride (pixbuf),
+    .channels = gdk_pixbuf_get_n_channels (pixbuf),
+  };
+  g_return_val_if_fail (job.channels == 3 || job.channels == 4, NULL);
+
+  guint n_bands = (job.height + BAND_ROWS - 1) / BAND_ROWS;
+  job.bands = g_new (GByteArray *, n_bands);
+  boomerang_parallel_for (n_bands, encode_band, &job);
+
+  gsize size = QOI_HEADER_SIZE + QOI_PADDING_SIZE + n_bands * 8 + BAND_TRAILER_SIZE;
+  for (guint i = 0; i < n_bands; i++)
+    size += job.bands[i]->len;
+
+  guint8 *out = g_malloc (size);
+  memcpy (out, "qoif", 4);
+  write_be32 (out + 4, job.width);
+  write_be32 (out + 8, job.height);
+  out[12] = job.channels;
+  out[13] = 0;
+
+  /* concatenate the bands, remembering where each one starts */
+  gsize pos = QOI_HEADER_SIZE;
+  guint64 *offsets = g_new (guint64, n_bands);
+  for (guint i = 0; i < n_bands; i++)
+    {
+      offsets[i] = pos;
+      memcpy (out + pos, job.bands[i]->data, job.bands[i]->len);
+      pos += job.bands[i]->len;
+      g_byte_array_unref (job.bands[i]);
+    }
+  memcpy (out + pos, qoi_padding, QOI_PADDING_SIZE);
+  pos += QOI_PADDING_SIZE;
+
+  for (guint i = 0; i < n_bands; i++)
+    {
+      write_be32 (out + pos, offsets[i] >> 32);
+      write_be32 (out + pos + 4, offsets[i] & 0xffffffff);
+      pos += 8;
+    }
+  write_be32 (out + pos, n_bands);
+  write_be32 (out + pos + 4, BAND_ROWS);
+  memcpy (out + pos + 8, BAND_MAGIC, 4);
+
+  g_free (offsets);
+  g_free (job.bands);
+
+  return g_bytes_new_take (out, size);
+}
+
+gboolean
+boomerang_qoi_save (GdkPixbuf *pixbuf, const char *filename, GError **error)
+{
+  g_autoptr (GBytes) bytes = boomerang_qoi_encode (pixbuf);
+  gsize size;
+  const char *data = g_bytes_get_data (bytes, &size);
+  return g_file_set_contents (filename, data, size, error);
+}
+
+gboolean
+boomerang_qoi_check (GBytes *bytes)
+{
+  gsize size;
+  const guint8 *data = g_bytes_get_data (bytes, &size);
+  return size >= QOI_HEADER_SIZE + QOI_PADDING_SIZE && memcmp (data, "qoif", 4) == 0;
+}
+
+typedef struct
+{
+  const guint8 *data;
+  guint8 *pixels;
+  int width;
+  int height;
+  int rowstride;
+  int channels;
+
+  /* rows in each band and where each band starts, the last entry being where the final band ends */
+  int band_rows;
+  gsize *offsets;
+
+  gint failed;
+} DecodeJob;
+
+static void
+decode_band (guint band, gpointer data)
+{
+  DecodeJob *job = data;
+  int first_row = band * job->band_rows;
+  int last_row = MIN (first_row + job->band_rows, job->height);
+  const guint8 *p = job->data + job->offsets[band];
+  const guint8 *end = job->data + job->offsets[band + 1];
+
+  QoiPixel index[64];
+  memset (index, 0, sizeof (index));
+  QoiPixel px = { .rgba = { 0, 0, 0, 255 } };
+  int run = 0;
+
+  for (int y = first_row; y < last_row; y++)
+    {
+      guint8 *out = job->pixels + (gsize)y * job->rowstride;
+      for (int x = 0; x < job->width; x++, out += job->channels)
+        {
+          if (run > 0)
+            {
+              run--;
+            }
+          else
+            {
+              /* the longest op is five bytes, so only ops nearer the end than that need checking individually */
+              if (G_UNLIKELY (end - p < 5) && (p >= end || end - p < qoi_op_size (p[0])))
+                {
+                  g_atomic_int_set (&job->failed, TRUE);
+                  return;
+                }
+
+              guint8 b1 = *p++;
+              if (b1 == QOI_OP_RGB)
+                {
+                  px.rgba.r = p[0];
+                  px.rgba.g = p[1];
+                  px.rgba.b = p[2];
+                  p += 3;
+                }
+              else if (b1 == QOI_OP_RGBA)
+                {
+                  px.rgba.r = p[0];
+                  px.rgba.g = p[1];
+                  px.rgba.b = p[2];
+                  px.rgba.a = p[3];
+                  p += 4;
+                }
+              else if ((b1 & QOI_MASK_2) == QOI_OP_INDEX)
+                {
+                  px = index[b1];
+                }
+              else if ((b1 & QOI_MASK_2) == QOI_OP_DIFF)
+                {
+                  px.rgba.r += ((b1 >> 4) & 0x03) - 2;
+                  px.rgba.g += ((b1 >> 2) & 0x03) - 2;
+                  px.rgba.b += (b1 & 0x03) - 2;
+                }
+              else if ((b1 & QOI_MASK_2) == QOI_OP_LUMA)
+                {
+                  guint8 b2 = *p++;
+                  int vg = (b1 & 0x3f) - 32;
+                  px.rgba.r += vg - 8 + ((b2 >> 4) & 0x0f);
+                  px.rgba.g += vg;
+                  px.rgba.b += vg - 8 + (b2 & 0x0f);
+                }
+              else
+                {
+                  run = b1 & 0x3f;
+                }
+              index[qoi_hash (px)] = px;
+            }
+
+          out[0] = px.rgba.r;
+          out[1] = px.rgba.g;
+          out[2] = px.rgba.b;
+          if (job->channels == 4)
+            out[3] = px.rgba.a;
+        }
+    }
+}
+
+/* reads the band table written by boomerang_qoi_encode, leaving offsets NULL if there is none, a plain qoi image
+ * always ends in padding so one that ends in the magic and fails to make sense is corrupt rather than plain */
+static gboolean
+decode_band_table (const guint8 *data, gsize size, int height, int *band_rows, gsize **band_offsets, GError **error)
+{
+  *band_offsets = NULL;
+  if (memcmp (data + size - 4, BAND_MAGIC, 4) != 0)
+    return TRUE;
+
+  if (size < QOI_HEADER_SIZE + QOI_PADDING_SIZE + BAND_TRAILER_SIZE)
+    {
+      g_set_error (error, GDK_PIXBUF_ERROR, GDK_PIXBUF_ERROR_CORRUPT_IMAGE, "Truncated QOI band table");
+      return FALSE;
+    }
+
+  /* both come from the file, so are checked in 64 bits before either is trusted */
+  guint32 n_bands = read_be32 (data + size - BAND_TRAILER_SIZE);
+  guint32 rows = read_be32 (data + size - BAND_TRAILER_SIZE + 4);
+  if (rows == 0 || rows > (guint32)height || n_bands != ((guint64)height + rows - 1) / rows
+      || (guint64)n_bands * 8 > size - QOI_HEADER_SIZE - QOI_PADDING_SIZE - BAND_TRAILER_SIZE)
+    {
+      g_set_error (error, GDK_PIXBUF_ERROR, GDK_PIXBUF_ERROR_CORRUPT_IMAGE, "Invalid QOI band table");
+      return FALSE;
+    }
+
+  /* the end of the final band is the start of the end marker */
+  gsize table = size - BAND_TRAILER_SIZE - (gsize)n_bands * 8;
+  if (memcmp (data + table - QOI_PADDING_SIZE, qoi_padding, QOI_PADDING_SIZE) != 0)
+    {
+      g_set_error (error, GDK_PIXBUF_ERROR, GDK_PIXBUF_ERROR_CORRUPT_IMAGE, "Invalid QOI band table");
+      return FALSE;
+    }
+
+  gsize *offsets = g_new (gsize, n_bands + 1);
+  offsets[n_bands] = table - QOI_PADDING_SIZE;
+  for (guint32 i = 0; i < n_bands; i++)
+    {
+      guint64 offset = (guint64)read_be32 (data + table + i * 8) << 32 | read_be32 (data + table + i * 8 + 4);
+      if ((i == 0 && offset != QOI_HEADER_SIZE) || (i > 0 && offset < offsets[i - 1]) || offset > offsets[n_bands])
+        {
+          g_set_error (error, GDK_PIXBUF_ERROR, GDK_PIXBUF_ERROR_CORRUPT_IMAGE, "Invalid QOI band table");
+          g_free (offsets);
+          return FALSE;
+        }
+      offsets[i] = offset;
+    }
+
+  *band_rows = rows;
+  *band_offsets = offsets;
+  return TRUE;
+}
+
+GdkPixbuf *
+boomerang_qoi_decode (GBytes *bytes, GError **error)
+{
+  gsize size;
+  const guint8 *data = g_bytes_get_data (bytes, &size);
+
+  if (!boomerang_qoi_check (bytes))
+    {
+      g_set_error (error, GDK_PIXBUF_ERROR, GDK_PIXBUF_ERROR_UNKNOWN_TYPE, "Not a QOI image");
+      return NULL;
+    }
+
+  int width = read_be32 (data + 4);
+  int height = read_be32 (data + 8);
+  int channels = data[12];
+  if (width <= 0 || height <= 0 || (channels != 3 && channels != 4) || (gint64)width * height > QOI_PIXELS_MAX)
+    {
+      g_set_error (error, GDK_PIXBUF_ERROR, GDK_PIXBUF_ERROR_CORRUPT_IMAGE, "Invalid QOI header");
+      return NULL;
+    }
+
+  /* images without a band table, written by something else, can only be decoded as a single band */
+  int band_rows = height;
+  gsize *offsets;
+  if (!decode_band_table (data, size, height, &band_rows, &offsets, error))
+    return NULL;
+
+  GdkPixbuf *pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, channels == 4, 8, width, height);
+  if (!pixbuf)
+    {
+      g_set_error (error, GDK_PIXBUF_ERROR, GDK_PIXBUF_ERROR_INSUFFICIENT_MEMORY,
+                   "Not enough memory to load a %dx%d image", width, height);
+      g_free (offsets);
+      return NULL;
+    }
+
+  DecodeJob job = {
+    .data = data,
+    .pixels = gdk_pixbuf_get_pixels (pixbuf),
+    .width = width,
+    .height = height,
+    .rowstride = gdk_pixbuf_get_rowstride (pixbuf),
+    .channels = channels,
+    .band_rows = band_rows,
+    .offsets = offsets,
+  };
+
+  if (job.offsets)
+    {
+      boomerang_parallel_for ((height + job.band_rows - 1) / job.band_rows, decode_band, &job);
+    }
+  else
+    {
+      job.offsets = g_new (gsize, 2);
+      job.offsets[0] = QOI_HEADER_SIZE;
+      job.offsets[1] = size - QOI_PADDING_SIZE;
+      decode_band (0, &job);
+    }
+  g_free (job.offsets);
+
+  if (job.failed)
+    {
+      g_set_error (error, GDK_PIXBUF_ERROR, GDK_PIXBUF_ERROR_CORRUPT_IMAGE, "Truncated QOI image");
+      g_object_unref (pixbuf);
+      return NULL;
+    }
+
+  return pixbuf;
+}
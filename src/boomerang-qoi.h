@@ -0,0 +1,36 @@
+/* Copyright 2026 Mat Booth
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef BOOMERANG_QOI_H_
+#define BOOMERANG_QOI_H_
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+G_BEGIN_DECLS
+
+gboolean boomerang_qoi_check (GBytes *bytes);
+
+GdkPixbuf *boomerang_qoi_decode (GBytes *bytes, GError **error);
+
+GBytes *boomerang_qoi_encode (GdkPixbuf *pixbuf);
+
+gboolean boomerang_qoi_save (GdkPixbuf *pixbuf, const char *filename, GError **error);
+
+G_END_DECLS
+
+#endif /* BOOMERANG_QOI_H_ */
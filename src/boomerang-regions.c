@@ -0,0 +1,275 @@
+/* Copyright 2026 Mat Booth
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "boomerang-regions.h"
+#include "boomerang-trace.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/* the screenshot is divided into bands of this many pixels, edges are counted across the width of each band */
+#define BAND_SIZE 16
+
+/* minimum difference in luminance between neighbouring pixels to be considered an edge */
+#define EDGE_THRESHOLD 24
+
+/* number of consecutive bands an edge must cross to be considered the boundary of a region, this filters out the
+ * short edges found in text and icons and leaves the long straight edges of windows, panels and text blocks */
+#define BOUNDARY_BANDS 4
+
+/* regions smaller than this are not worth zooming to */
+#define MIN_REGION_SIZE 32
+
+struct _BoomerangRegionIndex
+{
+  int width;
+  int height;
+
+  /* for each band of rows, the nearest vertical boundary at or to the left of each column and the nearest vertical
+   * boundary to the right of each column */
+  guint16 *left;
+  guint16 *right;
+
+  /* for each band of columns, the nearest horizontal boundary at or above each row and the nearest horizontal
+   * boundary below each row */
+  guint16 *top;
+  guint16 *bottom;
+};
+
+static void
+compute_luminance (const guint8 *pixels, int width, int channels, guint8 *luma)
+{
+  for (int x = 0; x < width; x++)
+    {
+      const guint8 *p = pixels + x * channels;
+      luma[x] = (p[0] * 77 + p[1] * 150 + p[2] * 29) >> 8;
+    }
+}
+
+static void
+detect_edges (const guint8 *a, const guint8 *b, guint8 *edges, int n)
+{
+  /* writes one for each position where the two rows of luminance values differ by more than the threshold and zero
+   * everywhere else */
+  int i = 0;
+#if defined(__SSE2__)
+  const __m128i threshold = _mm_set1_epi8 (EDGE_THRESHOLD);
+  const __m128i one = _mm_set1_epi8 (1);
+  for (; i + 16 <= n; i += 16)
+    {
+      __m128i va = _mm_loadu_si128 ((const __m128i *)(a + i));
+      __m128i vb = _mm_loadu_si128 ((const __m128i *)(b + i));
+      __m128i diff = _mm_or_si128 (_mm_subs_epu8 (va, vb), _mm_subs_epu8 (vb, va));
+      __m128i over = _mm_min_epu8 (_mm_subs_epu8 (diff, threshold), one);
+      _mm_storeu_si128 ((__m128i *)(edges + i), over);
+    }
+#elif defined(__ARM_NEON)
+  const uint8x16_t threshold = vdupq_n_u8 (EDGE_THRESHOLD);
+  const uint8x16_t one = vdupq_n_u8 (1);
+  for (; i + 16 <= n; i += 16)
+    {
+      uint8x16_t diff = vabdq_u8 (vld1q_u8 (a + i), vld1q_u8 (b + i));
+      vst1q_u8 (edges + i, vandq_u8 (vcgtq_u8 (diff, threshold), one));
+    }
+#endif
+  for (; i < n; i++)
+    edges[i] = ABS (a[i] - b[i]) > EDGE_THRESHOLD;
+}
+
+static void
+find_boundaries (const guint8 *counts, int n_bands, int length, int extent, guint16 *before, guint16 *after)
+{
+  /* an edge is strong within a band if it spans at least three quarters of the band */
+  g_autofree guint16 *runs = g_new (guint16, (gsize)n_bands * length);
+  for (int b = 0; b < n_bands; b++)
+    {
+      int band_size = MIN (BAND_SIZE, extent - b * BAND_SIZE);
+      const guint8 *count = counts + (gsize)b * length;
+      guint16 *run = runs + (gsize)b * length;
+      const guint16 *prev = b > 0 ? run - length : NULL;
+      for (int i = 0; i < length; i++)
+        run[i] = count[i] * 4 >= band_size * 3 ? (prev ? prev[i] : 0) + 1 : 0;
+    }
+
+  /* propagate the total length of each run of strong edges back through all the bands that it crosses */
+  for (int b = n_bands - 2; b >= 0; b--)
+    {
+      guint16 *run = runs + (gsize)b * length;
+      const guint16 *next = run + length;
+      for (int i = 0; i < length; i++)
+        if (run[i] && next[i])
+          run[i] = next[i];
+    }
+
+  for (int b = 0; b < n_bands; b++)
+    {
+      const guint16 *run = runs + (gsize)b * length;
+      guint16 *bef = before + (gsize)b * length;
+      guint16 *aft = after + (gsize)b * length;
+
+      guint16 last = 0;
+      for (int i = 0; i < length; i++)
+        {
+          if (run[i] >= BOUNDARY_BANDS)
+            last = i;
+          bef[i] = last;
+        }
+
+      guint16 next = length;
+      for (int i = length - 1; i >= 0; i--)
+        {
+          aft[i] = next;
+          if (run[i] >= BOUNDARY_BANDS)
+            next = i;
+        }
+    }
+}
+
+static void
+region_index_thread (GTask *task, gpointer source, gpointer task_data, GCancellable *cancellable)
+{
+  GdkPixbuf *pixbuf = task_data;
+
+  gint64 trace_time = boomerang_trace_begin ();
+
+  int width = gdk_pixbuf_get_width (pixbuf);
+  int height = gdk_pixbuf_get_height (pixbuf);
+  int rowstride = gdk_pixbuf_get_rowstride (pixbuf);
+  int channels = gdk_pixbuf_get_n_channels (pixbuf);
+  const guint8 *pixels = gdk_pixbuf_read_pixels (pixbuf);
+
+  if (width > G_MAXUINT16 || height > G_MAXUINT16)
+    {
+      boomerang_trace_end (trace_time, "Region index", "Error: Screenshot is too large to index");
+      g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED, "Screenshot is too large to index");
+      return;
+    }
+
+  int n_row_bands = (height + BAND_SIZE - 1) / BAND_SIZE;
+  int n_col_bands = (width + BAND_SIZE - 1) / BAND_SIZE;
+
+  /* count vertical edges in each column of each band of rows, and horizontal edges in each row of each band of
+   * columns, keeping only the previous row of luminance values around */
+  g_autofree guint8 *vcounts = g_new0 (guint8, (gsize)n_row_bands * width);
+  g_autofree guint8 *hcounts = g_new0 (guint8, (gsize)n_col_bands * height);
+  g_autofree guint8 *luma = g_new (guint8, width * 2);
+  g_autofree guint8 *edges = g_new (guint8, width);
+
+  for (int y = 0; y < height; y++)
+    {
+      guint8 *curr = luma + (y % 2) * width;
+      guint8 *prev = luma + ((y + 1) % 2) * width;
+      compute_luminance (pixels + (gsize)y * rowstride, width, channels, curr);
+
+      guint8 *vcount = vcounts + (gsize)(y / BAND_SIZE) * width;
+      detect_edges (curr + 1, curr, edges, width - 1);
+      for (int x = 0; x < width - 1; x++)
+        vcount[x + 1] += edges[x];
+
+      if (y > 0)
+        {
+          detect_edges (curr, prev, edges, width);
+          for (int b = 0; b < n_col_bands; b++)
+            {
+              int sum = 0;
+              for (int x = b * BAND_SIZE; x < MIN ((b + 1) * BAND_SIZE, width); x++)
+                sum += edges[x];
+              hcounts[(gsize)b * height + y] = sum;
+            }
+        }
+
+      if (y % 256 == 0 && g_cancellable_is_cancelled (cancellable))
+        break;
+    }
+
+  if (g_task_return_error_if_cancelled (task))
+    {
+      boomerang_trace_end (trace_time, "Region index", "Cancelled");
+      return;
+    }
+
+  BoomerangRegionIndex *index = g_new0 (BoomerangRegionIndex, 1);
+  index->width = width;
+  index->height = height;
+  index->left = g_new (guint16, (gsize)n_row_bands * width);
+  index->right = g_new (guint16, (gsize)n_row_bands * width);
+  index->top = g_new (guint16, (gsize)n_col_bands * height);
+  index->bottom = g_new (guint16, (gsize)n_col_bands * height);
+  find_boundaries (vcounts, n_row_bands, width, height, index->left, index->right);
+  find_boundaries (hcounts, n_col_bands, height, width, index->top, index->bottom);
+
+  boomerang_trace_end (trace_time, "Region index", "%dx%d", width, height);
+
+  g_task_return_pointer (task, index, (GDestroyNotify)boomerang_region_index_free);
+}
+
+/* builds an index of the rectangular regions in the screenshot on a worker thread, so that the region containing
+ * any given pixel can be looked up in constant time */
+void
+boomerang_region_index_new_async (GdkPixbuf *pixbuf, GCancellable *cancellable, GAsyncReadyCallback callback,
+                                  gpointer data)
+{
+  g_return_if_fail (GDK_IS_PIXBUF (pixbuf));
+
+  GTask *task = g_task_new (NULL, cancellable, callback, data);
+  g_task_set_task_data (task, g_object_ref (pixbuf), g_object_unref);
+  g_task_run_in_thread (task, region_index_thread);
+  g_object_unref (task);
+}
+
+BoomerangRegionIndex *
+boomerang_region_index_new_finish (GAsyncResult *result, GError **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, NULL), NULL);
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+gboolean
+boomerang_region_index_lookup (BoomerangRegionIndex *index, int x, int y, GdkRectangle *region)
+{
+  g_return_val_if_fail (index != NULL, FALSE);
+
+  if (x < 0 || y < 0 || x >= index->width || y >= index->height)
+    return FALSE;
+
+  gsize row_band = y / BAND_SIZE;
+  gsize col_band = x / BAND_SIZE;
+  region->x = index->left[row_band * index->width + x];
+  region->width = index->right[row_band * index->width + x] - region->x;
+  region->y = index->top[col_band * index->height + y];
+  region->height = index->bottom[col_band * index->height + y] - region->y;
+
+  return region->width >= MIN_REGION_SIZE && region->height >= MIN_REGION_SIZE;
+}
+
+void
+boomerang_region_index_free (BoomerangRegionIndex *index)
+{
+  if (!index)
+    return;
+
+  g_free (index->left);
+  g_free (index->right);
+  g_free (index->top);
+  g_free (index->bottom);
+  g_free (index);
+}
@@ -0,0 +1,41 @@
+/* Copyright 2026 Mat Booth
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef BOOMERANG_REGIONS_H_
+#define BOOMERANG_REGIONS_H_
+
+#include <gdk/gdk.h>
+
+G_BEGIN_DECLS
+
+typedef struct _BoomerangRegionIndex BoomerangRegionIndex;
+
+void boomerang_region_index_new_async (GdkPixbuf *pixbuf, GCancellable *cancellable, GAsyncReadyCallback callback,
+                                       gpointer data);
+
+BoomerangRegionIndex *boomerang_region_index_new_finish (GAsyncResult *result, GError **error);
+
+gboolean boomerang_region_index_lookup (BoomerangRegionIndex *index, int x, int y, GdkRectangle *region);
+
+void boomerang_region_index_free (BoomerangRegionIndex *index);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (BoomerangRegionIndex, boomerang_region_index_free)
+
+G_END_DECLS
+
+#endif /* BOOMERANG_REGIONS_H_ */
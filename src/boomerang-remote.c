@@ -0,0 +1,314 @@
+/* Copyright 2026 Mat Booth
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "boomerang-remote.h"
+#include "boomerang-canvas.h"
+#include "boomerang-trace.h"
+
+#define REMOTE_INTERFACE "uk.co.matbooth.Boomerang.RemoteControl"
+
+typedef struct _RemoteCommand RemoteCommand;
+struct _RemoteCommand
+{
+  char *name;
+  GVariant *args;
+};
+
+struct _BoomerangRemote
+{
+  GObject parent_instance;
+
+  /* not owned, the application owns us */
+  BoomerangApplication *app;
+
+  GDBusConnection *connection;
+  guint registration_id;
+
+  /* commands waiting to be applied on the next frame of the canvas */
+  GQueue commands;
+  GtkWidget *tick_widget;
+  guint tick_id;
+};
+
+G_DEFINE_FINAL_TYPE (BoomerangRemote, boomerang_remote, G_TYPE_OBJECT)
+
+/* argument signatures of the commands that may be called directly or passed to Batch */
+static const struct
+{
+  const char *name;
+  const char *signature;
+  gboolean needs_canvas;
+} remote_commands[] = {
+  { "ZoomTo", "((iiii)d)", TRUE },
+  { "Pan", "(ddd)", TRUE },
+  { "SetFlashlight", "(dddd)", TRUE },
+  { "Capture", "()", FALSE },
+};
+
+static void
+remote_command_free (RemoteCommand *command)
+{
+  g_free (command->name);
+  g_variant_unref (command->args);
+  g_free (command);
+}
+
+static gboolean
+remote_validate (BoomerangRemote *remote, const char *name, GVariant *args, GError **error)
+{
+  for (gsize i = 0; i < G_N_ELEMENTS (remote_commands); i++)
+    {
+      if (g_strcmp0 (name, remote_commands[i].name) != 0)
+        continue;
+
+      if (!g_variant_is_of_type (args, G_VARIANT_TYPE (remote_commands[i].signature)))
+        {
+          g_set_error (error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS, "Arguments to %s must be of type %s", name,
+                       remote_commands[i].signature);
+          return FALSE;
+        }
+
+      if (remote_commands[i].needs_canvas && !boomerang_application_get_canvas (remote->app))
+        {
+          g_set_error (error, G_DBUS_ERROR, G_DBUS_ERROR_FAILED, "No screenshot is being shown");
+          return FALSE;
+        }
+
+      return TRUE;
+    }
+
+  g_set_error (error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD, "Unknown command %s", name);
+  return FALSE;
+}
+
+static void
+remote_apply (BoomerangRemote *remote, RemoteCommand *command)
+{
+  gint64 trace_time = boomerang_trace_begin ();
+  BoomerangCanvas *canvas = BOOMERANG_CANVAS (boomerang_application_get_canvas (remote->app));
+
+  if (g_strcmp0 (command->name, "Capture") == 0)
+    {
+      boomerang_application_capture (remote->app);
+    }
+  else if (g_strcmp0 (command->name, "ZoomTo") == 0 && canvas)
+    {
+      GdkRectangle region;
+      double duration;
+      g_variant_get (command->args, "((iiii)d)", &region.x, &region.y, &region.width, &region.height, &duration);
+      boomerang_canvas_zoom_to (canvas, &region, duration);
+    }
+  else if (g_strcmp0 (command->name, "Pan") == 0 && canvas)
+    {
+      double dx, dy, duration;
+      g_variant_get (command->args, "(ddd)", &dx, &dy, &duration);
+      boomerang_canvas_pan (canvas, dx, dy, duration);
+    }
+  else if (g_strcmp0 (command->name, "SetFlashlight") == 0 && canvas)
+    {
+      double x, y, radius, duration;
+      g_variant_get (command->args, "(dddd)", &x, &y, &radius, &duration);
+      boomerang_canvas_set_flashlight (canvas, x, y, radius, duration);
+    }
+
+  boomerang_trace_end (trace_time, "Remote command", "%s", command->name);
+}
+
+static void
+remote_flush (BoomerangRemote *remote)
+{
+  RemoteCommand *command;
+  while ((command = g_queue_pop_head (&remote->commands)))
+    {
+      remote_apply (remote, command);
+      remote_command_free (command);
+    }
+}
+
+static gboolean
+remote_tick (GtkWidget *widget, GdkFrameClock *frame_clock, gpointer data)
+{
+  BoomerangRemote *remote = BOOMERANG_REMOTE (data);
+
+  /* everything queued since the last frame is applied together, before this frame is drawn */
+  remote_flush (remote);
+
+  remote->tick_id = 0;
+  g_clear_object (&remote->tick_widget);
+  return G_SOURCE_REMOVE;
+}
+
+static void
+remote_queue (BoomerangRemote *remote, const char *name, GVariant *args)
+{
+  RemoteCommand *command = g_new0 (RemoteCommand, 1);
+  command->name = g_strdup (name);
+  command->args = g_variant_ref_sink (args);
+  g_queue_push_tail (&remote->commands, command);
+
+  if (remote->tick_id)
+    return;
+
+  GtkWidget *canvas = boomerang_application_get_canvas (remote->app);
+  if (canvas)
+    {
+      remote->tick_widget = g_object_ref (canvas);
+      remote->tick_id = gtk_widget_add_tick_callback (canvas, remote_tick, remote, NULL);
+    }
+  else
+    {
+      /* there are no frames to wait for until a screenshot is shown */
+      remote_flush (remote);
+    }
+}
+
+static void
+remote_method_call (GDBusConnection *connection, const char *sender, const char *object_path,
+                    const char *interface_name, const char *method_name, GVariant *parameters,
+                    GDBusMethodInvocation *invocation, gpointer data)
+{
+  BoomerangRemote *remote = BOOMERANG_REMOTE (data);
+
+  GError *error = NULL;
+
+  if (g_strcmp0 (method_name, "Batch") == 0)
+    {
+      g_autoptr (GVariant) commands = g_variant_get_child_value (parameters, 0);
+      gsize n_commands = g_variant_n_children (commands);
+
+      /* validate the whole batch before queueing any of it, so that it is either applied in full or not at all */
+      for (gsize i = 0; i < n_commands; i++)
+        {
+          const char *name;
+          g_autoptr (GVariant) args = NULL;
+          g_variant_get_child (commands, i, "(&sv)", &name, &args);
+          if (!remote_validate (remote, name, args, &error))
+            {
+              g_dbus_method_invocation_take_error (invocation, error);
+              return;
+            }
+        }
+
+      for (gsize i = 0; i < n_commands; i++)
+        {
+          const char *name;
+          g_autoptr (GVariant) args = NULL;
+          g_variant_get_child (commands, i, "(&sv)", &name, &args);
+          remote_queue (remote, name, args);
+        }
+    }
+  else
+    {
+      if (!remote_validate (remote, method_name, parameters, &error))
+        {
+          g_dbus_method_invocation_take_error (invocation, error);
+          return;
+        }
+
+      remote_queue (remote, method_name, parameters);
+    }
+
+  g_dbus_method_invocation_return_value (invocation, NULL);
+}
+
+static const GDBusInterfaceVTable remote_vtable = {
+  remote_method_call,
+  NULL,
+  NULL,
+};
+
+static void
+boomerang_remote_dispose (GObject *object)
+{
+  BoomerangRemote *remote = BOOMERANG_REMOTE (object);
+
+  boomerang_remote_unregister (remote);
+
+  G_OBJECT_CLASS (boomerang_remote_parent_class)->dispose (object);
+}
+
+static void
+boomerang_remote_class_init (BoomerangRemoteClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  object_class->dispose = boomerang_remote_dispose;
+}
+
+static void
+boomerang_remote_init (BoomerangRemote *remote)
+{
+  g_queue_init (&remote->commands);
+}
+
+gboolean
+boomerang_remote_register (BoomerangRemote *remote, GDBusConnection *connection, const char *object_path,
+                           GError **error)
+{
+  g_return_val_if_fail (BOOMERANG_IS_REMOTE (remote), FALSE);
+
+  GBytes *introspection = g_resources_lookup_data ("/dbus/" REMOTE_INTERFACE ".xml", G_RESOURCE_LOOKUP_FLAGS_NONE,
+                                                   error);
+  if (!introspection)
+    return FALSE;
+
+  GDBusNodeInfo *node_info = g_dbus_node_info_new_for_xml (g_bytes_get_data (introspection, NULL), error);
+  g_bytes_unref (introspection);
+  if (!node_info)
+    return FALSE;
+
+  remote->registration_id = g_dbus_connection_register_object (
+      connection, object_path, g_dbus_node_info_lookup_interface (node_info, REMOTE_INTERFACE), &remote_vtable,
+      remote, NULL, error);
+  g_dbus_node_info_unref (node_info);
+
+  if (!remote->registration_id)
+    return FALSE;
+
+  remote->connection = g_object_ref (connection);
+  return TRUE;
+}
+
+void
+boomerang_remote_unregister (BoomerangRemote *remote)
+{
+  g_return_if_fail (BOOMERANG_IS_REMOTE (remote));
+
+  if (remote->registration_id)
+    {
+      g_dbus_connection_unregister_object (remote->connection, remote->registration_id);
+      remote->registration_id = 0;
+    }
+  g_clear_object (&remote->connection);
+
+  if (remote->tick_id)
+    {
+      gtk_widget_remove_tick_callback (remote->tick_widget, remote->tick_id);
+      remote->tick_id = 0;
+    }
+  g_clear_object (&remote->tick_widget);
+
+  g_queue_clear_full (&remote->commands, (GDestroyNotify)remote_command_free);
+}
+
+BoomerangRemote *
+boomerang_remote_new (BoomerangApplication *app)
+{
+  BoomerangRemote *remote = g_object_new (BOOMERANG_TYPE_REMOTE, NULL);
+  remote->app = app;
+  return remote;
+}
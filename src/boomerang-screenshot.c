@@ -17,141 +17,369 @@
  */
 
 #include "boomerang-screenshot.h"
-
-#define PORTAL_BUS "org.freedesktop.portal.Desktop"
+#include "boomerang-capture-file.h"
+#include "boomerang-capture-portal.h"
+#include "boomerang-capture-shell.h"
 
 struct _BoomerangScreenshot
 {
   GObject parent_instance;
 
-  GTask *task;
-  GDBusConnection *conn;
+  /* file to use instead of capturing the screen */
+  char *source;
+
+  /* part of the desktop to capture, if the backend is able to capture less than everything */
+  GdkRectangle area;
+  gboolean has_area;
+
+  /* backends that probed successfully, in the order they should be tried, or NULL until probing has found one */
+  GPtrArray *backends;
 
-  char *object_path;
-  guint signal_id;
-  gulong cancelled_id;
+  /* screenshots waiting for probing to finish, or NULL when nothing is being probed */
+  GPtrArray *waiting;
+
+  /* how each backend has performed in the past, persisted between runs */
+  GKeyFile *stats;
+  char *stats_path;
 };
 
 G_DEFINE_FINAL_TYPE (BoomerangScreenshot, boomerang_screenshot, G_TYPE_OBJECT)
 
-static void
-screenshot_cleanup (BoomerangScreenshot *bs)
+/* number of captures after which the latency of a backend is measured again, in case another has become faster */
+#define RESAMPLE_INTERVAL 20
+
+/* group of the stats file that counts captures, which cannot be the name of a backend */
+#define STATS_GROUP "stats"
+
+typedef struct
 {
-  g_clear_signal_handler (&bs->cancelled_id, g_task_get_cancellable (bs->task));
-  g_object_unref (bs->task);
+  /* backends still being probed, or the index of the next backend to try */
+  GPtrArray *probing;
+  int pending;
+  guint next;
 
-  if (bs->signal_id)
-    g_dbus_connection_signal_unsubscribe (bs->conn, bs->signal_id);
+  gint64 start_time;
+  gboolean cropped;
+  GError *error;
+} TakeData;
 
-  g_free (bs->object_path);
+static void
+take_data_free (TakeData *take)
+{
+  g_clear_pointer (&take->probing, g_ptr_array_unref);
+  g_clear_error (&take->error);
+  g_free (take);
+}
 
-  g_object_unref (bs->conn);
+static double
+screenshot_backend_rank (BoomerangScreenshot *self, BoomerangCaptureBackend *backend, guint default_position)
+{
+  /* backends that have not been measured, or not for a while, come first in their default order so that every one
+   * that works gets a latency to compare, then the fastest, then those that failed last time they were tried */
+  const char *name = boomerang_capture_backend_get_name (backend);
+  if (g_key_file_get_boolean (self->stats, name, "failed", NULL))
+    return 2e9 + default_position;
+  if (!g_key_file_has_key (self->stats, name, "latency", NULL))
+    return -1e9 + default_position;
+
+  guint64 captures = g_key_file_get_uint64 (self->stats, STATS_GROUP, "captures", NULL);
+  guint64 sampled = g_key_file_get_uint64 (self->stats, name, "sampled", NULL);
+  if (captures - sampled >= RESAMPLE_INTERVAL)
+    return -1e9 + default_position;
+  return g_key_file_get_double (self->stats, name, "latency", NULL);
 }
 
 static void
-screenshot_take_response_cb (GDBusConnection *bus, const char *sender_name, const char *object_path,
-                             const char *interface_name, const char *signal_name, GVariant *parameters, gpointer data)
+screenshot_record (BoomerangScreenshot *self, BoomerangCaptureBackend *backend, double latency)
 {
-  BoomerangScreenshot *bs = BOOMERANG_SCREENSHOT (data);
+  /* a negative latency records a failure, otherwise the latency is smoothed over consecutive captures so that one
+   * slow capture is not enough to change the order */
+  const char *name = boomerang_capture_backend_get_name (backend);
+  if (latency < 0)
+    {
+      g_key_file_set_boolean (self->stats, name, "failed", TRUE);
+    }
+  else
+    {
+      if (g_key_file_has_key (self->stats, name, "latency", NULL))
+        latency = (latency + g_key_file_get_double (self->stats, name, "latency", NULL)) / 2.0;
+      guint64 captures = g_key_file_get_uint64 (self->stats, STATS_GROUP, "captures", NULL) + 1;
+      g_key_file_set_uint64 (self->stats, STATS_GROUP, "captures", captures);
+      g_key_file_set_boolean (self->stats, name, "failed", FALSE);
+      g_key_file_set_double (self->stats, name, "latency", latency);
+      g_key_file_set_uint64 (self->stats, name, "sampled", captures);
+    }
 
-  unsigned int response;
-  g_autoptr (GVariant) results = NULL;
-  g_variant_get (parameters, "(u@a{sv})", &response, &results);
+  g_autofree char *dir = g_path_get_dirname (self->stats_path);
+  g_mkdir_with_parents (dir, 0700);
 
-  if (response == 0)
+  GError *error = NULL;
+  if (!g_key_file_save_to_file (self->stats, self->stats_path, &error))
     {
-      const char *uri = NULL;
-      if (g_variant_lookup (results, "uri", "&s", &uri))
-        g_task_return_pointer (bs->task, g_strdup (uri), g_free);
-      else
-        g_task_return_new_error (bs->task, G_IO_ERROR, G_IO_ERROR_FAILED, "Unable to retrieve URI to screenshot");
+      g_printerr ("Error: %s\n", error->message);
+      g_error_free (error);
     }
-  else if (response == 1)
+}
+
+static void screenshot_try_next (GTask *task);
+
+static void
+screenshot_capture_cb (GObject *source, GAsyncResult *result, gpointer data)
+{
+  GTask *task = G_TASK (data);
+  BoomerangScreenshot *self = g_task_get_source_object (task);
+  TakeData *take = g_task_get_task_data (task);
+  BoomerangCaptureBackend *backend = BOOMERANG_CAPTURE_BACKEND (source);
+
+  GError *error = NULL;
+  char *uri = boomerang_capture_backend_capture_finish (backend, result, &error);
+  if (uri)
     {
-      g_task_return_new_error (bs->task, G_IO_ERROR, G_IO_ERROR_CANCELLED, "Screenshot taking was cancelled");
+      if (!self->source)
+        screenshot_record (self, backend, (g_get_monotonic_time () - take->start_time) / 1000.0);
+      g_task_return_pointer (task, uri, g_free);
+      g_object_unref (task);
+      return;
     }
-  else
+
+  /* the user declining to share the screen is not a reason to ask a different backend */
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
     {
-      g_task_return_new_error (bs->task, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to take screenshot");
+      g_task_return_error (task, error);
+      g_object_unref (task);
+      return;
     }
 
-  screenshot_cleanup (bs);
+  g_debug ("Screenshot backend %s failed: %s", boomerang_capture_backend_get_name (backend), error->message);
+  if (!self->source)
+    screenshot_record (self, backend, -1);
+
+  g_clear_error (&take->error);
+  take->error = error;
+  screenshot_try_next (task);
 }
 
 static void
-screenshot_cancelled_cb (GCancellable *cancellable, gpointer data)
+screenshot_try_next (GTask *task)
 {
-  BoomerangScreenshot *bs = BOOMERANG_SCREENSHOT (data);
+  BoomerangScreenshot *self = g_task_get_source_object (task);
+  TakeData *take = g_task_get_task_data (task);
+
+  if (take->next >= self->backends->len)
+    {
+      if (take->error)
+        g_task_return_error (task, g_steal_pointer (&take->error));
+      else
+        g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED, "No way to take a screenshot was found");
+      g_object_unref (task);
+      return;
+    }
 
-  /* cancel the in-progress screenshot request, a response signal will not be sent */
-  g_dbus_connection_call (bs->conn, PORTAL_BUS, bs->object_path, "org.freedesktop.portal.Request", "Close", NULL, NULL,
-                          G_DBUS_CALL_FLAGS_NONE, -1, NULL, NULL, NULL);
+  BoomerangCaptureBackend *backend = g_ptr_array_index (self->backends, take->next++);
+  take->start_time = g_get_monotonic_time ();
+  take->cropped = self->has_area && boomerang_capture_backend_can_capture_area (backend);
+  if (take->cropped)
+    boomerang_capture_backend_capture_area (backend, &self->area, g_task_get_cancellable (task),
+                                            screenshot_capture_cb, task);
+  else
+    boomerang_capture_backend_capture (backend, g_task_get_cancellable (task), screenshot_capture_cb, task);
+}
 
-  g_task_return_new_error (bs->task, G_IO_ERROR, G_IO_ERROR_CANCELLED, "Screenshot taking was cancelled");
+typedef struct
+{
+  double rank;
+  BoomerangCaptureBackend *backend;
+} RankedBackend;
 
-  screenshot_cleanup (bs);
+static int
+screenshot_compare_backends (gconstpointer a, gconstpointer b)
+{
+  double rank_a = ((const RankedBackend *)a)->rank;
+  double rank_b = ((const RankedBackend *)b)->rank;
+  return (rank_a > rank_b) - (rank_a < rank_b);
 }
 
+static void screenshot_probe (GTask *task);
+
+/* starts trying the backends for every screenshot that waited for probing, or if there are none to try, gives up on
+ * them, leaving the backends to be probed again next time, unless probing was only cancelled for the screenshot that
+ * started it and others are still waiting */
 static void
-screenshot_take_cb (GObject *object, GAsyncResult *result, gpointer data)
+screenshot_probe_done (BoomerangScreenshot *self, gboolean cancelled)
 {
-  BoomerangScreenshot *bs = BOOMERANG_SCREENSHOT (data);
+  /* the tasks may hold the last references to us */
+  g_object_ref (self);
+
+  g_autoptr (GPtrArray) waiting = g_steal_pointer (&self->waiting);
+  for (guint i = 0; i < waiting->len; i++)
+    {
+      GTask *task = g_ptr_array_index (waiting, i);
+      if (g_task_return_error_if_cancelled (task))
+        {
+          g_object_unref (task);
+        }
+      else if (self->backends)
+        {
+          screenshot_try_next (task);
+        }
+      else if (cancelled)
+        {
+          if (self->waiting)
+            {
+              g_ptr_array_add (self->waiting, task);
+            }
+          else
+            {
+              self->waiting = g_ptr_array_new ();
+              g_ptr_array_add (self->waiting, task);
+              screenshot_probe (task);
+            }
+        }
+      else
+        {
+          g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED, "No way to take a screenshot was found");
+          g_object_unref (task);
+        }
+    }
 
-  /* portal methods return the object path for the request whose response signal we need to observe for the results of
-   * the call, but we discard it here because we computed it earlier and are already subscribed */
+  g_object_unref (self);
+}
+
+static void
+screenshot_probe_cb (GObject *source, GAsyncResult *result, gpointer data)
+{
+  GTask *task = G_TASK (data);
+  BoomerangScreenshot *self = g_task_get_source_object (task);
+  TakeData *take = g_task_get_task_data (task);
+  BoomerangCaptureBackend *backend = BOOMERANG_CAPTURE_BACKEND (source);
 
   GError *error = NULL;
-  g_autoptr (GVariant) ret_val = g_dbus_connection_call_finish (G_DBUS_CONNECTION (object), result, &error);
+  if (!boomerang_capture_backend_probe_finish (backend, result, &error))
+    {
+      g_debug ("Screenshot backend %s is not available: %s", boomerang_capture_backend_get_name (backend),
+               error->message);
+      g_error_free (error);
+      g_ptr_array_remove (take->probing, backend);
+    }
 
-  if (error)
+  if (--take->pending > 0)
+    return;
+
+  /* all backends have answered, so order the ones that are available, unless probing was cancelled part way through
+   * and those that did not answer in time are missing from them */
+  gboolean cancelled = g_cancellable_is_cancelled (g_task_get_cancellable (task));
+  if (cancelled || take->probing->len == 0)
+    {
+      g_clear_pointer (&take->probing, g_ptr_array_unref);
+      screenshot_probe_done (self, cancelled);
+      return;
+    }
+
+  g_autoptr (GArray) ranked = g_array_sized_new (FALSE, FALSE, sizeof (RankedBackend), take->probing->len);
+  for (guint i = 0; i < take->probing->len; i++)
+    {
+      RankedBackend candidate = { .backend = g_ptr_array_index (take->probing, i) };
+      candidate.rank = screenshot_backend_rank (self, candidate.backend, i);
+      g_array_append_val (ranked, candidate);
+    }
+  g_array_sort (ranked, screenshot_compare_backends);
+
+  self->backends = g_ptr_array_new_with_free_func (g_object_unref);
+  for (guint i = 0; i < ranked->len; i++)
     {
-      g_task_return_error (bs->task, error);
-      screenshot_cleanup (bs);
+      BoomerangCaptureBackend *backend = g_array_index (ranked, RankedBackend, i).backend;
+      g_debug ("Screenshot backend %u: %s", i, boomerang_capture_backend_get_name (backend));
+      g_ptr_array_add (self->backends, g_object_ref (backend));
     }
+  g_clear_pointer (&take->probing, g_ptr_array_unref);
+
+  screenshot_probe_done (self, FALSE);
 }
 
 static void
-screenshot_take (BoomerangScreenshot *self)
-{
-  /* compute object path on which to listen for the request response signal */
-  g_autofree char *token = g_strdup_printf ("boomerang_%d", g_random_int_range (0, G_MAXINT));
-  g_autofree char *sender = g_strdup (g_dbus_connection_get_unique_name (self->conn) + 1);
-  for (int i = 0; sender[i]; i++)
-    if (sender[i] == '.')
-      sender[i] = '_';
-  self->object_path = g_strconcat ("/org/freedesktop/portal/desktop/request/", sender, "/", token, NULL);
-
-  /* subscribe to the request response signal on the object path computed above */
-  self->signal_id = g_dbus_connection_signal_subscribe (
-      self->conn, PORTAL_BUS, "org.freedesktop.portal.Request", "Response", self->object_path, NULL,
-      G_DBUS_SIGNAL_FLAGS_NO_MATCH_RULE, screenshot_take_response_cb, self, NULL);
-
-  /* register cancellation callback */
-  GCancellable *cancellable = g_task_get_cancellable (self->task);
-  if (cancellable)
-    self->cancelled_id = g_signal_connect (cancellable, "cancelled", G_CALLBACK (screenshot_cancelled_cb), self);
-
-  /* create input parameters for the screenshot portal request */
-  GVariantBuilder *builder = g_variant_builder_new (G_VARIANT_TYPE ("a{sv}"));
-  g_variant_builder_add (builder, "{sv}", "interactive", g_variant_new_boolean (FALSE));
-  g_variant_builder_add (builder, "{sv}", "handle_token", g_variant_new_string (token));
-  GVariant *params = g_variant_new ("(sa{sv})", "", builder);
-  g_variant_builder_unref (builder);
-
-  /* https://flatpak.github.io/xdg-desktop-portal/docs/doc-org.freedesktop.portal.Screenshot.html */
-  g_dbus_connection_call (self->conn, PORTAL_BUS, "/org/freedesktop/portal/desktop",
-                          "org.freedesktop.portal.Screenshot", "Screenshot", params, G_VARIANT_TYPE ("(o)"),
-                          G_DBUS_CALL_FLAGS_NONE, -1, NULL, screenshot_take_cb, self);
+screenshot_probe (GTask *task)
+{
+  BoomerangScreenshot *self = g_task_get_source_object (task);
+  TakeData *take = g_task_get_task_data (task);
+
+  take->probing = g_ptr_array_new_with_free_func (g_object_unref);
+
+  /* a file given on the command line is the only thing to try, otherwise try all the ways of capturing the screen */
+  if (self->source)
+    {
+      g_ptr_array_add (take->probing, boomerang_capture_file_new (self->source));
+    }
+  else
+    {
+      GError *error = NULL;
+      g_autoptr (GDBusConnection) conn = g_bus_get_sync (G_BUS_TYPE_SESSION, NULL, &error);
+      if (!conn)
+        {
+          /* nothing else can have started waiting yet */
+          g_clear_pointer (&self->waiting, g_ptr_array_unref);
+          g_task_return_error (task, error);
+          g_object_unref (task);
+          return;
+        }
+      g_ptr_array_add (take->probing, boomerang_capture_portal_new (conn));
+      g_ptr_array_add (take->probing, boomerang_capture_shell_new (conn));
+    }
+
+  /* probe them all at the same time, each one that fails is removed when it answers */
+  take->pending = take->probing->len;
+  for (guint i = 0; i < take->probing->len; i++)
+    boomerang_capture_backend_probe (g_ptr_array_index (take->probing, i), g_task_get_cancellable (task),
+                                     screenshot_probe_cb, task);
+}
+
+static void
+boomerang_screenshot_finalize (GObject *object)
+{
+  BoomerangScreenshot *self = BOOMERANG_SCREENSHOT (object);
+
+  g_free (self->source);
+  g_clear_pointer (&self->backends, g_ptr_array_unref);
+  g_key_file_free (self->stats);
+  g_free (self->stats_path);
+
+  G_OBJECT_CLASS (boomerang_screenshot_parent_class)->finalize (object);
 }
 
 static void
 boomerang_screenshot_class_init (BoomerangScreenshotClass *klass)
 {
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  object_class->finalize = boomerang_screenshot_finalize;
 }
 
 static void
 boomerang_screenshot_init (BoomerangScreenshot *screenshot)
 {
+  screenshot->stats = g_key_file_new ();
+  screenshot->stats_path = g_build_filename (g_get_user_cache_dir (), "boomerang", "capture-backends.ini", NULL);
+  g_key_file_load_from_file (screenshot->stats, screenshot->stats_path, G_KEY_FILE_NONE, NULL);
+}
+
+/* use the given file instead of capturing the screen, "-" meaning standard input */
+void
+boomerang_screenshot_set_source (BoomerangScreenshot *screenshot, const char *filename)
+{
+  g_return_if_fail (BOOMERANG_IS_SCREENSHOT (screenshot));
+
+  g_free (screenshot->source);
+  screenshot->source = g_strdup (filename);
+  g_clear_pointer (&screenshot->backends, g_ptr_array_unref);
+}
+
+/* capture only the given area of the desktop where possible, in logical desktop coordinates, or everything if NULL */
+void
+boomerang_screenshot_set_area (BoomerangScreenshot *screenshot, const GdkRectangle *area)
+{
+  g_return_if_fail (BOOMERANG_IS_SCREENSHOT (screenshot));
+
+  screenshot->has_area = area != NULL;
+  if (area)
+    screenshot->area = *area;
 }
 
 void
@@ -160,20 +388,40 @@ boomerang_screenshot_take (BoomerangScreenshot *screenshot, GCancellable *cancel
 {
   g_return_if_fail (BOOMERANG_IS_SCREENSHOT (screenshot));
 
-  screenshot->task = g_task_new (screenshot, cancellable, callback, data);
+  GTask *task = g_task_new (screenshot, cancellable, callback, data);
+  g_task_set_task_data (task, g_new0 (TakeData, 1), (GDestroyNotify)take_data_free);
 
-  // TODO pass error and check for error
-  screenshot->conn = g_bus_get_sync (G_BUS_TYPE_SESSION, NULL, NULL);
-
-  screenshot_take (screenshot);
+  /* backends are probed the first time a screenshot is taken, and any taken while that is happening wait for it to
+   * finish rather than probing again, the task reference is released when it returns */
+  if (screenshot->backends)
+    {
+      screenshot_try_next (task);
+    }
+  else if (screenshot->waiting)
+    {
+      g_ptr_array_add (screenshot->waiting, task);
+    }
+  else
+    {
+      screenshot->waiting = g_ptr_array_new ();
+      g_ptr_array_add (screenshot->waiting, task);
+      screenshot_probe (task);
+    }
 }
 
+/* returns the URI of the screenshot and whether it was cropped to the area that was asked for, otherwise it shows the
+ * whole desktop */
 char *
-boomerang_screenshot_finish (BoomerangScreenshot *screenshot, GAsyncResult *result, GError **error)
+boomerang_screenshot_finish (BoomerangScreenshot *screenshot, GAsyncResult *result, gboolean *cropped,
+                             GError **error)
 {
   g_return_val_if_fail (BOOMERANG_IS_SCREENSHOT (screenshot), NULL);
   g_return_val_if_fail (g_task_is_valid (result, screenshot), NULL);
 
+  if (cropped)
+    {
+      TakeData *take = g_task_get_task_data (G_TASK (result));
+      *cropped = take->cropped;
+    }
   return g_task_propagate_pointer (G_TASK (result), error);
 }
-
@@ -19,7 +19,7 @@
 #ifndef BOOMERANG_SCREENSHOT_H_
 #define BOOMERANG_SCREENSHOT_H_
 
-#include <gio/gio.h>
+#include <gdk/gdk.h>
 
 G_BEGIN_DECLS
 
@@ -27,10 +27,15 @@ G_BEGIN_DECLS
 
 G_DECLARE_FINAL_TYPE (BoomerangScreenshot, boomerang_screenshot, BOOMERANG, SCREENSHOT, GObject)
 
+void boomerang_screenshot_set_source (BoomerangScreenshot *screenshot, const char *filename);
+
+void boomerang_screenshot_set_area (BoomerangScreenshot *screenshot, const GdkRectangle *area);
+
 void boomerang_screenshot_take (BoomerangScreenshot *screenshot, GCancellable *cancellable,
                                 GAsyncReadyCallback callback, gpointer data);
 
-char *boomerang_screenshot_finish (BoomerangScreenshot *screenshot, GAsyncResult *result, GError **error);
+char *boomerang_screenshot_finish (BoomerangScreenshot *screenshot, GAsyncResult *result, gboolean *cropped,
+                                   GError **error);
 
 G_END_DECLS
 
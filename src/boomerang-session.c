@@ -0,0 +1,240 @@
+/* Copyright 2026 Mat Booth
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "boomerang-session.h"
+
+#include <gio/gio.h>
+#include <stdlib.h>
+
+/* the version is bumped whenever the layout of the recording changes */
+#define SESSION_VERSION 1
+#define SESSION_TYPE "(uiiaya(xydduu))"
+
+struct _BoomerangSession
+{
+  /* size of the canvas in widget coordinates, so that replays see the same pointer positions */
+  int width;
+  int height;
+
+  /* contents of the screenshot file, in whatever format it was loaded from */
+  GBytes *screenshot;
+
+  GArray *events;
+  GArray *frames;
+};
+
+static BoomerangSession *
+session_new (GBytes *screenshot)
+{
+  BoomerangSession *session = g_new0 (BoomerangSession, 1);
+  session->screenshot = g_bytes_ref (screenshot);
+  session->events = g_array_new (FALSE, FALSE, sizeof (BoomerangSessionEvent));
+  session->frames = g_array_new (FALSE, FALSE, sizeof (BoomerangSessionFrame));
+  return session;
+}
+
+/* starts a new recording of input events made on the given screenshot */
+BoomerangSession *
+boomerang_session_new (GBytes *screenshot)
+{
+  g_return_val_if_fail (screenshot != NULL, NULL);
+
+  return session_new (screenshot);
+}
+
+BoomerangSession *
+boomerang_session_load (const char *filename, GError **error)
+{
+  char *contents;
+  gsize length;
+  if (!g_file_get_contents (filename, &contents, &length, error))
+    return NULL;
+
+  /* recordings are always stored little endian so that they can be replayed on any machine, the variant is checked
+   * for the right type but is otherwise safe to read even if it is corrupt */
+  g_autoptr (GVariant) variant = g_variant_ref_sink (
+      g_variant_new_from_data (G_VARIANT_TYPE (SESSION_TYPE), contents, length, FALSE, g_free, contents));
+  if (G_BYTE_ORDER == G_BIG_ENDIAN)
+    {
+      GVariant *swapped = g_variant_byteswap (variant);
+      g_variant_unref (variant);
+      variant = swapped;
+    }
+
+  guint32 version;
+  int width, height;
+  g_autoptr (GVariant) screenshot = NULL;
+  g_autoptr (GVariantIter) events = NULL;
+  g_variant_get (variant, "(uii@aya(xydduu))", &version, &width, &height, &screenshot, &events);
+  if (version != SESSION_VERSION)
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "Unsupported session version %u in %s", version,
+                   filename);
+      return NULL;
+    }
+
+  g_autoptr (GBytes) bytes = g_variant_get_data_as_bytes (screenshot);
+  BoomerangSession *session = session_new (bytes);
+  session->width = width;
+  session->height = height;
+
+  BoomerangSessionEvent event;
+  guchar type;
+  while (g_variant_iter_next (events, "(xydduu)", &event.time, &type, &event.x, &event.y, &event.keyval,
+                              &event.state))
+    {
+      event.type = type;
+      g_array_append_val (session->events, event);
+    }
+
+  return session;
+}
+
+gboolean
+boomerang_session_save (BoomerangSession *session, const char *filename, GError **error)
+{
+  g_return_val_if_fail (session != NULL, FALSE);
+
+  GVariantBuilder events;
+  g_variant_builder_init (&events, G_VARIANT_TYPE ("a(xydduu)"));
+  for (guint i = 0; i < session->events->len; i++)
+    {
+      BoomerangSessionEvent *event = &g_array_index (session->events, BoomerangSessionEvent, i);
+      g_variant_builder_add (&events, "(xydduu)", event->time, (guchar)event->type, event->x, event->y,
+                             event->keyval, event->state);
+    }
+
+  GVariant *screenshot = g_variant_new_from_bytes (G_VARIANT_TYPE_BYTESTRING, session->screenshot, TRUE);
+  g_autoptr (GVariant) variant = g_variant_ref_sink (
+      g_variant_new ("(uii@aya(xydduu))", SESSION_VERSION, session->width, session->height, screenshot, &events));
+  if (G_BYTE_ORDER == G_BIG_ENDIAN)
+    {
+      GVariant *swapped = g_variant_byteswap (variant);
+      g_variant_unref (variant);
+      variant = swapped;
+    }
+
+  return g_file_set_contents (filename, g_variant_get_data (variant), g_variant_get_size (variant), error);
+}
+
+GBytes *
+boomerang_session_get_screenshot (BoomerangSession *session)
+{
+  g_return_val_if_fail (session != NULL, NULL);
+
+  return session->screenshot;
+}
+
+void
+boomerang_session_set_size (BoomerangSession *session, int width, int height)
+{
+  g_return_if_fail (session != NULL);
+
+  session->width = width;
+  session->height = height;
+}
+
+/* returns false if the size was never recorded, which happens when the canvas never received any input */
+gboolean
+boomerang_session_get_size (BoomerangSession *session, int *width, int *height)
+{
+  g_return_val_if_fail (session != NULL, FALSE);
+
+  *width = session->width;
+  *height = session->height;
+  return session->width > 0 && session->height > 0;
+}
+
+void
+boomerang_session_add_event (BoomerangSession *session, const BoomerangSessionEvent *event)
+{
+  g_return_if_fail (session != NULL);
+
+  g_array_append_val (session->events, *event);
+}
+
+const BoomerangSessionEvent *
+boomerang_session_get_events (BoomerangSession *session, guint *n_events)
+{
+  g_return_val_if_fail (session != NULL, NULL);
+
+  *n_events = session->events->len;
+  return (const BoomerangSessionEvent *)session->events->data;
+}
+
+void
+boomerang_session_add_frame (BoomerangSession *session, const BoomerangSessionFrame *frame)
+{
+  g_return_if_fail (session != NULL);
+
+  g_array_append_val (session->frames, *frame);
+}
+
+static int
+session_compare_times (gconstpointer a, gconstpointer b)
+{
+  gint64 time_a = *(const gint64 *)a;
+  gint64 time_b = *(const gint64 *)b;
+  return (time_a > time_b) - (time_a < time_b);
+}
+
+/* writes the timings of each replayed frame as csv, and prints a summary of them */
+gboolean
+boomerang_session_save_report (BoomerangSession *session, const char *filename, GError **error)
+{
+  g_return_val_if_fail (session != NULL, FALSE);
+
+  guint n_frames = session->frames->len;
+  g_autoptr (GString) csv = g_string_new ("frame,time_ms,events,render_ms,interval_ms\n");
+  g_autofree gint64 *render_times = g_new (gint64, MAX (n_frames, 1));
+  gint64 worst_interval = 0;
+  for (guint i = 0; i < n_frames; i++)
+    {
+      BoomerangSessionFrame *frame = &g_array_index (session->frames, BoomerangSessionFrame, i);
+      g_string_append_printf (csv, "%u,%.3f,%u,%.3f,%.3f\n", i, frame->time / 1000.0, frame->events,
+                              frame->render_time / 1000.0, frame->interval / 1000.0);
+      render_times[i] = frame->render_time;
+      worst_interval = MAX (worst_interval, frame->interval);
+    }
+
+  if (!g_file_set_contents (filename, csv->str, csv->len, error))
+    return FALSE;
+
+  if (n_frames > 0)
+    {
+      qsort (render_times, n_frames, sizeof (gint64), session_compare_times);
+      g_print ("Replayed %u frames, render median %.3f ms, 95th percentile %.3f ms, worst %.3f ms, "
+               "worst frame interval %.3f ms\n",
+               n_frames, render_times[n_frames / 2] / 1000.0, render_times[n_frames * 95 / 100] / 1000.0,
+               render_times[n_frames - 1] / 1000.0, worst_interval / 1000.0);
+    }
+  g_print ("Frame timings written to %s\n", filename);
+  return TRUE;
+}
+
+void
+boomerang_session_free (BoomerangSession *session)
+{
+  if (!session)
+    return;
+
+  g_bytes_unref (session->screenshot);
+  g_array_unref (session->events);
+  g_array_unref (session->frames);
+  g_free (session);
+}
@@ -0,0 +1,85 @@
+/* Copyright 2026 Mat Booth
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef BOOMERANG_SESSION_H_
+#define BOOMERANG_SESSION_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+  BOOMERANG_SESSION_MOTION,
+  BOOMERANG_SESSION_SCROLL,
+  BOOMERANG_SESSION_DRAG_UPDATE,
+  BOOMERANG_SESSION_DRAG_END,
+  BOOMERANG_SESSION_KEY_PRESSED,
+  BOOMERANG_SESSION_KEY_RELEASED,
+} BoomerangSessionEventType;
+
+/* an input event as it arrived at the canvas, the time is in microseconds from the start of the recording and the
+ * coordinates are whichever the handler for that type of event takes */
+typedef struct
+{
+  gint64 time;
+  BoomerangSessionEventType type;
+  double x;
+  double y;
+  guint keyval;
+  guint state;
+} BoomerangSessionEvent;
+
+/* how long a replayed frame took, all times in microseconds */
+typedef struct
+{
+  gint64 time;
+  guint events;
+  gint64 render_time;
+  gint64 interval;
+} BoomerangSessionFrame;
+
+typedef struct _BoomerangSession BoomerangSession;
+
+BoomerangSession *boomerang_session_new (GBytes *screenshot);
+
+BoomerangSession *boomerang_session_load (const char *filename, GError **error);
+
+gboolean boomerang_session_save (BoomerangSession *session, const char *filename, GError **error);
+
+GBytes *boomerang_session_get_screenshot (BoomerangSession *session);
+
+void boomerang_session_set_size (BoomerangSession *session, int width, int height);
+
+gboolean boomerang_session_get_size (BoomerangSession *session, int *width, int *height);
+
+void boomerang_session_add_event (BoomerangSession *session, const BoomerangSessionEvent *event);
+
+const BoomerangSessionEvent *boomerang_session_get_events (BoomerangSession *session, guint *n_events);
+
+void boomerang_session_add_frame (BoomerangSession *session, const BoomerangSessionFrame *frame);
+
+gboolean boomerang_session_save_report (BoomerangSession *session, const char *filename, GError **error);
+
+void boomerang_session_free (BoomerangSession *session);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (BoomerangSession, boomerang_session_free)
+
+G_END_DECLS
+
+#endif /* BOOMERANG_SESSION_H_ */
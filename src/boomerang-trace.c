@@ -0,0 +1,201 @@
+/* Copyright 2026 Mat Booth
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "config.h"
+
+#include "boomerang-trace.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#ifdef HAVE_SYSPROF
+#include <sysprof-capture.h>
+#endif
+
+/* number of spans retained by the built-in recorder, older spans are overwritten once the buffer is full */
+#define TRACE_BUFFER_SIZE 4096
+
+typedef struct _TraceSpan TraceSpan;
+struct _TraceSpan
+{
+  gint64 begin_time;
+  gint64 duration;
+  const char *name;
+  char *message;
+  guint thread;
+};
+
+typedef struct _TraceBuffer TraceBuffer;
+struct _TraceBuffer
+{
+  char *filename;
+
+  TraceSpan spans[TRACE_BUFFER_SIZE];
+  guint64 count;
+};
+
+static TraceBuffer *trace_buffer = NULL;
+G_LOCK_DEFINE_STATIC (trace_buffer);
+
+static guint
+trace_thread_id (void)
+{
+  static guint next_id = 1;
+  static GPrivate thread_id;
+
+  /* give each thread a small stable number rather than using the pointer value of the thread */
+  guint id = GPOINTER_TO_UINT (g_private_get (&thread_id));
+  if (!id)
+    {
+      id = g_atomic_int_add (&next_id, 1);
+      g_private_set (&thread_id, GUINT_TO_POINTER (id));
+    }
+  return id;
+}
+
+static gboolean
+trace_enabled (void)
+{
+  static gsize initialised = 0;
+
+  /* the built-in recorder is enabled by naming the file to which the trace will be written at exit */
+  if (g_once_init_enter (&initialised))
+    {
+      const char *filename = g_getenv ("BOOMERANG_TRACE_FILE");
+      if (filename && *filename)
+        {
+          trace_buffer = g_new0 (TraceBuffer, 1);
+          trace_buffer->filename = g_strdup (filename);
+        }
+      g_once_init_leave (&initialised, 1);
+    }
+
+#ifdef HAVE_SYSPROF
+  if (sysprof_collector_is_active ())
+    return TRUE;
+#endif
+
+  return trace_buffer != NULL;
+}
+
+/* returns the start time of a new span in nanoseconds on the monotonic clock, or zero if tracing is disabled */
+gint64
+boomerang_trace_begin (void)
+{
+  if (!trace_enabled ())
+    return 0;
+
+  /* this is the same clock used by sysprof, so spans line up with samples from the rest of the system */
+  return g_get_monotonic_time () * 1000;
+}
+
+/* ends a span that was started with boomerang_trace_begin(), the name must be a static string */
+void
+boomerang_trace_end (gint64 begin_time, const char *name, const char *message_format, ...)
+{
+  if (begin_time == 0)
+    return;
+
+  gint64 duration = g_get_monotonic_time () * 1000 - begin_time;
+
+  g_autofree char *message = NULL;
+  if (message_format)
+    {
+      va_list args;
+      va_start (args, message_format);
+      message = g_strdup_vprintf (message_format, args);
+      va_end (args);
+    }
+
+#ifdef HAVE_SYSPROF
+  sysprof_collector_mark (begin_time, duration, "Boomerang", name, message);
+#endif
+
+  if (trace_buffer)
+    {
+      guint thread = trace_thread_id ();
+
+      G_LOCK (trace_buffer);
+      TraceSpan *span = &trace_buffer->spans[trace_buffer->count++ % TRACE_BUFFER_SIZE];
+      g_free (span->message);
+      span->begin_time = begin_time;
+      span->duration = duration;
+      span->name = name;
+      span->message = g_steal_pointer (&message);
+      span->thread = thread;
+      G_UNLOCK (trace_buffer);
+    }
+}
+
+static void
+trace_write_json_string (FILE *file, const char *str)
+{
+  fputc ('"', file);
+  for (const char *c = str; *c; c++)
+    {
+      if (*c == '"' || *c == '\\')
+        fprintf (file, "\\%c", *c);
+      else if ((unsigned char)*c < 0x20)
+        fprintf (file, "\\u%04x", (unsigned char)*c);
+      else
+        fputc (*c, file);
+    }
+  fputc ('"', file);
+}
+
+/* writes spans held by the built-in recorder in the chrome trace event format, which can be loaded into Perfetto or
+ * chrome://tracing */
+void
+boomerang_trace_shutdown (void)
+{
+  if (!trace_buffer)
+    return;
+
+  FILE *file = fopen (trace_buffer->filename, "w");
+  if (!file)
+    {
+      g_printerr ("Error: Unable to write trace file %s: %s\n", trace_buffer->filename, g_strerror (errno));
+      return;
+    }
+
+  G_LOCK (trace_buffer);
+
+  guint64 first = trace_buffer->count > TRACE_BUFFER_SIZE ? trace_buffer->count - TRACE_BUFFER_SIZE : 0;
+  fprintf (file, "{\"traceEvents\":[\n");
+  for (guint64 i = first; i < trace_buffer->count; i++)
+    {
+      TraceSpan *span = &trace_buffer->spans[i % TRACE_BUFFER_SIZE];
+      fprintf (file, "%s{\"name\":", i == first ? "" : ",\n");
+      trace_write_json_string (file, span->name);
+      fprintf (file, ",\"cat\":\"boomerang\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%u",
+               span->begin_time / 1000.0, span->duration / 1000.0, (int)getpid (), span->thread);
+      if (span->message)
+        {
+          fprintf (file, ",\"args\":{\"message\":");
+          trace_write_json_string (file, span->message);
+          fprintf (file, "}");
+        }
+      fprintf (file, "}");
+    }
+  fprintf (file, "\n]}\n");
+
+  G_UNLOCK (trace_buffer);
+
+  fclose (file);
+}
@@ -20,6 +20,7 @@
 #include <glib/gi18n.h>
 
 #include "boomerang-application.h"
+#include "boomerang-trace.h"
 
 int
 main (int argc, char **argv)
@@ -31,6 +32,7 @@ main (int argc, char **argv)
   g_autoptr (BoomerangApplication) app = boomerang_application_new ();
 
   int status = g_application_run (G_APPLICATION (app), argc, argv);
+  boomerang_trace_shutdown ();
   if (boomerang_application_get_status (app) != 0)
     {
       status = boomerang_application_get_status (app);
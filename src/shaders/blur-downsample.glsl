@@ -0,0 +1,19 @@
+#version 300 es
+precision mediump float;
+
+in vec2 textureCoord;
+out vec4 fragColor;
+
+uniform sampler2D sourceTexture;
+uniform vec2 halfPixel;
+
+/* the downsampling pass of a dual kawase blur, five bilinear samples weighted towards the centre */
+void main()
+{
+  vec4 sum = texture(sourceTexture, textureCoord) * 4.0;
+  sum += texture(sourceTexture, textureCoord - halfPixel);
+  sum += texture(sourceTexture, textureCoord + halfPixel);
+  sum += texture(sourceTexture, textureCoord + vec2(halfPixel.x, -halfPixel.y));
+  sum += texture(sourceTexture, textureCoord - vec2(halfPixel.x, -halfPixel.y));
+  fragColor = sum / 8.0;
+}
@@ -0,0 +1,22 @@
+#version 300 es
+precision mediump float;
+
+in vec2 textureCoord;
+out vec4 fragColor;
+
+uniform sampler2D sourceTexture;
+uniform vec2 halfPixel;
+
+/* the upsampling pass of a dual kawase blur, eight bilinear samples in a diamond around the centre */
+void main()
+{
+  vec4 sum = texture(sourceTexture, textureCoord + vec2(-halfPixel.x * 2.0, 0.0));
+  sum += texture(sourceTexture, textureCoord + vec2(-halfPixel.x, halfPixel.y)) * 2.0;
+  sum += texture(sourceTexture, textureCoord + vec2(0.0, halfPixel.y * 2.0));
+  sum += texture(sourceTexture, textureCoord + vec2(halfPixel.x, halfPixel.y)) * 2.0;
+  sum += texture(sourceTexture, textureCoord + vec2(halfPixel.x * 2.0, 0.0));
+  sum += texture(sourceTexture, textureCoord + vec2(halfPixel.x, -halfPixel.y)) * 2.0;
+  sum += texture(sourceTexture, textureCoord + vec2(0.0, -halfPixel.y * 2.0));
+  sum += texture(sourceTexture, textureCoord + vec2(-halfPixel.x, -halfPixel.y)) * 2.0;
+  fragColor = sum / 12.0;
+}
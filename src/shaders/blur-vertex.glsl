@@ -0,0 +1,17 @@
+#version 300 es
+precision mediump float;
+
+out vec2 textureCoord;
+
+void main()
+{
+  /* a single triangle that covers the whole frame buffer, generated from the vertex index so no vertex buffer is
+   * needed, the winding is clockwise to match the front face of the main program */
+  vec2 pos = vec2(float((gl_VertexID & 2) << 1) - 1.0, float((gl_VertexID & 1) << 2) - 1.0);
+
+  /* texture and frame buffer rows are in the same order, so every level of the blur pyramid has the same orientation
+   * as the screenshot */
+  textureCoord = pos * 0.5 + 0.5;
+
+  gl_Position = vec4(pos, 0.0, 1.0);
+}
@@ -1,20 +1,108 @@
 #version 300 es
 precision mediump float;
 
-in vec2 textureCoord;
+in highp vec2 textureCoord;
 out vec4 fragColor;
 
 uniform sampler2D screenshotTexture;
+uniform sampler2D blurredTexture;
 uniform vec2 resolution;
 uniform vec2 pointer;
 uniform bool fenabled;
-uniform float fradius;
+uniform bool benabled;
+
+/* how strongly the grid between the pixels of the screenshot is drawn, zero until they are big enough to tell apart */
+uniform float gridOpacity;
+
+/* spotlight shapes */
+const int SPOTLIGHT_CIRCLE = 0;
+const int SPOTLIGHT_ELLIPSE = 1;
+const int SPOTLIGHT_RECT = 2;
+const int SPOTLIGHT_ROUNDED_RECT = 3;
+
+/* the flashlight under the pointer plus any pinned spotlights, every fragment evaluates the distance to each of them
+ * so the limit is kept small, this must match MAX_SPOTLIGHTS in the canvas */
+const int MAX_SPOTLIGHTS = 16;
+
+struct Spotlight
+{
+  vec4 geometry; /* centre and half size in normalised device coordinates */
+  vec4 params;   /* shape and corner radius */
+};
+
+layout(std140) uniform Spotlights
+{
+  int count;
+  Spotlight spotlight[MAX_SPOTLIGHTS];
+} spotlights;
+
+/* lens shapes */
+const int LENS_CIRCLE = 0;
+const int LENS_ROUNDED_RECT = 1;
+
+uniform bool lenabled;
+uniform int lshape;
+uniform highp vec2 lcentre;
+uniform float lzoom;
+uniform float lradius;
 
 /* debug output */
 uniform bool debugging;
 uniform float fradiusStart;
 uniform float fradiusTarget;
 
+/* signed distance from the edge of a spotlight, negative inside the spotlight */
+float spotlightDistance(Spotlight s, vec2 c)
+{
+  vec2 q = c - s.geometry.xy;
+  vec2 size = s.geometry.zw;
+  int shape = int(s.params.x);
+  if (shape == SPOTLIGHT_ELLIPSE)
+  {
+    /* an approximation that is close to the true distance near the edge, which is all we need for anti-aliasing */
+    float k0 = length(q / size);
+    float k1 = length(q / (size * size));
+    /* the approximation divides by zero at the centre, which is as far inside as the shortest radius */
+    if (k1 == 0.0)
+      return -min(size.x, size.y);
+    return k0 * (k0 - 1.0) / k1;
+  }
+  if (shape == SPOTLIGHT_RECT || shape == SPOTLIGHT_ROUNDED_RECT)
+  {
+    float corner = s.params.y;
+    vec2 d = abs(q) - size + corner;
+    return length(max(d, 0.0)) + min(max(d.x, d.y), 0.0) - corner;
+  }
+  return length(q) - size.x;
+}
+
+/* outlines each pixel of the screenshot with a line one fragment wide, found from how far the texture coordinate is
+ * from the nearest texel edge measured in fragments, so it costs the same at any zoom level and needs no geometry */
+vec4 pixelGrid(vec4 col, highp vec2 coord)
+{
+  highp vec2 texel = coord * vec2(textureSize(screenshotTexture, 0));
+  highp vec2 edge = abs(fract(texel - 0.5) - 0.5) / fwidth(texel);
+  float line = 1.0 - clamp(min(edge.x, edge.y), 0.0, 1.0);
+
+  /* light lines over dark pixels and dark lines over light ones */
+  float luminance = dot(col.rgb, vec3(0.2126, 0.7152, 0.0722));
+  vec4 lineColour = vec4(vec3(step(luminance, 0.5)), 1.0);
+  return mix(col, lineColour, line * gridOpacity * 0.4);
+}
+
+/* signed distance from the edge of the lens, negative inside the lens */
+float lensDistance(vec2 c, vec2 p)
+{
+  if (lshape == LENS_ROUNDED_RECT)
+  {
+    vec2 size = vec2(lradius * 1.6, lradius);
+    float corner = lradius * 0.25;
+    vec2 q = abs(c - p) - size + corner;
+    return length(max(q, 0.0)) + min(max(q.x, q.y), 0.0) - corner;
+  }
+  return distance(c, p) - lradius;
+}
+
 void main()
 {
   /* fragment coord (c) and mouse pointer (p) as normalised device coordinates */
@@ -22,20 +110,50 @@ void main()
   vec2 c = (2.0 * gl_FragCoord.xy - resolution) / divisor;
   vec2 p = (2.0 * pointer - resolution) / divisor;
 
-  /* generate a blending factor gradient along the edge of the flashlight area, to
-   * give an anti-aliased appearance to the edge of the vignette */
-  float dist = distance(c, p);
+  /* the lit area is the union of all the spotlights, so take the nearest edge and generate a blending factor
+   * gradient along it, to give an anti-aliased appearance to the edge of the vignette */
+  float dist = 1000.0;
+  for (int i = 0; i < spotlights.count; i++)
+  {
+    dist = min(dist, spotlightDistance(spotlights.spotlight[i], c));
+  }
   float delta = fwidth(dist) * 2.5;
-  float alpha = smoothstep(fradius - delta, fradius + delta, dist);
+  float alpha = smoothstep(-delta, delta, dist);
 
-  /* blend only when the flashlight is enabled, and clamp the factor to something less
+  /* blend only when there are spotlights, and clamp the factor to something less
    * than one so the vignette is always slightly transparent */
-  float blend = fenabled ? min(alpha, 0.6) : 0.0;
+  alpha = spotlights.count > 0 ? alpha : 0.0;
+  float blend = min(alpha, 0.6);
 
+  /* outside the spotlights the screenshot is replaced by a copy that was blurred when it was loaded, so the cost of
+   * the blur here is just one more texture sample */
   vec4 screenshot = texture(screenshotTexture, textureCoord);
+  if (benabled)
+  {
+    screenshot = mix(screenshot, texture(blurredTexture, textureCoord), alpha);
+  }
+  if (gridOpacity > 0.0)
+  {
+    screenshot = pixelGrid(screenshot, textureCoord);
+  }
   vec4 vignette = vec4(0.0, 0.0, 0.0, 1.0);
   vec4 col = mix(screenshot, vignette, blend);
 
+  /* the lens samples the screenshot a second time, magnified about the texture coordinate under the pointer, and
+   * is composited over the main view with an anti-aliased edge and a thin outline */
+  if (lenabled)
+  {
+    float ldist = lensDistance(c, p);
+    float ldelta = fwidth(ldist) * 1.5;
+    float outside = smoothstep(-ldelta, ldelta, ldist);
+    highp vec2 lensCoord = lcentre + (textureCoord - lcentre) / lzoom;
+    bool inBounds = all(greaterThanEqual(lensCoord, vec2(0.0))) && all(lessThanEqual(lensCoord, vec2(1.0)));
+    vec4 lens = inBounds ? texture(screenshotTexture, lensCoord) : vignette;
+    col = mix(lens, col, outside);
+    float outline = 1.0 - smoothstep(0.0, ldelta * 2.0, abs(ldist + ldelta * 2.0));
+    col = mix(col, vec4(1.0), outline * 0.8);
+  }
+
   vec4 startIndicator = vec4(0.0, 1.0, 0.0, 1.0);
   vec4 targetIndicator = vec4(1.0, 0.0, 0.0, 1.0);
   float start = float(debugging && fenabled && length(c - p) >= fradiusStart - 0.0005 && length(c - p) <= fradiusStart + 0.0005);
@@ -0,0 +1,296 @@
+/* Copyright 2026 Mat Booth
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/* a stand-in for the screenshot portal of xdg-desktop-portal, which answers every request with the same generated
+ * image after a delay, or with the response given on the command line */
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <gio/gio.h>
+#include <glib-unix.h>
+#include <glib/gstdio.h>
+
+#define PORTAL_BUS "org.freedesktop.portal.Desktop"
+#define PORTAL_PATH "/org/freedesktop/portal/desktop"
+#define REQUEST_PATH PORTAL_PATH "/request/"
+
+static const char introspection_xml[] = "<node>"
+                                        "  <interface name='org.freedesktop.portal.Screenshot'>"
+                                        "    <method name='Screenshot'>"
+                                        "      <arg type='s' name='parent_window' direction='in'/>"
+                                        "      <arg type='a{sv}' name='options' direction='in'/>"
+                                        "      <arg type='o' name='handle' direction='out'/>"
+                                        "    </method>"
+                                        "    <property name='version' type='u' access='read'/>"
+                                        "  </interface>"
+                                        "  <interface name='uk.co.matbooth.Boomerang.MockPortal'>"
+                                        "    <method name='GetClosed'>"
+                                        "      <arg type='u' name='closed' direction='out'/>"
+                                        "    </method>"
+                                        "  </interface>"
+                                        "  <interface name='org.freedesktop.portal.Request'>"
+                                        "    <method name='Close'/>"
+                                        "  </interface>"
+                                        "</node>";
+
+typedef struct
+{
+  GDBusConnection *conn;
+  char *sender;
+  char *path;
+  guint registration_id;
+  guint timeout_id;
+} Request;
+
+static int width = 1920;
+static int height = 1080;
+static int delay = 0;
+static int response = 0;
+
+static GDBusNodeInfo *introspection;
+static char *image_dir;
+static char *image_uri;
+static guint closed;
+
+static void
+request_free (Request *request)
+{
+  if (request->timeout_id)
+    g_source_remove (request->timeout_id);
+  g_dbus_connection_unregister_object (request->conn, request->registration_id);
+  g_object_unref (request->conn);
+  g_free (request->sender);
+  g_free (request->path);
+  g_free (request);
+}
+
+static gboolean
+request_respond_cb (gpointer data)
+{
+  Request *request = data;
+  request->timeout_id = 0;
+
+  GVariantBuilder results;
+  g_variant_builder_init (&results, G_VARIANT_TYPE ("a{sv}"));
+  if (response == 0)
+    g_variant_builder_add (&results, "{sv}", "uri", g_variant_new_string (image_uri));
+
+  /* like the real portal, the response is sent only to the application that asked for it */
+  GError *error = NULL;
+  if (!g_dbus_connection_emit_signal (request->conn, request->sender, request->path, "org.freedesktop.portal.Request",
+                                      "Response", g_variant_new ("(ua{sv})", response, &results), &error))
+    {
+      g_printerr ("Error: %s\n", error->message);
+      g_error_free (error);
+    }
+
+  request_free (request);
+  return G_SOURCE_REMOVE;
+}
+
+static void
+request_method_call (GDBusConnection *conn, const char *sender, const char *object_path, const char *interface_name,
+                     const char *method_name, GVariant *parameters, GDBusMethodInvocation *invocation, gpointer data)
+{
+  /* closing the request means no response is sent */
+  closed++;
+  request_free (data);
+  g_dbus_method_invocation_return_value (invocation, NULL);
+}
+
+static const GDBusInterfaceVTable request_vtable = { request_method_call, NULL, NULL };
+
+static void
+portal_screenshot (GDBusConnection *conn, const char *sender, GVariant *parameters, GDBusMethodInvocation *invocation)
+{
+  g_autoptr (GVariant) options = NULL;
+  const char *token = NULL;
+  g_variant_get (parameters, "(&s@a{sv})", NULL, &options);
+  if (!g_variant_lookup (options, "handle_token", "&s", &token))
+    {
+      g_dbus_method_invocation_return_error (invocation, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                                             "Only requests with a handle token are supported");
+      return;
+    }
+
+  /* the request object path is made from the unique name of the caller and the token it chose */
+  g_autofree char *caller = g_strdup (sender + 1);
+  g_strdelimit (caller, ".", '_');
+
+  Request *request = g_new0 (Request, 1);
+  request->conn = g_object_ref (conn);
+  request->sender = g_strdup (sender);
+  request->path = g_strconcat (REQUEST_PATH, caller, "/", token, NULL);
+
+  GError *error = NULL;
+  GDBusInterfaceInfo *info = g_dbus_node_info_lookup_interface (introspection, "org.freedesktop.portal.Request");
+  request->registration_id
+      = g_dbus_connection_register_object (conn, request->path, info, &request_vtable, request, NULL, &error);
+  if (!request->registration_id)
+    {
+      g_dbus_method_invocation_take_error (invocation, error);
+      g_object_unref (request->conn);
+      g_free (request->sender);
+      g_free (request->path);
+      g_free (request);
+      return;
+    }
+
+  request->timeout_id = g_timeout_add (delay, request_respond_cb, request);
+  g_dbus_method_invocation_return_value (invocation, g_variant_new ("(o)", request->path));
+}
+
+static void
+portal_method_call (GDBusConnection *conn, const char *sender, const char *object_path, const char *interface_name,
+                    const char *method_name, GVariant *parameters, GDBusMethodInvocation *invocation, gpointer data)
+{
+  if (g_str_equal (method_name, "Screenshot"))
+    portal_screenshot (conn, sender, parameters, invocation);
+  else if (g_str_equal (method_name, "GetClosed"))
+    g_dbus_method_invocation_return_value (invocation, g_variant_new ("(u)", closed));
+  else
+    g_dbus_method_invocation_return_error (invocation, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD,
+                                           "Unknown method %s", method_name);
+}
+
+static GVariant *
+portal_get_property (GDBusConnection *conn, const char *sender, const char *object_path, const char *interface_name,
+                     const char *property_name, GError **error, gpointer data)
+{
+  return g_variant_new_uint32 (2);
+}
+
+static const GDBusInterfaceVTable portal_vtable = { portal_method_call, portal_get_property, NULL };
+
+static void
+bus_acquired_cb (GDBusConnection *conn, const char *name, gpointer data)
+{
+  const char *interfaces[] = { "org.freedesktop.portal.Screenshot", "uk.co.matbooth.Boomerang.MockPortal" };
+  for (guint i = 0; i < G_N_ELEMENTS (interfaces); i++)
+    {
+      GError *error = NULL;
+      GDBusInterfaceInfo *info = g_dbus_node_info_lookup_interface (introspection, interfaces[i]);
+      if (!g_dbus_connection_register_object (conn, PORTAL_PATH, info, &portal_vtable, NULL, NULL, &error))
+        {
+          g_printerr ("Error: %s\n", error->message);
+          g_error_free (error);
+          g_main_loop_quit (data);
+        }
+    }
+}
+
+static void
+name_lost_cb (GDBusConnection *conn, const char *name, gpointer data)
+{
+  g_printerr ("Error: Unable to own %s\n", name);
+  g_main_loop_quit (data);
+}
+
+static gboolean
+terminate_cb (gpointer data)
+{
+  g_main_loop_quit (data);
+  return G_SOURCE_REMOVE;
+}
+
+/* paints flat panels and a gradient, with a grid of fine lines that compress about as well as text does */
+static gboolean
+create_image (GError **error)
+{
+  GdkPixbuf *pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, FALSE, 8, width, height);
+  int stride = gdk_pixbuf_get_rowstride (pixbuf);
+  guchar *pixels = gdk_pixbuf_get_pixels (pixbuf);
+
+  for (int y = 0; y < height; y++)
+    {
+      guchar *p = pixels + (gsize)y * stride;
+      for (int x = 0; x < width; x++, p += 3)
+        {
+          if ((x / 480 + y / 270) % 2 == 0)
+            {
+              p[0] = x * 255 / width;
+              p[1] = y * 255 / height;
+              p[2] = 0x80;
+            }
+          else
+            {
+              p[0] = p[1] = p[2] = 0xf6;
+            }
+          if (x % 7 == 0 || y % 11 == 0)
+            p[0] = p[1] = p[2] = 0x24;
+        }
+    }
+
+  image_dir = g_dir_make_tmp ("boomerang-mock-portal-XXXXXX", error);
+  g_autofree char *filename = image_dir ? g_build_filename (image_dir, "screenshot.png", NULL) : NULL;
+  gboolean saved = filename && gdk_pixbuf_save (pixbuf, filename, "png", error, NULL);
+  g_object_unref (pixbuf);
+  if (saved)
+    image_uri = g_filename_to_uri (filename, NULL, error);
+  return image_uri != NULL;
+}
+
+static void
+remove_image (void)
+{
+  if (!image_dir)
+    return;
+  g_autofree char *filename = g_build_filename (image_dir, "screenshot.png", NULL);
+  g_unlink (filename);
+  g_rmdir (image_dir);
+}
+
+int
+main (int argc, char *argv[])
+{
+  GOptionEntry entries[] = { { "width", 0, G_OPTION_FLAG_NONE, G_OPTION_ARG_INT, &width, "Width of the image", "W" },
+                             { "height", 0, G_OPTION_FLAG_NONE, G_OPTION_ARG_INT, &height, "Height of the image", "H" },
+                             { "delay", 0, G_OPTION_FLAG_NONE, G_OPTION_ARG_INT, &delay,
+                               "Milliseconds to wait before responding", "MS" },
+                             { "response", 0, G_OPTION_FLAG_NONE, G_OPTION_ARG_INT, &response,
+                               "Response code, 0 for success, 1 if the user cancelled, 2 for failure", "CODE" },
+                             G_OPTION_ENTRY_NULL };
+
+  GError *error = NULL;
+  g_autoptr (GOptionContext) context = g_option_context_new (NULL);
+  g_option_context_add_main_entries (context, entries, NULL);
+  if (!g_option_context_parse (context, &argc, &argv, &error) || !create_image (&error))
+    {
+      g_printerr ("Error: %s\n", error->message);
+      g_error_free (error);
+      remove_image ();
+      return 1;
+    }
+
+  introspection = g_dbus_node_info_new_for_xml (introspection_xml, NULL);
+
+  GMainLoop *loop = g_main_loop_new (NULL, FALSE);
+  g_unix_signal_add (SIGTERM, terminate_cb, loop);
+  g_unix_signal_add (SIGINT, terminate_cb, loop);
+  guint owner_id = g_bus_own_name (G_BUS_TYPE_SESSION, PORTAL_BUS, G_BUS_NAME_OWNER_FLAGS_NONE, bus_acquired_cb, NULL,
+                                   name_lost_cb, loop, NULL);
+
+  g_main_loop_run (loop);
+
+  g_bus_unown_name (owner_id);
+  g_main_loop_unref (loop);
+  g_dbus_node_info_unref (introspection);
+  remove_image ();
+  g_free (image_uri);
+  g_free (image_dir);
+  return 0;
+}
@@ -0,0 +1,158 @@
+/* Copyright 2026 Mat Booth
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/* a stand-in for the screenshot service of gnome shell, which writes a flat image of the size given on the command
+ * line, or of the area asked for, to the file named by the caller */
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <gio/gio.h>
+#include <glib-unix.h>
+
+#define SHELL_BUS "org.gnome.Shell.Screenshot"
+#define SHELL_PATH "/org/gnome/Shell/Screenshot"
+
+static const char introspection_xml[] = "<node>"
+                                        "  <interface name='org.gnome.Shell.Screenshot'>"
+                                        "    <method name='Screenshot'>"
+                                        "      <arg type='b' name='include_cursor' direction='in'/>"
+                                        "      <arg type='b' name='flash' direction='in'/>"
+                                        "      <arg type='s' name='filename' direction='in'/>"
+                                        "      <arg type='b' name='success' direction='out'/>"
+                                        "      <arg type='s' name='filename_used' direction='out'/>"
+                                        "    </method>"
+                                        "    <method name='ScreenshotArea'>"
+                                        "      <arg type='i' name='x' direction='in'/>"
+                                        "      <arg type='i' name='y' direction='in'/>"
+                                        "      <arg type='i' name='width' direction='in'/>"
+                                        "      <arg type='i' name='height' direction='in'/>"
+                                        "      <arg type='b' name='flash' direction='in'/>"
+                                        "      <arg type='s' name='filename' direction='in'/>"
+                                        "      <arg type='b' name='success' direction='out'/>"
+                                        "      <arg type='s' name='filename_used' direction='out'/>"
+                                        "    </method>"
+                                        "  </interface>"
+                                        "</node>";
+
+static int width = 1920;
+static int height = 1080;
+
+static GDBusNodeInfo *introspection;
+
+static void
+shell_screenshot (GDBusMethodInvocation *invocation, int image_width, int image_height, const char *filename)
+{
+  GdkPixbuf *pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, FALSE, 8, image_width, image_height);
+  gdk_pixbuf_fill (pixbuf, 0x3584e4ff);
+
+  /* like the real shell, failing to write the file is reported as an unsuccessful screenshot */
+  GError *error = NULL;
+  gboolean success = gdk_pixbuf_save (pixbuf, filename, "png", &error, NULL);
+  if (!success)
+    {
+      g_printerr ("Error: %s\n", error->message);
+      g_error_free (error);
+    }
+  g_object_unref (pixbuf);
+
+  g_dbus_method_invocation_return_value (invocation, g_variant_new ("(bs)", success, filename));
+}
+
+static void
+shell_method_call (GDBusConnection *conn, const char *sender, const char *object_path, const char *interface_name,
+                   const char *method_name, GVariant *parameters, GDBusMethodInvocation *invocation, gpointer data)
+{
+  const char *filename;
+  int area_width, area_height;
+  if (g_str_equal (method_name, "Screenshot"))
+    {
+      g_variant_get (parameters, "(bb&s)", NULL, NULL, &filename);
+      shell_screenshot (invocation, width, height, filename);
+    }
+  else if (g_str_equal (method_name, "ScreenshotArea"))
+    {
+      g_variant_get (parameters, "(iiiib&s)", NULL, NULL, &area_width, &area_height, NULL, &filename);
+      shell_screenshot (invocation, area_width, area_height, filename);
+    }
+  else
+    {
+      g_dbus_method_invocation_return_error (invocation, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD,
+                                             "Unknown method %s", method_name);
+    }
+}
+
+static const GDBusInterfaceVTable shell_vtable = { shell_method_call, NULL, NULL };
+
+static void
+bus_acquired_cb (GDBusConnection *conn, const char *name, gpointer data)
+{
+  GError *error = NULL;
+  GDBusInterfaceInfo *info = g_dbus_node_info_lookup_interface (introspection, "org.gnome.Shell.Screenshot");
+  if (!g_dbus_connection_register_object (conn, SHELL_PATH, info, &shell_vtable, NULL, NULL, &error))
+    {
+      g_printerr ("Error: %s\n", error->message);
+      g_error_free (error);
+      g_main_loop_quit (data);
+    }
+}
+
+static void
+name_lost_cb (GDBusConnection *conn, const char *name, gpointer data)
+{
+  g_printerr ("Error: Unable to own %s\n", name);
+  g_main_loop_quit (data);
+}
+
+static gboolean
+terminate_cb (gpointer data)
+{
+  g_main_loop_quit (data);
+  return G_SOURCE_REMOVE;
+}
+
+int
+main (int argc, char *argv[])
+{
+  GOptionEntry entries[] = { { "width", 0, G_OPTION_FLAG_NONE, G_OPTION_ARG_INT, &width, "Width of the image", "W" },
+                             { "height", 0, G_OPTION_FLAG_NONE, G_OPTION_ARG_INT, &height, "Height of the image", "H" },
+                             G_OPTION_ENTRY_NULL };
+
+  GError *error = NULL;
+  g_autoptr (GOptionContext) context = g_option_context_new (NULL);
+  g_option_context_add_main_entries (context, entries, NULL);
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("Error: %s\n", error->message);
+      g_error_free (error);
+      return 1;
+    }
+
+  introspection = g_dbus_node_info_new_for_xml (introspection_xml, NULL);
+
+  GMainLoop *loop = g_main_loop_new (NULL, FALSE);
+  g_unix_signal_add (SIGTERM, terminate_cb, loop);
+  g_unix_signal_add (SIGINT, terminate_cb, loop);
+  guint owner_id = g_bus_own_name (G_BUS_TYPE_SESSION, SHELL_BUS, G_BUS_NAME_OWNER_FLAGS_NONE, bus_acquired_cb, NULL,
+                                   name_lost_cb, loop, NULL);
+
+  g_main_loop_run (loop);
+
+  g_bus_unown_name (owner_id);
+  g_main_loop_unref (loop);
+  g_dbus_node_info_unref (introspection);
+  return 0;
+}
@@ -0,0 +1,491 @@
+/* Copyright 2026 Mat Booth
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/* runs boomerang against the mock portal and measures each stage of getting a screenshot onto the screen, from the
+ * spans in its trace file, failing if any stage takes longer than the thresholds allow, and checks that the remote
+ * control interface it exports on the private bus applies the commands it accepts and nothing else */
+
+#include "test-util.h"
+
+#include <glib/gstdio.h>
+#include <signal.h>
+#include <string.h>
+
+/* milliseconds the mock portal waits before answering, roughly what a real one takes */
+#define CAPTURE_DELAY 100
+
+/* name of the socket of the headless compositor started when there is no display, and how long to wait for it to
+ * appear in seconds */
+#define HEADLESS_SOCKET "boomerang-test-0"
+#define HEADLESS_TIMEOUT 10
+
+/* where boomerang exports its remote control interface, and how long to wait for it to show a screenshot in seconds */
+#define APPLICATION_BUS "uk.co.matbooth.Boomerang"
+#define APPLICATION_PATH "/uk/co/matbooth/Boomerang"
+#define REMOTE_INTERFACE "uk.co.matbooth.Boomerang.RemoteControl"
+#define REMOTE_TIMEOUT 10
+
+/* milliseconds to give the canvas to apply the commands queued for its next frame, which are dropped if it quits
+ * before then */
+#define REMOTE_SETTLE 1000
+
+typedef struct
+{
+  const char *name;
+  int width;
+  int height;
+} Resolution;
+
+static const Resolution resolutions[] = {
+  { "1080p", 1920, 1080 },
+  { "4k", 3840, 2160 },
+};
+
+/* stages measured, each the time between two points in the trace in milliseconds */
+typedef enum
+{
+  STAGE_STARTUP,
+  STAGE_CAPTURE,
+  STAGE_DECODE,
+  STAGE_UPLOAD,
+  STAGE_FIRST_FRAME,
+  N_STAGES
+} Stage;
+
+/* renderers the canvas can draw with, each checked on its own */
+static const char *renderers[] = { "gl", "gsk" };
+
+static const char *stage_names[] = { "startup", "capture", "decode", "upload", "first-frame" };
+
+typedef struct
+{
+  double begin;
+  double end;
+} Span;
+
+static GKeyFile *thresholds;
+static GKeyFile *results;
+
+/* where to find the display, which the isolated test environment and the private bus would otherwise hide */
+static char *display;
+static char *wayland_display;
+static char *runtime_dir;
+
+/* compositor started to run boomerang on when there is no display, and the runtime directory made for its socket */
+static GSubprocess *compositor;
+static char *headless_runtime_dir;
+
+/* finds the first span with the given name to finish, with times in milliseconds relative to the given start */
+static gboolean
+trace_find_span (const char *trace, const char *name, gint64 start, Span *span)
+{
+  g_autoptr (GRegex) regex = g_regex_new ("\\{\"name\":\"([^\"]*)\",[^\\n]*\"ts\":([0-9.]+),\"dur\":([0-9.]+)",
+                                          G_REGEX_DEFAULT, G_REGEX_MATCH_DEFAULT, NULL);
+  g_autoptr (GMatchInfo) match = NULL;
+  g_regex_match (regex, trace, G_REGEX_MATCH_DEFAULT, &match);
+  for (; g_match_info_matches (match); g_match_info_next (match, NULL))
+    {
+      g_autofree char *match_name = g_match_info_fetch (match, 1);
+      if (!g_str_equal (match_name, name))
+        continue;
+
+      g_autofree char *ts = g_match_info_fetch (match, 2);
+      g_autofree char *dur = g_match_info_fetch (match, 3);
+      span->begin = (g_ascii_strtod (ts, NULL) - start) / 1000.0;
+      span->end = span->begin + g_ascii_strtod (dur, NULL) / 1000.0;
+      return TRUE;
+    }
+  return FALSE;
+}
+
+static Span
+trace_get_span (const char *trace, const char *name, gint64 start)
+{
+  Span span;
+  if (!trace_find_span (trace, name, start, &span))
+    g_error ("No %s span in the trace", name);
+  return span;
+}
+
+/* counts the spans with the given name and message */
+static guint
+trace_count_spans (const char *trace, const char *name, const char *message)
+{
+  g_autoptr (GRegex) regex = g_regex_new ("\\{\"name\":\"([^\"]*)\",[^\\n]*\"args\":\\{\"message\":\"([^\"]*)\"\\}",
+                                          G_REGEX_DEFAULT, G_REGEX_MATCH_DEFAULT, NULL);
+  g_autoptr (GMatchInfo) match = NULL;
+  guint count = 0;
+  g_regex_match (regex, trace, G_REGEX_MATCH_DEFAULT, &match);
+  for (; g_match_info_matches (match); g_match_info_next (match, NULL))
+    {
+      g_autofree char *match_name = g_match_info_fetch (match, 1);
+      g_autofree char *match_message = g_match_info_fetch (match, 2);
+      if (g_str_equal (match_name, name) && g_str_equal (match_message, message))
+        count++;
+    }
+  return count;
+}
+
+static GSubprocessLauncher *
+boomerang_launcher_new (GSubprocessFlags flags, const char *trace_path)
+{
+  GSubprocessLauncher *launcher = g_subprocess_launcher_new (flags);
+  g_subprocess_launcher_setenv (launcher, "BOOMERANG_TRACE_FILE", trace_path, TRUE);
+  g_subprocess_launcher_setenv (launcher, "GSETTINGS_BACKEND", "memory", TRUE);
+  g_subprocess_launcher_setenv (launcher, "GTK_A11Y", "none", TRUE);
+  if (display)
+    g_subprocess_launcher_setenv (launcher, "DISPLAY", display, TRUE);
+  if (wayland_display)
+    g_subprocess_launcher_setenv (launcher, "WAYLAND_DISPLAY", wayland_display, TRUE);
+  if (runtime_dir)
+    g_subprocess_launcher_setenv (launcher, "XDG_RUNTIME_DIR", runtime_dir, TRUE);
+  return launcher;
+}
+
+static void
+test_activation_latency (gconstpointer data)
+{
+  const Resolution *resolution = data;
+
+  GSubprocess *portal = test_mock_portal_start (resolution->width, resolution->height, CAPTURE_DELAY,
+                                                TEST_PORTAL_SUCCESS);
+
+  g_autofree char *trace_path = g_build_filename (g_get_user_cache_dir (), "trace.json", NULL);
+  g_autoptr (GSubprocessLauncher) launcher = boomerang_launcher_new (G_SUBPROCESS_FLAGS_NONE, trace_path);
+
+  /* the trace uses the monotonic clock, which is the same in every process */
+  GError *error = NULL;
+  gint64 start = g_get_monotonic_time ();
+  g_autoptr (GSubprocess) boomerang
+      = g_subprocess_launcher_spawn (launcher, &error, g_getenv ("BOOMERANG"), "--quit-after-first-frame", NULL);
+  g_assert_no_error (error);
+  g_subprocess_wait_check (boomerang, NULL, &error);
+  g_assert_no_error (error);
+
+  test_mock_portal_stop (portal);
+
+  g_autofree char *trace = NULL;
+  g_file_get_contents (trace_path, &trace, NULL, &error);
+  g_assert_no_error (error);
+
+  /* frames are traced as either render or snapshot spans depending on the renderer */
+  Span frame;
+  if (!trace_find_span (trace, "Render", start, &frame))
+    frame = trace_get_span (trace, "Snapshot", start);
+
+  Span activate = trace_get_span (trace, "Activate", start);
+  Span capture = trace_get_span (trace, "Portal request", start);
+  Span decode = trace_get_span (trace, "Decode", start);
+  Span upload = trace_get_span (trace, "Upload", start);
+
+  double measured[N_STAGES];
+  measured[STAGE_STARTUP] = activate.begin;
+  measured[STAGE_CAPTURE] = capture.end - capture.begin;
+  measured[STAGE_DECODE] = decode.end - decode.begin;
+  measured[STAGE_UPLOAD] = upload.end - upload.begin;
+  measured[STAGE_FIRST_FRAME] = frame.end;
+
+  for (Stage stage = 0; stage < N_STAGES; stage++)
+    {
+      g_key_file_set_double (results, resolution->name, stage_names[stage], measured[stage]);
+
+      error = NULL;
+      double threshold = g_key_file_get_double (thresholds, resolution->name, stage_names[stage], &error);
+      g_assert_no_error (error);
+
+      g_test_message ("%s %s: %.1f ms, threshold %.1f ms", resolution->name, stage_names[stage], measured[stage],
+                      threshold);
+      if (measured[stage] > threshold)
+        g_test_fail_printf ("%s took %.1f ms, more than the threshold of %.1f ms", stage_names[stage], measured[stage],
+                            threshold);
+    }
+}
+
+static void
+test_activation_portal_failed (void)
+{
+  GSubprocess *portal = test_mock_portal_start (640, 360, 0, TEST_PORTAL_FAILED);
+
+  g_autofree char *trace_path = g_build_filename (g_get_user_cache_dir (), "trace.json", NULL);
+  g_autoptr (GSubprocessLauncher) launcher = boomerang_launcher_new (G_SUBPROCESS_FLAGS_STDERR_PIPE, trace_path);
+
+  /* the error is reported and boomerang exits without showing a window */
+  GError *error = NULL;
+  g_autoptr (GSubprocess) boomerang = g_subprocess_launcher_spawn (launcher, &error, g_getenv ("BOOMERANG"), NULL);
+  g_assert_no_error (error);
+
+  g_autofree char *errors = NULL;
+  g_subprocess_communicate_utf8 (boomerang, NULL, NULL, NULL, &errors, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (g_subprocess_get_exit_status (boomerang), ==, 1);
+  g_assert_nonnull (strstr (errors, "Failed to take screenshot"));
+
+  test_mock_portal_stop (portal);
+}
+
+/* the canvas is realized, draws the screenshot and is unrealized again when boomerang quits, with any critical
+ * warning along the way being fatal */
+static void
+test_activation_renderer (gconstpointer data)
+{
+  const char *renderer = data;
+
+  GSubprocess *portal = test_mock_portal_start (640, 360, 0, TEST_PORTAL_SUCCESS);
+
+  g_autofree char *trace_path = g_build_filename (g_get_user_cache_dir (), "trace.json", NULL);
+  g_autoptr (GSubprocessLauncher) launcher = boomerang_launcher_new (G_SUBPROCESS_FLAGS_NONE, trace_path);
+  g_subprocess_launcher_setenv (launcher, "G_DEBUG", "fatal-criticals", TRUE);
+
+  GError *error = NULL;
+  g_autofree char *renderer_arg = g_strdup_printf ("--renderer=%s", renderer);
+  gint64 start = g_get_monotonic_time ();
+  g_autoptr (GSubprocess) boomerang = g_subprocess_launcher_spawn (launcher, &error, g_getenv ("BOOMERANG"),
+                                                                   renderer_arg, "--quit-after-first-frame", NULL);
+  g_assert_no_error (error);
+  g_subprocess_wait_check (boomerang, NULL, &error);
+  g_assert_no_error (error);
+
+  test_mock_portal_stop (portal);
+
+  g_autofree char *trace = NULL;
+  g_file_get_contents (trace_path, &trace, NULL, &error);
+  g_assert_no_error (error);
+
+  Span realize = trace_get_span (trace, "Realize", start);
+  Span frame = trace_get_span (trace, g_str_equal (renderer, "gsk") ? "Snapshot" : "Render", start);
+  Span unrealize = trace_get_span (trace, "Unrealize", start);
+  g_assert_cmpfloat (realize.end, <=, frame.begin);
+  g_assert_cmpfloat (frame.end, <=, unrealize.begin);
+
+  /* only the time taken to draw, or describe, the frame is measured, which is enough to compare the renderers */
+  g_key_file_set_double (results, "renderer", renderer, frame.end - frame.begin);
+  g_test_message ("%s first frame: %.1f ms", renderer, frame.end - frame.begin);
+}
+
+static gboolean
+remote_call (GDBusConnection *conn, const char *method, GVariant *args, GError **error)
+{
+  g_autoptr (GVariant) ret_val
+      = g_dbus_connection_call_sync (conn, APPLICATION_BUS, APPLICATION_PATH, REMOTE_INTERFACE, method, args,
+                                     G_VARIANT_TYPE_UNIT, G_DBUS_CALL_FLAGS_NO_AUTO_START, -1, NULL, error);
+  return ret_val != NULL;
+}
+
+static void
+test_activation_remote_control (void)
+{
+  GSubprocess *portal = test_mock_portal_start (640, 360, 0, TEST_PORTAL_SUCCESS);
+
+  g_autofree char *trace_path = g_build_filename (g_get_user_cache_dir (), "trace.json", NULL);
+  g_autoptr (GSubprocessLauncher) launcher = boomerang_launcher_new (G_SUBPROCESS_FLAGS_NONE, trace_path);
+
+  GError *error = NULL;
+  g_autoptr (GSubprocess) boomerang = g_subprocess_launcher_spawn (launcher, &error, g_getenv ("BOOMERANG"), NULL);
+  g_assert_no_error (error);
+
+  g_autoptr (GDBusConnection) conn = g_bus_get_sync (G_BUS_TYPE_SESSION, NULL, &error);
+  g_assert_no_error (error);
+
+  /* commands that move the view are refused until there is a screenshot to move it across */
+  gint64 deadline = g_get_monotonic_time () + REMOTE_TIMEOUT * G_USEC_PER_SEC;
+  while (!remote_call (conn, "ZoomTo", g_variant_new ("((iiii)d)", 160, 90, 320, 180, 0.0), &error))
+    {
+      if (!g_error_matches (error, G_DBUS_ERROR, G_DBUS_ERROR_NAME_HAS_NO_OWNER)
+          && !g_error_matches (error, G_DBUS_ERROR, G_DBUS_ERROR_SERVICE_UNKNOWN))
+        g_assert_error (error, G_DBUS_ERROR, G_DBUS_ERROR_FAILED);
+      g_clear_error (&error);
+
+      g_assert_cmpint (g_get_monotonic_time (), <, deadline);
+      g_assert_nonnull (g_subprocess_get_identifier (boomerang));
+      g_usleep (10 * 1000);
+    }
+
+  remote_call (conn, "Pan", g_variant_new ("(ddd)", 10.0, -10.0, 0.0), &error);
+  g_assert_no_error (error);
+  remote_call (conn, "SetFlashlight", g_variant_new ("(dddd)", 320.0, 180.0, 50.0, 0.0), &error);
+  g_assert_no_error (error);
+
+  remote_call (conn, "Batch",
+               g_variant_new_parsed ("([('ZoomTo', <((0, 0, 640, 360), 0.0)>), ('Pan', <(-10.0, 10.0, 0.0)>),"
+                                     " ('SetFlashlight', <(0.0, 0.0, 0.0, 0.0)>)],)"),
+               &error);
+  g_assert_no_error (error);
+
+  /* a batch with any command that is wrong is refused as a whole, so the commands before it are not applied either */
+  remote_call (conn, "Batch",
+               g_variant_new_parsed ("([('ZoomTo', <((0, 0, 10, 10), 0.0)>), ('Pan', <(1.0, 2.0)>)],)"), &error);
+  g_assert_error (error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS);
+  g_clear_error (&error);
+
+  remote_call (conn, "Batch",
+               g_variant_new_parsed ("([('SetFlashlight', <(1.0, 1.0, 1.0, 0.0)>), ('Explode', <()>)],)"), &error);
+  g_assert_error (error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD);
+  g_clear_error (&error);
+
+  g_usleep (REMOTE_SETTLE * 1000);
+
+  /* no reply is waited for, since boomerang may be gone before it sends one */
+  g_dbus_connection_call (conn, APPLICATION_BUS, APPLICATION_PATH, "org.gtk.Actions", "Activate",
+                          g_variant_new ("(sava{sv})", "quit", NULL, NULL), NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+                          NULL, NULL);
+  g_dbus_connection_flush_sync (conn, NULL, &error);
+  g_assert_no_error (error);
+  g_subprocess_wait_check (boomerang, NULL, &error);
+  g_assert_no_error (error);
+
+  test_mock_portal_stop (portal);
+
+  g_autofree char *trace = NULL;
+  g_file_get_contents (trace_path, &trace, NULL, &error);
+  g_assert_no_error (error);
+
+  /* each command accepted is applied once, alone or in a batch, and none from the refused batches */
+  g_assert_cmpuint (trace_count_spans (trace, "Remote command", "ZoomTo"), ==, 2);
+  g_assert_cmpuint (trace_count_spans (trace, "Remote command", "Pan"), ==, 2);
+  g_assert_cmpuint (trace_count_spans (trace, "Remote command", "SetFlashlight"), ==, 2);
+}
+
+/* starts weston or mutter without any outputs of their own, large enough to show the biggest resolution tested,
+ * returning FALSE if neither is installed */
+static gboolean
+headless_compositor_start (void)
+{
+  const Resolution *largest = &resolutions[G_N_ELEMENTS (resolutions) - 1];
+  g_autofree char *width_arg = g_strdup_printf ("--width=%d", largest->width);
+  g_autofree char *height_arg = g_strdup_printf ("--height=%d", largest->height);
+  g_autofree char *monitor_arg = g_strdup_printf ("--virtual-monitor=%dx%d", largest->width, largest->height);
+
+  g_autofree char *weston = g_find_program_in_path ("weston");
+  g_autofree char *mutter = g_find_program_in_path ("mutter");
+  const char *weston_argv[] = { weston, "--backend=headless", "--no-config", "--idle-time=0",
+                                "--socket=" HEADLESS_SOCKET, width_arg, height_arg, NULL };
+  const char *mutter_argv[] = { mutter, "--headless", "--wayland", "--no-x11", "--wayland-display=" HEADLESS_SOCKET,
+                                monitor_arg, NULL };
+  const char *const *compositor_argv = weston ? weston_argv : mutter ? mutter_argv : NULL;
+  if (!compositor_argv)
+    return FALSE;
+
+  /* the socket is made in the runtime directory, which continuous integration often does not have */
+  GError *error = NULL;
+  if (!runtime_dir)
+    {
+      headless_runtime_dir = g_dir_make_tmp ("boomerang-runtime-XXXXXX", &error);
+      g_assert_no_error (error);
+      runtime_dir = g_strdup (headless_runtime_dir);
+    }
+
+  g_autoptr (GSubprocessLauncher) launcher
+      = g_subprocess_launcher_new (G_SUBPROCESS_FLAGS_STDOUT_SILENCE | G_SUBPROCESS_FLAGS_STDERR_SILENCE);
+  g_subprocess_launcher_setenv (launcher, "XDG_RUNTIME_DIR", runtime_dir, TRUE);
+  g_subprocess_launcher_unsetenv (launcher, "WAYLAND_DISPLAY");
+  g_subprocess_launcher_unsetenv (launcher, "DISPLAY");
+  compositor = g_subprocess_launcher_spawnv (launcher, compositor_argv, &error);
+  g_assert_no_error (error);
+
+  g_autofree char *socket = g_build_filename (runtime_dir, HEADLESS_SOCKET, NULL);
+  gint64 deadline = g_get_monotonic_time () + HEADLESS_TIMEOUT * G_USEC_PER_SEC;
+  while (!g_file_test (socket, G_FILE_TEST_EXISTS))
+    {
+      if (g_get_monotonic_time () > deadline || !g_subprocess_get_identifier (compositor))
+        g_error ("%s did not start", compositor_argv[0]);
+      g_usleep (10 * 1000);
+    }
+
+  g_test_message ("Running on a headless %s", compositor_argv[0]);
+  wayland_display = g_strdup (HEADLESS_SOCKET);
+  return TRUE;
+}
+
+static void
+headless_compositor_stop (void)
+{
+  if (!compositor)
+    return;
+
+  g_subprocess_send_signal (compositor, SIGTERM);
+  g_subprocess_wait (compositor, NULL, NULL);
+  g_clear_object (&compositor);
+
+  /* the compositor removes its own socket, leaving the directory empty */
+  if (headless_runtime_dir)
+    g_rmdir (headless_runtime_dir);
+  g_clear_pointer (&headless_runtime_dir, g_free);
+}
+
+int
+main (int argc, char *argv[])
+{
+  display = g_strdup (g_getenv ("DISPLAY"));
+  wayland_display = g_strdup (g_getenv ("WAYLAND_DISPLAY"));
+  runtime_dir = g_strdup (g_getenv ("XDG_RUNTIME_DIR"));
+
+  g_test_init (&argc, &argv, G_TEST_OPTION_ISOLATE_DIRS, NULL);
+
+  /* thresholds may be replaced by ones measured on a particular machine, and the measurements saved for that */
+  GError *error = NULL;
+  thresholds = g_key_file_new ();
+  const char *thresholds_path = g_getenv ("BOOMERANG_LATENCY_THRESHOLDS");
+  g_autofree char *default_path = g_test_build_filename (G_TEST_DIST, "latency-thresholds.ini", NULL);
+  if (!g_key_file_load_from_file (thresholds, thresholds_path ? thresholds_path : default_path, G_KEY_FILE_NONE,
+                                  &error))
+    g_error ("Unable to load latency thresholds: %s", error->message);
+  results = g_key_file_new ();
+
+  GTestDBus *bus = g_test_dbus_new (G_TEST_DBUS_NONE);
+  g_test_dbus_up (bus);
+
+  /* boomerang needs a display to show the screenshot on, so without one a headless compositor is started on the
+   * private bus, and the whole suite is only skipped when there is none installed */
+  if (!display && !wayland_display && !headless_compositor_start ())
+    {
+      g_print ("1..0 # SKIP no display to run boomerang on, and neither weston nor mutter is installed\n");
+      g_test_dbus_down (bus);
+      g_object_unref (bus);
+      return 77;
+    }
+
+  for (guint i = 0; i < G_N_ELEMENTS (resolutions); i++)
+    {
+      g_autofree char *path = g_strdup_printf ("/activation/latency/%s", resolutions[i].name);
+      g_test_add_data_func (path, &resolutions[i], test_activation_latency);
+    }
+  for (guint i = 0; i < G_N_ELEMENTS (renderers); i++)
+    {
+      g_autofree char *path = g_strdup_printf ("/activation/renderer/%s", renderers[i]);
+      g_test_add_data_func (path, renderers[i], test_activation_renderer);
+    }
+  g_test_add_func ("/activation/portal-failed", test_activation_portal_failed);
+  g_test_add_func ("/activation/remote-control", test_activation_remote_control);
+
+  int status = g_test_run ();
+
+  headless_compositor_stop ();
+  g_test_dbus_down (bus);
+  g_object_unref (bus);
+
+  const char *results_path = g_getenv ("BOOMERANG_LATENCY_RESULTS");
+  if (results_path && !g_key_file_save_to_file (results, results_path, &error))
+    g_error ("Unable to save latency results: %s", error->message);
+
+  g_key_file_free (results);
+  g_key_file_free (thresholds);
+  g_free (runtime_dir);
+  g_free (wayland_display);
+  g_free (display);
+  return status;
+}
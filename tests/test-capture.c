@@ -0,0 +1,278 @@
+/* Copyright 2026 Mat Booth
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "boomerang-screenshot.h"
+#include "test-util.h"
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+/* width and height of the images answered by the mock portal, kept small since decoding is not what is tested here */
+#define WIDTH 640
+#define HEIGHT 360
+
+/* the mock shell answers with images of a different size, to tell which backend took the screenshot */
+#define SHELL_WIDTH 320
+#define SHELL_HEIGHT 180
+
+/* the longest a cancelled capture may take to return, in milliseconds, while the portal would take much longer */
+#define CANCEL_LATENCY 1000
+#define CANCEL_DELAY 30000
+
+typedef struct
+{
+  BoomerangScreenshot *screenshot;
+  GMainLoop *loop;
+  char *uri;
+  GError *error;
+} Capture;
+
+static void
+capture_cb (GObject *source, GAsyncResult *result, gpointer data)
+{
+  Capture *capture = data;
+  capture->uri = boomerang_screenshot_finish (BOOMERANG_SCREENSHOT (source), result, NULL, &capture->error);
+  g_main_loop_quit (capture->loop);
+}
+
+static void
+capture_run (Capture *capture, GCancellable *cancellable)
+{
+  /* the screenshot is kept until the capture is cleared, since it deletes any temporary files it made, and is used
+   * again if the capture is run again before then */
+  if (!capture->screenshot)
+    capture->screenshot = g_object_new (BOOMERANG_TYPE_SCREENSHOT, NULL);
+  if (!capture->loop)
+    capture->loop = g_main_loop_new (NULL, FALSE);
+  g_clear_pointer (&capture->uri, g_free);
+  g_clear_error (&capture->error);
+  boomerang_screenshot_take (capture->screenshot, cancellable, capture_cb, capture);
+  g_main_loop_run (capture->loop);
+}
+
+static void
+capture_clear (Capture *capture)
+{
+  g_clear_object (&capture->screenshot);
+  g_clear_pointer (&capture->loop, g_main_loop_unref);
+  g_clear_pointer (&capture->uri, g_free);
+  g_clear_error (&capture->error);
+}
+
+static void
+assert_captured (Capture *capture, int width, int height)
+{
+  g_assert_no_error (capture->error);
+  g_assert_nonnull (capture->uri);
+
+  GError *error = NULL;
+  g_autofree char *filename = g_filename_from_uri (capture->uri, NULL, &error);
+  g_assert_no_error (error);
+  g_autoptr (GdkPixbuf) pixbuf = gdk_pixbuf_new_from_file (filename, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (gdk_pixbuf_get_width (pixbuf), ==, width);
+  g_assert_cmpint (gdk_pixbuf_get_height (pixbuf), ==, height);
+}
+
+static void
+test_capture_success (void)
+{
+  GSubprocess *portal = test_mock_portal_start (WIDTH, HEIGHT, 0, TEST_PORTAL_SUCCESS);
+
+  Capture capture = { 0 };
+  capture_run (&capture, NULL);
+  assert_captured (&capture, WIDTH, HEIGHT);
+
+  capture_clear (&capture);
+  test_mock_portal_stop (portal);
+}
+
+static void
+test_capture_declined (void)
+{
+  GSubprocess *portal = test_mock_portal_start (WIDTH, HEIGHT, 0, TEST_PORTAL_CANCELLED);
+
+  /* the user declining is reported as a cancellation, and no other backend is tried */
+  Capture capture = { 0 };
+  capture_run (&capture, NULL);
+  g_assert_error (capture.error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+  g_assert_null (capture.uri);
+
+  capture_clear (&capture);
+  test_mock_portal_stop (portal);
+}
+
+static void
+test_capture_failed (void)
+{
+  GSubprocess *portal = test_mock_portal_start (WIDTH, HEIGHT, 0, TEST_PORTAL_FAILED);
+
+  Capture capture = { 0 };
+  capture_run (&capture, NULL);
+  g_assert_error (capture.error, G_IO_ERROR, G_IO_ERROR_FAILED);
+  g_assert_null (capture.uri);
+
+  capture_clear (&capture);
+  test_mock_portal_stop (portal);
+}
+
+static gboolean
+cancel_cb (gpointer data)
+{
+  g_cancellable_cancel (data);
+  return G_SOURCE_REMOVE;
+}
+
+static void
+test_capture_cancelled (void)
+{
+  GSubprocess *portal = test_mock_portal_start (WIDTH, HEIGHT, CANCEL_DELAY, TEST_PORTAL_SUCCESS);
+
+  /* cancelling while the portal is still working on the request returns straight away and closes the request */
+  g_autoptr (GCancellable) cancellable = g_cancellable_new ();
+  g_timeout_add (100, cancel_cb, cancellable);
+
+  Capture capture = { 0 };
+  gint64 start = g_get_monotonic_time ();
+  capture_run (&capture, cancellable);
+  gint64 elapsed = (g_get_monotonic_time () - start) / 1000;
+  g_assert_error (capture.error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+  g_assert_null (capture.uri);
+  g_assert_cmpint (elapsed, <, CANCEL_LATENCY);
+
+  /* the close call is not waited for, so give it time to arrive */
+  gint64 deadline = g_get_monotonic_time () + CANCEL_LATENCY * 1000;
+  while (test_mock_portal_get_closed () == 0 && g_get_monotonic_time () < deadline)
+    g_usleep (10 * 1000);
+  g_assert_cmpuint (test_mock_portal_get_closed (), ==, 1);
+
+  capture_clear (&capture);
+  test_mock_portal_stop (portal);
+}
+
+static void
+test_capture_fallback (void)
+{
+  GSubprocess *portal = test_mock_portal_start (WIDTH, HEIGHT, 0, TEST_PORTAL_FAILED);
+  GSubprocess *shell = test_mock_shell_start (SHELL_WIDTH, SHELL_HEIGHT);
+
+  /* a portal failure, unlike the user declining, falls through to the next backend */
+  Capture capture = { 0 };
+  capture_run (&capture, NULL);
+  assert_captured (&capture, SHELL_WIDTH, SHELL_HEIGHT);
+
+  capture_clear (&capture);
+  test_mock_shell_stop (shell);
+  test_mock_portal_stop (portal);
+}
+
+static void
+test_capture_sampled (void)
+{
+  GSubprocess *portal = test_mock_portal_start (WIDTH, HEIGHT, 0, TEST_PORTAL_SUCCESS);
+  GSubprocess *shell = test_mock_shell_start (SHELL_WIDTH, SHELL_HEIGHT);
+
+  /* the portal is tried first when nothing has been measured, and the shell the next time it is started, since it
+   * has no latency to compare against until it has been used */
+  Capture capture = { 0 };
+  capture_run (&capture, NULL);
+  assert_captured (&capture, WIDTH, HEIGHT);
+  capture_clear (&capture);
+
+  capture_run (&capture, NULL);
+  assert_captured (&capture, SHELL_WIDTH, SHELL_HEIGHT);
+  capture_clear (&capture);
+
+  test_mock_shell_stop (shell);
+  test_mock_portal_stop (portal);
+}
+
+static void
+test_capture_no_portal (void)
+{
+  /* with nothing on the bus to take a screenshot, every backend fails to probe */
+  Capture capture = { 0 };
+  capture_run (&capture, NULL);
+  g_assert_error (capture.error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED);
+  g_assert_null (capture.uri);
+
+  capture_clear (&capture);
+}
+
+static void
+test_capture_probe_again (void)
+{
+  /* nothing is found the first time, so the backends are probed again for the next screenshot */
+  Capture capture = { 0 };
+  capture_run (&capture, NULL);
+  g_assert_error (capture.error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED);
+
+  GSubprocess *portal = test_mock_portal_start (WIDTH, HEIGHT, 0, TEST_PORTAL_SUCCESS);
+  capture_run (&capture, NULL);
+  assert_captured (&capture, WIDTH, HEIGHT);
+
+  capture_clear (&capture);
+  test_mock_portal_stop (portal);
+}
+
+static void
+test_capture_probe_cancelled (void)
+{
+  GSubprocess *portal = test_mock_portal_start (WIDTH, HEIGHT, 0, TEST_PORTAL_SUCCESS);
+
+  /* cancelling while the backends are being probed is reported as a cancellation, and does not stop the next
+   * screenshot from probing them again */
+  g_autoptr (GCancellable) cancellable = g_cancellable_new ();
+  g_cancellable_cancel (cancellable);
+
+  Capture capture = { 0 };
+  capture_run (&capture, cancellable);
+  g_assert_error (capture.error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+  g_assert_null (capture.uri);
+
+  capture_run (&capture, NULL);
+  assert_captured (&capture, WIDTH, HEIGHT);
+
+  capture_clear (&capture);
+  test_mock_portal_stop (portal);
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, G_TEST_OPTION_ISOLATE_DIRS, NULL);
+
+  /* everything talks to a private session bus, on which the mock portal is the only screenshot service */
+  GTestDBus *bus = g_test_dbus_new (G_TEST_DBUS_NONE);
+  g_test_dbus_up (bus);
+
+  g_test_add_func ("/capture/portal/success", test_capture_success);
+  g_test_add_func ("/capture/portal/declined", test_capture_declined);
+  g_test_add_func ("/capture/portal/failed", test_capture_failed);
+  g_test_add_func ("/capture/portal/cancelled", test_capture_cancelled);
+  g_test_add_func ("/capture/shell/fallback", test_capture_fallback);
+  g_test_add_func ("/capture/shell/sampled", test_capture_sampled);
+  g_test_add_func ("/capture/no-portal", test_capture_no_portal);
+  g_test_add_func ("/capture/probe/again", test_capture_probe_again);
+  g_test_add_func ("/capture/probe/cancelled", test_capture_probe_cancelled);
+
+  int status = g_test_run ();
+
+  g_test_dbus_down (bus);
+  g_object_unref (bus);
+  return status;
+}
@@ -0,0 +1,126 @@
+/* Copyright 2026 Mat Booth
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "boomerang-convert.h"
+
+#include <string.h>
+
+/* every width up to this is converted, so that each kernel is left with every possible number of pixels at the end
+ * of a row for its scalar tail */
+#define MAX_WIDTH 67
+
+/* rows converted for each width, with the source and destination rows padded by these many bytes, keeping the
+ * sixteen bit components aligned while leaving the wider loads unaligned */
+#define HEIGHT 3
+#define SRC_PADDING 6
+#define DEST_PADDING 12
+
+/* destination bytes that a conversion must not write */
+#define CANARY 0xa5
+
+typedef struct
+{
+  BoomerangPixelFormat format;
+  const char *name;
+  int bytes_per_pixel;
+} Format;
+
+static const Format formats[] = {
+  { BOOMERANG_PIXEL_FORMAT_RGB8, "rgb8", 3 },     { BOOMERANG_PIXEL_FORMAT_RGBA8, "rgba8", 4 },
+  { BOOMERANG_PIXEL_FORMAT_BGRX8, "bgrx8", 4 },   { BOOMERANG_PIXEL_FORMAT_BGRA8, "bgra8", 4 },
+  { BOOMERANG_PIXEL_FORMAT_RGBA16, "rgba16", 8 },
+};
+
+static const BoomerangConvertKernel kernels[] = {
+  BOOMERANG_CONVERT_KERNEL_SSSE3,
+  BOOMERANG_CONVERT_KERNEL_AVX2,
+  BOOMERANG_CONVERT_KERNEL_NEON,
+};
+
+typedef struct
+{
+  BoomerangConvertKernel kernel;
+  const Format *format;
+} TestData;
+
+/* converts with the given kernel into a buffer filled with the canary */
+static guint8 *
+convert (BoomerangConvertKernel kernel, const Format *format, const guint8 *src, int width)
+{
+  gsize src_stride = (gsize)width * format->bytes_per_pixel + SRC_PADDING;
+  gsize dest_stride = (gsize)width * 4 + DEST_PADDING;
+  guint8 *dest = g_malloc (dest_stride * HEIGHT);
+  memset (dest, CANARY, dest_stride * HEIGHT);
+
+  boomerang_convert_set_kernel (kernel);
+  boomerang_convert_rows (format->format, src, src_stride, dest, dest_stride, width, HEIGHT);
+  return dest;
+}
+
+static void
+test_convert_kernel (gconstpointer data)
+{
+  const TestData *test = data;
+  if (!boomerang_convert_kernel_supported (test->kernel))
+    {
+      g_test_skip ("Not supported on this processor");
+      return;
+    }
+
+  for (int width = 1; width <= MAX_WIDTH; width++)
+    {
+      /* the last row is not padded, so that a load past the end of it reads past the end of the buffer, where a
+       * memory checker will see it */
+      gsize src_stride = (gsize)width * test->format->bytes_per_pixel + SRC_PADDING;
+      gsize src_size = src_stride * (HEIGHT - 1) + (gsize)width * test->format->bytes_per_pixel;
+      guint8 *src = g_malloc (src_size);
+      for (gsize i = 0; i < src_size; i++)
+        src[i] = i * 7 + (i >> 5);
+
+      guint8 *expected = convert (BOOMERANG_CONVERT_KERNEL_SCALAR, test->format, src, width);
+      guint8 *actual = convert (test->kernel, test->format, src, width);
+
+      /* the padding is compared too, so that writing past the end of a row fails */
+      gsize dest_size = ((gsize)width * 4 + DEST_PADDING) * HEIGHT;
+      g_assert_cmpmem (actual, dest_size, expected, dest_size);
+
+      g_free (actual);
+      g_free (expected);
+      g_free (src);
+    }
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  for (guint k = 0; k < G_N_ELEMENTS (kernels); k++)
+    for (guint f = 0; f < G_N_ELEMENTS (formats); f++)
+      {
+        TestData *test = g_new (TestData, 1);
+        test->kernel = kernels[k];
+        test->format = &formats[f];
+
+        g_autofree char *path = g_strdup_printf ("/convert/%s/%s", boomerang_convert_kernel_name (kernels[k]),
+                                                 formats[f].name);
+        g_test_add_data_func_full (path, test, test_convert_kernel, g_free);
+      }
+
+  return g_test_run ();
+}
@@ -0,0 +1,265 @@
+/* Copyright 2026 Mat Booth
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "boomerang-qoi.h"
+
+/* images are written in bands of this many rows, the tests use heights that leave a partial band at the end */
+#define BAND_ROWS 64
+
+/* the trailer after the band table holds the number of bands, the rows in each band and a magic */
+#define TRAILER_SIZE 12
+
+static void
+write_be32 (guint8 *p, guint32 v)
+{
+  p[0] = v >> 24;
+  p[1] = v >> 16;
+  p[2] = v >> 8;
+  p[3] = v;
+}
+
+/* paints flat areas, gradients and noise, so that every kind of op is written, and varies the alpha if there is one */
+static GdkPixbuf *
+create_image (int width, int height, gboolean alpha)
+{
+  GdkPixbuf *pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, alpha, 8, width, height);
+  int channels = gdk_pixbuf_get_n_channels (pixbuf);
+  int stride = gdk_pixbuf_get_rowstride (pixbuf);
+  guchar *pixels = gdk_pixbuf_get_pixels (pixbuf);
+  GRand *rand = g_rand_new_with_seed (42);
+
+  for (int y = 0; y < height; y++)
+    {
+      guchar *p = pixels + (gsize)y * stride;
+      for (int x = 0; x < width; x++, p += channels)
+        {
+          switch ((x / 16 + y / 16) % 4)
+            {
+            case 0:
+              p[0] = p[1] = p[2] = 0xf6;
+              break;
+            case 1:
+              p[0] = x;
+              p[1] = y;
+              p[2] = x + y;
+              break;
+            case 2:
+              p[0] = p[1] = p[2] = g_rand_int_range (rand, 0, 256);
+              break;
+            default:
+              p[0] = g_rand_int_range (rand, 0, 256);
+              p[1] = g_rand_int_range (rand, 0, 256);
+              p[2] = g_rand_int_range (rand, 0, 256);
+              break;
+            }
+          if (alpha)
+            p[3] = y % 3 == 0 ? 0xff : x * 4;
+        }
+    }
+
+  g_rand_free (rand);
+  return pixbuf;
+}
+
+static void
+assert_same_pixels (GdkPixbuf *expected, GdkPixbuf *actual)
+{
+  int width = gdk_pixbuf_get_width (expected);
+  int height = gdk_pixbuf_get_height (expected);
+  int channels = gdk_pixbuf_get_n_channels (expected);
+  g_assert_cmpint (gdk_pixbuf_get_width (actual), ==, width);
+  g_assert_cmpint (gdk_pixbuf_get_height (actual), ==, height);
+  g_assert_cmpint (gdk_pixbuf_get_n_channels (actual), ==, channels);
+
+  /* rows are compared without the padding at the end of each, which is never written */
+  const guint8 *e = gdk_pixbuf_read_pixels (expected);
+  const guint8 *a = gdk_pixbuf_read_pixels (actual);
+  for (int y = 0; y < height; y++)
+    g_assert_cmpmem (e + (gsize)y * gdk_pixbuf_get_rowstride (expected), (gsize)width * channels,
+                     a + (gsize)y * gdk_pixbuf_get_rowstride (actual), (gsize)width * channels);
+}
+
+static void
+assert_round_trip (int width, int height, gboolean alpha)
+{
+  g_autoptr (GdkPixbuf) pixbuf = create_image (width, height, alpha);
+  g_autoptr (GBytes) bytes = boomerang_qoi_encode (pixbuf);
+  g_assert_true (boomerang_qoi_check (bytes));
+
+  GError *error = NULL;
+  g_autoptr (GdkPixbuf) decoded = boomerang_qoi_decode (bytes, &error);
+  g_assert_no_error (error);
+  assert_same_pixels (pixbuf, decoded);
+}
+
+static void
+test_qoi_round_trip_rgb (void)
+{
+  assert_round_trip (67, BAND_ROWS * 2 + 5, FALSE);
+  assert_round_trip (1, BAND_ROWS - 1, FALSE);
+}
+
+static void
+test_qoi_round_trip_rgba (void)
+{
+  assert_round_trip (67, BAND_ROWS * 2 + 5, TRUE);
+  assert_round_trip (3, 1, TRUE);
+}
+
+/* a 2x2 image written by hand the way any other encoder would, with no band table after the end marker */
+static void
+test_qoi_plain (void)
+{
+  static const guint8 data[] = {
+    'q', 'o', 'i', 'f', 0, 0, 0, 2, 0, 0, 0, 2, 4, 0,
+    0xff, 10, 20, 30, 40, /* rgba */
+    0xc0,                 /* run of one */
+    0xfe, 1, 2, 3,        /* rgb, keeping the alpha */
+    0x0c,                 /* index of the first pixel */
+    0, 0, 0, 0, 0, 0, 0, 1,
+  };
+  static const guint8 expected[] = { 10, 20, 30, 40, 10, 20, 30, 40, 1, 2, 3, 40, 10, 20, 30, 40 };
+
+  g_autoptr (GBytes) bytes = g_bytes_new_static (data, sizeof (data));
+  GError *error = NULL;
+  g_autoptr (GdkPixbuf) decoded = boomerang_qoi_decode (bytes, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (gdk_pixbuf_get_width (decoded), ==, 2);
+  g_assert_cmpint (gdk_pixbuf_get_height (decoded), ==, 2);
+
+  const guint8 *pixels = gdk_pixbuf_read_pixels (decoded);
+  int stride = gdk_pixbuf_get_rowstride (decoded);
+  g_assert_cmpmem (pixels, 8, expected, 8);
+  g_assert_cmpmem (pixels + stride, 8, expected + 8, 8);
+}
+
+/* the bands are also a valid qoi stream when read from start to finish, as a decoder without band support would */
+static void
+test_qoi_without_table (void)
+{
+  g_autoptr (GdkPixbuf) pixbuf = create_image (67, BAND_ROWS * 2 + 5, FALSE);
+  g_autoptr (GBytes) bytes = boomerang_qoi_encode (pixbuf);
+
+  gsize size;
+  const guint8 *data = g_bytes_get_data (bytes, &size);
+  gsize n_bands = (BAND_ROWS * 2 + 5 + BAND_ROWS - 1) / BAND_ROWS;
+  g_autoptr (GBytes) plain = g_bytes_new (data, size - n_bands * 8 - TRAILER_SIZE);
+
+  GError *error = NULL;
+  g_autoptr (GdkPixbuf) decoded = boomerang_qoi_decode (plain, &error);
+  g_assert_no_error (error);
+  assert_same_pixels (pixbuf, decoded);
+}
+
+typedef enum
+{
+  CORRUPT_HUGE_ROWS,
+  CORRUPT_NEGATIVE_ROWS,
+  CORRUPT_NO_ROWS,
+  CORRUPT_BAND_COUNT,
+  CORRUPT_FIRST_OFFSET,
+  CORRUPT_OFFSET_ORDER,
+  CORRUPT_MISSING_ENTRY,
+  CORRUPT_ONLY_TRAILER,
+  CORRUPT_TRUNCATED,
+} Corruption;
+
+static GBytes *
+corrupt (GBytes *bytes, Corruption corruption)
+{
+  gsize size;
+  const guint8 *data = g_bytes_get_data (bytes, &size);
+  guint8 *copy = g_memdup2 (data, size);
+  guint8 *trailer = copy + size - TRAILER_SIZE;
+  guint8 *table = trailer - 3 * 8;
+
+  switch (corruption)
+    {
+    case CORRUPT_HUGE_ROWS:
+      write_be32 (trailer, 0);
+      write_be32 (trailer + 4, 0xffffffff);
+      break;
+    case CORRUPT_NEGATIVE_ROWS:
+      write_be32 (trailer, 1);
+      write_be32 (trailer + 4, 0x80000000);
+      break;
+    case CORRUPT_NO_ROWS:
+      write_be32 (trailer + 4, 0);
+      break;
+    case CORRUPT_BAND_COUNT:
+      write_be32 (trailer, 2);
+      break;
+    case CORRUPT_FIRST_OFFSET:
+      write_be32 (table + 4, 0);
+      break;
+    case CORRUPT_OFFSET_ORDER:
+      write_be32 (table + 8 + 4, 0xffffff);
+      break;
+    case CORRUPT_MISSING_ENTRY:
+      /* drops the last entry of the table, leaving the trailer as it was */
+      memmove (table + 2 * 8, trailer, TRAILER_SIZE);
+      size -= 8;
+      break;
+    case CORRUPT_ONLY_TRAILER:
+      memmove (copy + 14, trailer, TRAILER_SIZE);
+      size = 14 + TRAILER_SIZE;
+      break;
+    case CORRUPT_TRUNCATED:
+      size /= 2;
+      break;
+    }
+
+  return g_bytes_new_take (copy, size);
+}
+
+static void
+test_qoi_corrupt (gconstpointer data)
+{
+  /* three bands, the last of them partial */
+  g_autoptr (GdkPixbuf) pixbuf = create_image (67, BAND_ROWS * 2 + 5, TRUE);
+  g_autoptr (GBytes) bytes = boomerang_qoi_encode (pixbuf);
+  g_autoptr (GBytes) corrupted = corrupt (bytes, GPOINTER_TO_INT (data));
+
+  GError *error = NULL;
+  g_autoptr (GdkPixbuf) decoded = boomerang_qoi_decode (corrupted, &error);
+  g_assert_error (error, GDK_PIXBUF_ERROR, GDK_PIXBUF_ERROR_CORRUPT_IMAGE);
+  g_assert_null (decoded);
+  g_error_free (error);
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/qoi/round-trip/rgb", test_qoi_round_trip_rgb);
+  g_test_add_func ("/qoi/round-trip/rgba", test_qoi_round_trip_rgba);
+  g_test_add_func ("/qoi/plain", test_qoi_plain);
+  g_test_add_func ("/qoi/without-table", test_qoi_without_table);
+  g_test_add_data_func ("/qoi/corrupt/huge-rows", GINT_TO_POINTER (CORRUPT_HUGE_ROWS), test_qoi_corrupt);
+  g_test_add_data_func ("/qoi/corrupt/negative-rows", GINT_TO_POINTER (CORRUPT_NEGATIVE_ROWS), test_qoi_corrupt);
+  g_test_add_data_func ("/qoi/corrupt/no-rows", GINT_TO_POINTER (CORRUPT_NO_ROWS), test_qoi_corrupt);
+  g_test_add_data_func ("/qoi/corrupt/band-count", GINT_TO_POINTER (CORRUPT_BAND_COUNT), test_qoi_corrupt);
+  g_test_add_data_func ("/qoi/corrupt/first-offset", GINT_TO_POINTER (CORRUPT_FIRST_OFFSET), test_qoi_corrupt);
+  g_test_add_data_func ("/qoi/corrupt/offset-order", GINT_TO_POINTER (CORRUPT_OFFSET_ORDER), test_qoi_corrupt);
+  g_test_add_data_func ("/qoi/corrupt/missing-entry", GINT_TO_POINTER (CORRUPT_MISSING_ENTRY), test_qoi_corrupt);
+  g_test_add_data_func ("/qoi/corrupt/only-trailer", GINT_TO_POINTER (CORRUPT_ONLY_TRAILER), test_qoi_corrupt);
+  g_test_add_data_func ("/qoi/corrupt/truncated", GINT_TO_POINTER (CORRUPT_TRUNCATED), test_qoi_corrupt);
+
+  return g_test_run ();
+}
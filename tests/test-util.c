@@ -0,0 +1,138 @@
+/* Copyright 2026 Mat Booth
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "test-util.h"
+
+#include <signal.h>
+
+#define PORTAL_BUS "org.freedesktop.portal.Desktop"
+#define PORTAL_PATH "/org/freedesktop/portal/desktop"
+#define SHELL_BUS "org.gnome.Shell.Screenshot"
+
+/* how long to wait for a mock service to appear on the bus, in seconds */
+#define STARTUP_TIMEOUT 10
+
+static gboolean
+name_has_owner (GDBusConnection *conn, const char *name)
+{
+  GError *error = NULL;
+  g_autoptr (GVariant) ret_val
+      = g_dbus_connection_call_sync (conn, "org.freedesktop.DBus", "/org/freedesktop/DBus", "org.freedesktop.DBus",
+                                     "NameHasOwner", g_variant_new ("(s)", name), G_VARIANT_TYPE ("(b)"),
+                                     G_DBUS_CALL_FLAGS_NONE, -1, NULL, &error);
+  g_assert_no_error (error);
+
+  gboolean has_owner;
+  g_variant_get (ret_val, "(b)", &has_owner);
+  return has_owner;
+}
+
+/* starts a mock service on the session bus, which must be the private bus of the test, and waits for it to own its
+ * name so that probing for it finds it */
+static GSubprocess *
+mock_service_start (const char *name, const char *const *argv)
+{
+  GError *error = NULL;
+  GSubprocess *service = g_subprocess_newv (argv, G_SUBPROCESS_FLAGS_NONE, &error);
+  g_assert_no_error (error);
+
+  g_autoptr (GDBusConnection) conn = g_bus_get_sync (G_BUS_TYPE_SESSION, NULL, &error);
+  g_assert_no_error (error);
+
+  gint64 deadline = g_get_monotonic_time () + STARTUP_TIMEOUT * G_USEC_PER_SEC;
+  while (!name_has_owner (conn, name))
+    {
+      g_assert_cmpint (g_get_monotonic_time (), <, deadline);
+      g_assert_nonnull (g_subprocess_get_identifier (service));
+      g_usleep (10 * 1000);
+    }
+
+  return service;
+}
+
+/* stops a mock service and waits for the bus to notice, so that the next test does not find it there */
+static void
+mock_service_stop (const char *name, GSubprocess *service)
+{
+  GError *error = NULL;
+  g_subprocess_send_signal (service, SIGTERM);
+  g_subprocess_wait_check (service, NULL, &error);
+  g_assert_no_error (error);
+  g_object_unref (service);
+
+  g_autoptr (GDBusConnection) conn = g_bus_get_sync (G_BUS_TYPE_SESSION, NULL, &error);
+  g_assert_no_error (error);
+  while (name_has_owner (conn, name))
+    g_usleep (10 * 1000);
+}
+
+/* starts the mock portal, which answers every request with the given response after the given delay */
+GSubprocess *
+test_mock_portal_start (int width, int height, int delay, int response)
+{
+  g_autofree char *path = g_test_build_filename (G_TEST_BUILT, "mock-portal", NULL);
+  g_autofree char *width_arg = g_strdup_printf ("--width=%d", width);
+  g_autofree char *height_arg = g_strdup_printf ("--height=%d", height);
+  g_autofree char *delay_arg = g_strdup_printf ("--delay=%d", delay);
+  g_autofree char *response_arg = g_strdup_printf ("--response=%d", response);
+
+  const char *argv[] = { path, width_arg, height_arg, delay_arg, response_arg, NULL };
+  return mock_service_start (PORTAL_BUS, argv);
+}
+
+/* returns how many requests the mock portal was asked to close before it responded to them */
+guint
+test_mock_portal_get_closed (void)
+{
+  GError *error = NULL;
+  g_autoptr (GDBusConnection) conn = g_bus_get_sync (G_BUS_TYPE_SESSION, NULL, &error);
+  g_assert_no_error (error);
+
+  g_autoptr (GVariant) ret_val = g_dbus_connection_call_sync (
+      conn, PORTAL_BUS, PORTAL_PATH, "uk.co.matbooth.Boomerang.MockPortal", "GetClosed", NULL, G_VARIANT_TYPE ("(u)"),
+      G_DBUS_CALL_FLAGS_NONE, -1, NULL, &error);
+  g_assert_no_error (error);
+
+  guint closed;
+  g_variant_get (ret_val, "(u)", &closed);
+  return closed;
+}
+
+void
+test_mock_portal_stop (GSubprocess *portal)
+{
+  mock_service_stop (PORTAL_BUS, portal);
+}
+
+/* starts the mock gnome shell screenshot service, which always succeeds with an image of the given size */
+GSubprocess *
+test_mock_shell_start (int width, int height)
+{
+  g_autofree char *path = g_test_build_filename (G_TEST_BUILT, "mock-shell", NULL);
+  g_autofree char *width_arg = g_strdup_printf ("--width=%d", width);
+  g_autofree char *height_arg = g_strdup_printf ("--height=%d", height);
+
+  const char *argv[] = { path, width_arg, height_arg, NULL };
+  return mock_service_start (SHELL_BUS, argv);
+}
+
+void
+test_mock_shell_stop (GSubprocess *shell)
+{
+  mock_service_stop (SHELL_BUS, shell);
+}
@@ -0,0 +1,46 @@
+/* Copyright 2026 Mat Booth
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef TEST_UTIL_H_
+#define TEST_UTIL_H_
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/* responses the portal may give, as documented for org.freedesktop.portal.Request */
+enum
+{
+  TEST_PORTAL_SUCCESS = 0,
+  TEST_PORTAL_CANCELLED = 1,
+  TEST_PORTAL_FAILED = 2,
+};
+
+GSubprocess *test_mock_portal_start (int width, int height, int delay, int response);
+
+guint test_mock_portal_get_closed (void);
+
+void test_mock_portal_stop (GSubprocess *portal);
+
+GSubprocess *test_mock_shell_start (int width, int height);
+
+void test_mock_shell_stop (GSubprocess *shell);
+
+G_END_DECLS
+
+#endif /* TEST_UTIL_H_ */